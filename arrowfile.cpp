@@ -0,0 +1,459 @@
+#include "arrowfile.h"
+
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+const char Magic[6] = {'A', 'R', 'R', 'O', 'W', '1'};
+const quint32 Continuation = 0xffffffff;
+
+// members of the Type union and the MessageHeader union of the arrow flatbuffer schema
+enum TypeId : quint8
+{
+    TypeNull = 1,
+    TypeInt = 2,
+    TypeFloatingPoint = 3,
+    TypeBinary = 4,
+    TypeUtf8 = 5,
+    TypeBool = 6,
+    TypeDecimal = 7,
+    TypeDate = 8,
+    TypeTime = 9,
+    TypeTimestamp = 10,
+    TypeInterval = 11,
+    TypeFixedSizeBinary = 15,
+    TypeDuration = 18,
+    TypeLargeBinary = 19,
+    TypeLargeUtf8 = 20
+};
+const quint8 MessageRecordBatch = 3;
+// the TimeUnit enum of the schema: seconds, milli-, micro- and nanoseconds
+const qint64 UnitsPerSecond[] = {1, 1000, 1000000, 1000000000};
+
+// a table of a flatbuffer in [begin, end), its fields are found through its vtable. Every read is
+// bounds checked, a damaged buffer throws instead of reading outside of it
+class FlatTable
+{
+public:
+    FlatTable() = default;
+    FlatTable(const uchar* begin, const uchar* end, qint64 position)
+        : begin(begin)
+        , size(end - begin)
+        , position(position)
+    {
+        vtable = position - read<qint32>(position);
+        vtableSize = read<quint16>(vtable);
+        if (vtableSize < 4 || vtable + vtableSize > size)
+            throw std::runtime_error("damaged metadata");
+    }
+
+    static FlatTable root(const uchar* begin, const uchar* end)
+    {
+        FlatTable buffer;
+        buffer.begin = begin;
+        buffer.size = end - begin;
+        return FlatTable(begin, end, buffer.read<quint32>(0));
+    }
+
+    bool isNull() const
+    {
+        return begin == nullptr;
+    }
+
+    template <class T>
+    T scalar(int field, T fallback) const
+    {
+        const qint64 offset = fieldOffset(field);
+        return offset ? read<T>(position + offset) : fallback;
+    }
+
+    FlatTable table(int field) const
+    {
+        const qint64 offset = fieldOffset(field);
+        if (offset == 0)
+            return FlatTable();
+        return FlatTable(begin, begin + size, position + offset + read<quint32>(position + offset));
+    }
+
+    // position of the first element of a vector field and its element count, 0 if it is absent
+    qint64 vector(int field, qint64 elementSize, qint64& count) const
+    {
+        const qint64 offset = fieldOffset(field);
+        count = 0;
+        if (offset == 0)
+            return 0;
+        const qint64 vector = position + offset + read<quint32>(position + offset);
+        count = read<quint32>(vector);
+        if (vector + 4 + count * elementSize > size)
+            throw std::runtime_error("damaged metadata");
+        return vector + 4;
+    }
+
+    // the table referenced by the vector element at position
+    FlatTable tableAt(qint64 position) const
+    {
+        return FlatTable(begin, begin + size, position + read<quint32>(position));
+    }
+
+    QString string(int field) const
+    {
+        qint64 length;
+        const qint64 first = vector(field, 1, length);
+        return QString::fromUtf8(reinterpret_cast<const char*>(begin + first), length);
+    }
+
+    template <class T>
+    T read(qint64 offset) const
+    {
+        if (offset < 0 || offset + qint64(sizeof(T)) > size)
+            throw std::runtime_error("damaged metadata");
+        T value;
+        std::memcpy(&value, begin + offset, sizeof(T));
+        return value;
+    }
+
+private:
+    qint64 fieldOffset(int field) const
+    {
+        const qint64 entry = 4 + 2 * field;
+        return entry + 2 <= vtableSize ? read<quint16>(vtable + entry) : 0;
+    }
+
+    const uchar* begin = nullptr;
+    qint64 size = 0;
+    qint64 position = 0;
+    qint64 vtable = 0;
+    qint64 vtableSize = 0;
+};
+
+// a field of the schema and how its values are laid out
+struct Field
+{
+    QString name;
+    int bufferCount = 2;
+    bool numeric = false;
+    int byteWidth = 8;
+    bool isSigned = true;
+    CsvColumn::Type type = CsvColumn::Int64;
+    // temporal values are scaled to seconds, value * secondsPerUnit / unitsPerSecond
+    qint64 secondsPerUnit = 1;
+    qint64 unitsPerSecond = 1;
+};
+
+qint64 unitsPerSecond(qint16 unit)
+{
+    if (unit < 0 || unit >= qint16(std::size(UnitsPerSecond)))
+        throw std::runtime_error("unsupported time unit");
+    return UnitsPerSecond[unit];
+}
+
+Field readField(const FlatTable& table)
+{
+    Field field;
+    field.name = table.string(0);
+    qint64 childCount;
+    table.vector(5, 4, childCount);
+    if (childCount > 0)
+        throw std::runtime_error("nested columns are not supported");
+    if (!table.table(4).isNull())
+        return field; // dictionary encoded, its two buffers hold indices
+
+    const FlatTable type = table.table(3);
+    switch (table.scalar<quint8>(2, 0))
+    {
+    case TypeNull:
+        field.bufferCount = 0;
+        break;
+    case TypeInt:
+        field.byteWidth = type.scalar<qint32>(0, 0) / 8;
+        field.isSigned = type.scalar<quint8>(1, 0) != 0;
+        field.numeric = field.byteWidth == 1 || field.byteWidth == 2 || field.byteWidth == 4 || field.byteWidth == 8;
+        field.type = field.byteWidth == 8 && !field.isSigned ? CsvColumn::UInt64 : CsvColumn::Int64;
+        break;
+    case TypeFloatingPoint:
+    {
+        const qint16 precision = type.scalar<qint16>(0, 0); // half, single, double
+        field.numeric = precision != 0;
+        field.byteWidth = precision == 1 ? 4 : 8;
+        field.type = precision == 1 ? CsvColumn::Float32 : CsvColumn::Float64;
+        break;
+    }
+    case TypeDate:
+        field.numeric = true;
+        if (type.scalar<qint16>(0, 1) == 0) // days or milliseconds
+        {
+            field.byteWidth = 4;
+            field.secondsPerUnit = 24 * 60 * 60;
+        }
+        else
+        {
+            field.unitsPerSecond = 1000;
+        }
+        break;
+    case TypeTime:
+        field.numeric = true;
+        field.unitsPerSecond = unitsPerSecond(type.scalar<qint16>(0, 1));
+        field.byteWidth = type.scalar<qint32>(1, 32) / 8;
+        break;
+    case TypeTimestamp:
+        field.numeric = true;
+        field.unitsPerSecond = unitsPerSecond(type.scalar<qint16>(0, 0));
+        break;
+    case TypeDuration:
+        field.numeric = true;
+        field.unitsPerSecond = unitsPerSecond(type.scalar<qint16>(0, 1));
+        break;
+    case TypeBinary:
+    case TypeUtf8:
+    case TypeLargeBinary:
+    case TypeLargeUtf8:
+        field.bufferCount = 3;
+        break;
+    case TypeBool:
+    case TypeDecimal:
+    case TypeInterval:
+    case TypeFixedSizeBinary:
+        break;
+    default:
+        throw std::runtime_error("unsupported column type");
+    }
+    return field;
+}
+
+// the file mapping borrowed columns keep alive
+struct MappedFile
+{
+    QFile file;
+    uchar* data = nullptr;
+
+    ~MappedFile()
+    {
+        if (data)
+            file.unmap(data);
+    }
+};
+
+template <class T>
+void widen(const uchar* values, qsizetype rows, qint64* out)
+{
+    for (qsizetype row = 0; row < rows; ++row)
+    {
+        T value;
+        std::memcpy(&value, values + row * qsizetype(sizeof(T)), sizeof(T));
+        out[row] = qint64(value);
+    }
+}
+
+// the values of a numeric field, borrowed from the mapping where the layout matches a CsvColumn
+CsvColumn readValues(const Field& field, const uchar* values, qsizetype rows, const std::shared_ptr<MappedFile>& file)
+{
+    const bool aligned = reinterpret_cast<quintptr>(values) % field.byteWidth == 0;
+    if (aligned && (field.byteWidth == 8 || field.type == CsvColumn::Float32))
+    {
+        return CsvColumn::borrow(field.type, values, rows, file);
+    }
+
+    CsvColumn column(field.type);
+    column.resize(rows);
+    if (field.byteWidth == 8 || field.type == CsvColumn::Float32)
+    {
+        std::memcpy(column.data(), values, rows * field.byteWidth);
+        return column;
+    }
+    qint64* out = column.values<qint64>().data();
+    switch (field.byteWidth)
+    {
+    case 1:
+        field.isSigned ? widen<qint8>(values, rows, out) : widen<quint8>(values, rows, out);
+        break;
+    case 2:
+        field.isSigned ? widen<qint16>(values, rows, out) : widen<quint16>(values, rows, out);
+        break;
+    default:
+        field.isSigned ? widen<qint32>(values, rows, out) : widen<quint32>(values, rows, out);
+        break;
+    }
+    return column;
+}
+
+// scales the values of a temporal field to seconds, what the csv parser gives timestamps in. They stay
+// Int64 while every valid value is a whole second, sub-second ones make the column Float64, split into
+// seconds and fraction first so nanosecond epoch timestamps don't lose more than a double must
+void toSeconds(const Field& field, CsvColumn& column)
+{
+    if (field.secondsPerUnit == 1 && field.unitsPerSecond == 1)
+        return;
+    const qsizetype rows = column.size();
+    const qint64* values = column.constValues<qint64>();
+    bool whole = true;
+    for (qsizetype row = 0; row < rows && whole; ++row)
+        whole = !column.isValid(row) || values[row] % field.unitsPerSecond == 0;
+
+    CsvColumn seconds(whole ? CsvColumn::Int64 : CsvColumn::Float64);
+    seconds.resize(rows);
+    if (whole)
+    {
+        qint64* out = seconds.values<qint64>().data();
+        for (qsizetype row = 0; row < rows; ++row)
+            out[row] = values[row] * field.secondsPerUnit / field.unitsPerSecond;
+    }
+    else
+    {
+        double* out = seconds.values<double>().data();
+        for (qsizetype row = 0; row < rows; ++row)
+            out[row] = double(values[row] / field.unitsPerSecond)
+                       + double(values[row] % field.unitsPerSecond) / double(field.unitsPerSecond);
+    }
+    if (!column.allValid())
+        seconds.setValidityWords(column.validityWords());
+    column = std::move(seconds);
+}
+} // namespace
+
+QString ArrowFile::fileSuffix()
+{
+    return "arrow";
+}
+
+bool ArrowFile::isArrowFile(const QString& path)
+{
+    QFile file(path);
+    char magic[sizeof(Magic)];
+    return file.open(QIODevice::ReadOnly) && file.read(magic, sizeof(magic)) == qint64(sizeof(magic))
+           && std::memcmp(magic, Magic, sizeof(Magic)) == 0;
+}
+
+CsvTable ArrowFile::read(const QString& path, const QStringList& projection)
+{
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    throw std::runtime_error("arrow files are only read on little endian machines");
+#endif
+    auto file = std::make_shared<MappedFile>();
+    file->file.setFileName(path);
+    if (!file->file.open(QIODevice::ReadOnly))
+    {
+        throw std::runtime_error(QString("Error opening %1").arg(path).toStdString());
+    }
+
+    //magic, padding, messages, footer, footer length, magic
+    const qint64 fileSize = file->file.size();
+    const qint64 trailerSize = 4 + qint64(sizeof(Magic));
+    file->data = fileSize >= 8 + trailerSize ? file->file.map(0, fileSize) : nullptr;
+    const uchar* mapped = file->data;
+    if (mapped == nullptr || std::memcmp(mapped, Magic, sizeof(Magic)) != 0
+        || std::memcmp(mapped + fileSize - sizeof(Magic), Magic, sizeof(Magic)) != 0)
+    {
+        throw std::runtime_error(QString("%1 is not an arrow file").arg(path).toStdString());
+    }
+
+    CsvTable table;
+    try
+    {
+        qint32 footerLength;
+        std::memcpy(&footerLength, mapped + fileSize - trailerSize, sizeof(footerLength));
+        const qint64 footerBegin = fileSize - trailerSize - footerLength;
+        if (footerLength <= 0 || footerBegin < 8)
+            throw std::runtime_error("damaged footer");
+        const FlatTable footer = FlatTable::root(mapped + footerBegin, mapped + fileSize - trailerSize);
+
+        const FlatTable schema = footer.table(1);
+        if (schema.isNull() || schema.scalar<qint16>(0, 0) != 0)
+            throw std::runtime_error("only little endian files are supported");
+        qint64 fieldCount;
+        const qint64 firstField = schema.vector(1, 4, fieldCount);
+        QVector<Field> fields;
+        QVector<qsizetype> targets; // column of each field, -1 if it isn't read
+        for (qint64 index = 0; index < fieldCount; ++index)
+        {
+            fields.append(readField(schema.tableAt(firstField + index * 4)));
+            const Field& field = fields.last();
+            targets.append(-1);
+            if (!field.numeric)
+                continue;
+            table.header.append(field.name);
+            if (projection.isEmpty() || projection.contains(field.name))
+            {
+                targets.last() = table.keys.size();
+                table.keys.append(field.name);
+                table.columns.append(CsvColumn(field.type));
+            }
+        }
+
+        //Block structs: offset, metadata length, padding, body length
+        qint64 batchCount;
+        const qint64 firstBatch = footer.vector(3, 24, batchCount);
+        for (qint64 batch = 0; batch < batchCount; ++batch)
+        {
+            const qint64 blockOffset = footer.read<qint64>(firstBatch + batch * 24);
+            const qint64 metadataLength = footer.read<qint32>(firstBatch + batch * 24 + 8);
+            const qint64 bodyLength = footer.read<qint64>(firstBatch + batch * 24 + 16);
+            const qint64 bodyBegin = blockOffset + metadataLength;
+            if (blockOffset < 8 || metadataLength < 8 || bodyLength < 0 || bodyBegin + bodyLength > footerBegin)
+                throw std::runtime_error("damaged record batch block");
+
+            //messages start with a continuation marker and the flatbuffer length, older files without the marker
+            quint32 prefix;
+            std::memcpy(&prefix, mapped + blockOffset, sizeof(prefix));
+            const qint64 messageBegin = blockOffset + (prefix == Continuation ? 8 : 4);
+            const FlatTable message = FlatTable::root(mapped + messageBegin, mapped + bodyBegin);
+            const FlatTable recordBatch = message.table(2);
+            if (message.scalar<quint8>(1, 0) != MessageRecordBatch || recordBatch.isNull())
+                throw std::runtime_error("damaged record batch");
+            if (!recordBatch.table(3).isNull())
+                throw std::runtime_error("compressed record batches are not supported");
+
+            //one FieldNode (length, null count) per field and its buffers (offset, length) in schema order
+            const qint64 rows = recordBatch.scalar<qint64>(0, 0);
+            qint64 nodeCount, bufferCount;
+            const qint64 firstNode = recordBatch.vector(1, 16, nodeCount);
+            const qint64 firstBuffer = recordBatch.vector(2, 16, bufferCount);
+            if (nodeCount != fields.size())
+                throw std::runtime_error("record batch doesn't match the schema");
+            qint64 buffer = 0;
+            for (qsizetype index = 0; index < fields.size(); ++index)
+            {
+                const Field& field = fields.at(index);
+                const qint64 nextBuffer = buffer + field.bufferCount;
+                if (nextBuffer > bufferCount)
+                    throw std::runtime_error("record batch doesn't match the schema");
+                if (targets.at(index) < 0)
+                {
+                    buffer = nextBuffer;
+                    continue;
+                }
+
+                const qint64 nullCount = recordBatch.read<qint64>(firstNode + index * 16 + 8);
+                const qint64 validityOffset = recordBatch.read<qint64>(firstBuffer + buffer * 16);
+                const qint64 validityLength = recordBatch.read<qint64>(firstBuffer + buffer * 16 + 8);
+                const qint64 valuesOffset = recordBatch.read<qint64>(firstBuffer + (buffer + 1) * 16);
+                const qint64 valuesLength = recordBatch.read<qint64>(firstBuffer + (buffer + 1) * 16 + 8);
+                buffer = nextBuffer;
+                if (recordBatch.read<qint64>(firstNode + index * 16) != rows || valuesOffset < 0
+                    || valuesLength < rows * field.byteWidth || valuesOffset + valuesLength > bodyLength
+                    || validityOffset < 0 || validityLength < 0 || validityOffset + validityLength > bodyLength)
+                    throw std::runtime_error("damaged column buffers");
+
+                CsvColumn column = readValues(field, mapped + bodyBegin + valuesOffset, rows, file);
+                if (nullCount > 0 && validityLength > 0)
+                {
+                    //arrow validity bits are in the order of our words on a little endian machine
+                    QVector<quint64> words((rows + 63) / 64);
+                    std::memcpy(words.data(), mapped + bodyBegin + validityOffset,
+                                qMin<qint64>(validityLength, words.size() * qint64(sizeof(quint64))));
+                    if (rows % 64 != 0)
+                        words.last() &= (quint64(1) << (rows % 64)) - 1;
+                    column.setValidityWords(words);
+                }
+                toSeconds(field, column);
+                table.columns[targets.at(index)].append(column);
+            }
+        }
+    }
+    catch (std::exception& e)
+    {
+        throw std::runtime_error(QString("%1: %2").arg(path, QString::fromUtf8(e.what())).toStdString());
+    }
+    table.sourceBytes = fileSize;
+    return table;
+}
@@ -0,0 +1,26 @@
+#ifndef ARROWFILE_H
+#define ARROWFILE_H
+
+#include "csvparser.h"
+
+// Reader for uncompressed Arrow IPC files (Feather v2). The file is memory mapped
+// and the flatbuffer metadata is decoded in place, no arrow library is needed.
+// Numeric columns come back as CsvColumns: 64 bit integers, timestamps and floats
+// borrow their buffers from the mapping, which stays mapped as long as one of them
+// does, narrower integers are widened to Int64. Dates, times, timestamps and
+// durations in other units than seconds are scaled to seconds like the csv parser's
+// timestamps, into Float64 if some have a fraction. Columns of other types are skipped.
+class ArrowFile
+{
+public:
+    static QString fileSuffix();
+    // true if path starts with the arrow file magic
+    static bool isArrowFile(const QString& path);
+
+    // the projected numeric columns (all if projection is empty) of every record batch. A file with a
+    // single record batch is read without copying its values, several batches are concatenated.
+    // Throws std::runtime_error if the file can't be read, is damaged or compressed
+    static CsvTable read(const QString& path, const QStringList& projection);
+};
+
+#endif // ARROWFILE_H
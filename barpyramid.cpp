@@ -0,0 +1,265 @@
+#include "barpyramid.h"
+
+#include "sessioncalendar.h"
+
+#include <cmath>
+
+namespace
+{
+constexpr double Hour = 60 * 60;
+constexpr double Day = 24 * Hour;
+constexpr double Week = 7 * Day;
+//the timeframes of the levels, each a multiple of the one before so the buckets of a level are whole buckets
+// of the one below
+constexpr double Timeframes[] = {5 * 60, 15 * 60, Hour, 4 * Hour, Day, Week};
+//no coarser level is built above one with at most this many bars, more than any screen is wide in pixels
+constexpr int ScreenBars = 4096;
+//the epoch was a Thursday, weeks start on the Monday three days before it
+constexpr double WeekStart = -3 * Day;
+//a step between two bars of at least this, and two bars, is a night between trading days if it is shorter than
+// a day. The start of the trading day is looked for in this many bars, more than a week of minute bars
+constexpr double MinNightGap = 30 * 60;
+constexpr int DayStartBars = 16384;
+
+//the smallest key step among the first bars, infinity if there are fewer than two
+double barInterval(const QCPFinancialDataContainer& candles)
+{
+    double interval = std::numeric_limits<double>::infinity();
+    const int count = qMin(candles.size(), 1024);
+    for (int i = 1; i < count; ++i)
+    {
+        const double step = (candles.constBegin() + i)->key - (candles.constBegin() + i - 1)->key;
+        if (step > 0)
+        {
+            interval = qMin(interval, step);
+        }
+    }
+    return interval;
+}
+
+//the time of a key, which is a session coordinate if there are sessions
+double timeOf(double key, const SessionCalendar* sessions)
+{
+    return sessions ? sessions->toTime(key) : key;
+}
+
+//the start of the trading day in seconds after utc midnight, in [-12 h, 12 h): the middle of the shortest night
+// among the first bars, rounded to the hour so hourly buckets stay whole buckets of a day. 0 if there is no night,
+// as for markets trading round the clock or bars of a day or longer
+double tradingDayStart(const QCPFinancialDataContainer& candles, double interval, const SessionCalendar* sessions)
+{
+    double night = Day;
+    double middle = 0;
+    const int count = qMin(candles.size(), DayStartBars);
+    auto it = candles.constBegin();
+    double previous = count > 0 ? timeOf(it->key, sessions) : 0;
+    for (int i = 1; i < count; ++i)
+    {
+        const double time = timeOf((++it)->key, sessions);
+        const double step = time - previous;
+        if (step >= qMax(MinNightGap, 2 * interval) && step < night)
+        {
+            night = step;
+            middle = (previous + interval + time) / 2;
+        }
+        previous = time;
+    }
+    if (night >= Day)
+    {
+        return 0;
+    }
+    double start = std::round((middle - std::floor(middle / Day) * Day) / Hour) * Hour;
+    return start >= Day / 2 ? start - Day : start;
+}
+
+double bucketOf(double time, double seconds, double dayStart)
+{
+    const double start = seconds >= Week ? dayStart + WeekStart : dayStart;
+    return std::floor((time - start) / seconds) * seconds + start;
+}
+
+//the key of the bucket starting at start whose first bar has key, the start itself unless the keys are session
+// coordinates. A time between two sessions has no coordinate of its own, so a bucket of sessions is keyed by its
+// first bar
+double bucketKey(double start, double key, const SessionCalendar* sessions)
+{
+    return sessions ? key : start;
+}
+
+template <class Iterator>
+QVector<QCPFinancialData> mergeCandles(Iterator it, Iterator end, double seconds, double dayStart,
+                                       const SessionCalendar* sessions)
+{
+    QVector<QCPFinancialData> merged;
+    QCPFinancialData bucket;
+    double start = 0; // the time bucket starts at
+    bool inBucket = false;
+    for (; it != end; ++it)
+    {
+        //views assemble a point on each access, so every bar is read once
+        const QCPFinancialData bar = *it;
+        const double barStart = bucketOf(timeOf(bar.key, sessions), seconds, dayStart);
+        if (!inBucket || barStart != start)
+        {
+            if (inBucket)
+            {
+                merged.append(bucket);
+            }
+            bucket = QCPFinancialData(bucketKey(barStart, bar.key, sessions), bar.open, bar.high, bar.low, bar.close);
+            start = barStart;
+            inBucket = true;
+            continue;
+        }
+        if (qIsNaN(bucket.open))
+        {
+            bucket.open = bar.open;
+        }
+        //fmax and fmin return the other argument for NaN
+        bucket.high = std::fmax(bucket.high, bar.high);
+        bucket.low = std::fmin(bucket.low, bar.low);
+        if (!qIsNaN(bar.close))
+        {
+            bucket.close = bar.close;
+        }
+    }
+    if (inBucket)
+    {
+        merged.append(bucket);
+    }
+    return merged;
+}
+
+template <class Iterator>
+QVector<QCPBarsData> mergeVolume(Iterator it, Iterator end, double seconds, double dayStart,
+                                 const SessionCalendar* sessions)
+{
+    QVector<QCPBarsData> merged;
+    QCPBarsData bucket;
+    double start = 0;
+    bool inBucket = false;
+    for (; it != end; ++it)
+    {
+        const QCPBarsData bar = *it;
+        const double barStart = bucketOf(timeOf(bar.key, sessions), seconds, dayStart);
+        if (!inBucket || barStart != start)
+        {
+            if (inBucket)
+            {
+                merged.append(bucket);
+            }
+            bucket = QCPBarsData(bucketKey(barStart, bar.key, sessions), 0);
+            start = barStart;
+            inBucket = true;
+        }
+        if (!qIsNaN(bar.value))
+        {
+            bucket.value += bar.value;
+        }
+    }
+    if (inBucket)
+    {
+        merged.append(bucket);
+    }
+    return merged;
+}
+
+//appends the levels coarser than the last of levels while it, or candles if there is none, has more bars
+// than fit a screen
+void addLevels(QVector<BarPyramid::Level>& levels, const QCPFinancialDataContainer& candles,
+               const QCPBarsDataContainer& volume, const SessionCalendar* sessions)
+{
+    const double interval = barInterval(candles);
+    //levels added to a pyramid keep the days of the ones there
+    const double dayStart =
+        levels.isEmpty() ? tradingDayStart(candles, interval, sessions) : levels.first().dayStart;
+    const QCPFinancialDataContainer* finerCandles = levels.isEmpty() ? &candles : levels.last().candles.data();
+    const QCPBarsDataContainer* finerVolume = levels.isEmpty() ? &volume : levels.last().volume.data();
+    for (double seconds : Timeframes)
+    {
+        if (finerCandles->size() <= ScreenBars)
+        {
+            break;
+        }
+        //timeframes that wouldn't at least halve the bars are skipped
+        if (seconds < 2 * interval || (!levels.isEmpty() && seconds <= levels.last().seconds))
+        {
+            continue;
+        }
+        BarPyramid::Level level;
+        level.seconds = seconds;
+        level.dayStart = dayStart;
+        level.candles.reset(new QCPFinancialDataContainer);
+        level.candles->set(
+            mergeCandles(finerCandles->constBegin(), finerCandles->constEnd(), seconds, dayStart, sessions), true);
+        level.volume.reset(new QCPBarsDataContainer);
+        level.volume->set(mergeVolume(finerVolume->constBegin(), finerVolume->constEnd(), seconds, dayStart, sessions),
+                          true);
+        levels.append(level);
+        finerCandles = level.candles.data();
+        finerVolume = level.volume.data();
+    }
+}
+
+int visibleBars(const QCPFinancialDataContainer& candles, const QCPRange& keyRange)
+{
+    return int(candles.findEnd(keyRange.upper, false) - candles.findBegin(keyRange.lower, false));
+}
+} // namespace
+
+QVector<BarPyramid::Level> BarPyramid::build(const QCPFinancialDataContainer& candles,
+                                             const QCPBarsDataContainer& volume, const SessionCalendar* sessions)
+{
+    QVector<Level> levels;
+    addLevels(levels, candles, volume, sessions);
+    return levels;
+}
+
+void BarPyramid::extend(QVector<Level>& levels, const QCPFinancialDataContainer& candles,
+                        const QCPBarsDataContainer& volume, const SessionCalendar* sessions)
+{
+    const QCPFinancialDataContainer* finerCandles = &candles;
+    const QCPBarsDataContainer* finerVolume = &volume;
+    for (Level& level : levels)
+    {
+        //appended bars may fall into the last bucket, which is merged again with the ones behind it. Its key is
+        // its start, or the key of its first bar in session coordinates, which the level below has too. The bucket
+        // before may be closer than half a bucket in session coordinates, removeAfter keeps the key it is given
+        double from = std::numeric_limits<double>::lowest();
+        if (!level.candles->isEmpty())
+        {
+            from = (level.candles->constEnd() - 1)->key;
+            const double before = std::nextafter(from, std::numeric_limits<double>::lowest());
+            level.candles->removeAfter(before);
+            level.volume->removeAfter(before);
+        }
+        level.candles->add(mergeCandles(finerCandles->findBegin(from, false), finerCandles->constEnd(), level.seconds,
+                                        level.dayStart, sessions),
+                           true);
+        level.volume->add(mergeVolume(finerVolume->findBegin(from, false), finerVolume->constEnd(), level.seconds,
+                                      level.dayStart, sessions),
+                          true);
+        finerCandles = level.candles.data();
+        finerVolume = level.volume.data();
+    }
+    //the bars may have grown past a screen at the top
+    addLevels(levels, candles, volume, sessions);
+}
+
+double BarPyramid::barSeconds(const QCPFinancialDataContainer& candles)
+{
+    const double interval = barInterval(candles);
+    return std::isinf(interval) ? 0 : interval;
+}
+
+int BarPyramid::choose(const QVector<Level>& levels, const QCPFinancialDataContainer& candles,
+                       const QCPRange& keyRange, int pixels)
+{
+    int level = -1;
+    const QCPFinancialDataContainer* shown = &candles;
+    while (level + 1 < levels.size() && visibleBars(*shown, keyRange) > pixels)
+    {
+        ++level;
+        shown = levels.at(level).candles.data();
+    }
+    return level;
+}
@@ -0,0 +1,46 @@
+#ifndef BARPYRAMID_H
+#define BARPYRAMID_H
+
+#include "qcustomplot.h"
+
+class SessionCalendar;
+
+// The bars of a chart merged into coarser and coarser timeframes, so a chart
+// zoomed out over years of minute bars draws about one candle per pixel instead
+// of every bar. Each level merges the bars of the one below it into buckets of a
+// standard timeframe: the first open, highest high, lowest low and last close of
+// the bucket, and the sum of its volume. Missing values are skipped. Days start
+// at the start of the trading day, found in the night gap of the bars, and weeks
+// on a Monday, the buckets below a day at multiples of their length from the
+// day's start. Keys given in the session coordinates of a calendar are bucketed
+// by their times, and a bucket is keyed by its first bar.
+class BarPyramid
+{
+public:
+    struct Level
+    {
+        double seconds = 0;  // the bucket length of the level's bars
+        double dayStart = 0; // the seconds after utc midnight its days start, the same for every level
+        QSharedPointer<QCPFinancialDataContainer> candles;
+        QSharedPointer<QCPBarsDataContainer> volume;
+    };
+
+    // the levels of candles and volume, finest first. Levels stop once one has few enough bars to
+    // fit a screen. Reads the containers and sessions only, so it can run on a worker thread on copies of them.
+    // The keys are session coordinates of sessions unless it is null
+    static QVector<Level> build(const QCPFinancialDataContainer& candles, const QCPBarsDataContainer& volume,
+                                const SessionCalendar* sessions = nullptr);
+    // merges bars appended to candles and volume into the levels, which were built from them before.
+    // Only the last bar of each level and the bars behind it are merged again, and coarser levels are
+    // added once the top one no longer fits a screen
+    static void extend(QVector<Level>& levels, const QCPFinancialDataContainer& candles,
+                       const QCPBarsDataContainer& volume, const SessionCalendar* sessions = nullptr);
+    // the timeframe of candles, the smallest key step among the first bars, 0 if there are fewer than two
+    static double barSeconds(const QCPFinancialDataContainer& candles);
+    // the finest of the levels of which no more than pixels bars fall into keyRange, -1 for the
+    // candles themselves
+    static int choose(const QVector<Level>& levels, const QCPFinancialDataContainer& candles, const QCPRange& keyRange,
+                      int pixels);
+};
+
+#endif // BARPYRAMID_H
@@ -0,0 +1,92 @@
+// Parses a csv file with CsvParser::parseMapped on 1, 2, 4, ... threads up to the ideal thread
+// count and prints the throughput of each, the best of three runs.
+//
+//   bench_csvparse [file.csv | rows]
+//
+// Without a file a csv of minute bars is written to a temporary directory first, a million rows
+// unless a row count is given.
+
+#include "csvparser.h"
+#include "minutebars.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <cstdio>
+
+namespace
+{
+constexpr int Runs = 3;
+
+void writeBars(const QString& path, qint64 rows)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        throw std::runtime_error(QString("Error writing %1").arg(path).toStdString());
+    }
+    file.write(MinuteBars::CsvHeader);
+    QByteArray chunk;
+    double price = MinuteBars::FirstPrice;
+    for (qint64 row = 0; row < rows; ++row)
+    {
+        price = MinuteBars::walk(price, row);
+        MinuteBars::appendCsvRow(chunk, row, price);
+        if (chunk.size() > (1 << 20))
+        {
+            file.write(chunk);
+            chunk.clear();
+        }
+    }
+    file.write(chunk);
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QTemporaryDir directory;
+    QString path = argc > 1 ? QString::fromLocal8Bit(argv[1]) : QString();
+    bool isCount = false;
+    const qint64 rows = path.toLongLong(&isCount);
+    if (path.isEmpty() || isCount)
+    {
+        path = directory.filePath("bars.csv");
+        writeBars(path, isCount ? rows : 1000000);
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        std::fprintf(stderr, "Error opening %s\n", qPrintable(path));
+        return 1;
+    }
+    std::printf("%s: %.1f MB\n", qPrintable(path), file.size() / 1e6);
+    std::printf("threads        ms      MB/s        rows/s   speedup\n");
+
+    QVector<int> threadCounts;
+    for (int threads = 1; threads < QThread::idealThreadCount(); threads *= 2)
+    {
+        threadCounts.append(threads);
+    }
+    threadCounts.append(QThread::idealThreadCount());
+    double singleThreadNs = 0;
+    for (int threads : threadCounts)
+    {
+        qsizetype parsedRows = 0;
+        const double bestNs = MinuteBars::bestOf(Runs,
+                                                 [&]()
+                                                 {
+                                                     CsvParser parser;
+                                                     parsedRows = parser.parseMapped(file, threads).rowCount();
+                                                 })
+                              * 1e6;
+        if (threads == 1)
+        {
+            singleThreadNs = bestNs;
+        }
+        std::printf("%7d %9.1f %9.1f %13.0f %8.2fx\n", threads, bestNs / 1e6, file.size() * 1e3 / bestNs,
+                    parsedRows * 1e9 / bestNs, singleThreadNs / bestNs);
+    }
+    return 0;
+}
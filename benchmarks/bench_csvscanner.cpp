@@ -0,0 +1,94 @@
+// Scans csv text for delimiters and newlines with each CsvScanner kernel the cpu runs and prints
+// their throughput next to the split based tokenizing the chart window did before the parser, the
+// best of five runs. The text is scanned in blocks of CsvParser::ScanBlockSize like the parser does.
+//
+//   bench_csvscanner [megabytes]
+//
+// The text is minute bars generated in memory, 256 MB unless a size is given.
+
+#include "csvparser.h"
+#include "csvscanner.h"
+#include "minutebars.h"
+
+#include <QString>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+constexpr int Runs = 5;
+
+QByteArray generateBars(qint64 bytes)
+{
+    QByteArray text = MinuteBars::CsvHeader;
+    text.reserve(bytes + 128);
+    double price = MinuteBars::FirstPrice;
+    for (qint64 row = 0; text.size() < bytes; ++row)
+    {
+        price = MinuteBars::walk(price, row);
+        MinuteBars::appendCsvRow(text, row, price);
+    }
+    return text;
+}
+
+// the offsets found in every block of text, which keeps the scan from being optimized away
+qint64 scanBlocks(CsvScanner::Kernel kernel, const QByteArray& text, QVector<quint32>& index)
+{
+    qint64 found = 0;
+    const char* end = text.constData() + text.size();
+    for (const char* begin = text.constData(); begin < end; begin += CsvParser::ScanBlockSize)
+    {
+        const char* blockEnd = end - begin > CsvParser::ScanBlockSize ? begin + CsvParser::ScanBlockSize : end;
+        found += CsvScanner::scan(kernel, begin, blockEnd, index.data());
+    }
+    return found;
+}
+
+// the text as a QString split into lines and each line at its commas, the way the chart window read
+// files before the parser. Returns the commas and newlines, the offsets the kernels find
+qint64 splitLines(const QByteArray& text)
+{
+    const QString lines = QString::fromUtf8(text.constData(), text.size());
+    qint64 found = 0;
+    for (const QString& line : lines.split('\n'))
+    {
+        if (line.isEmpty())
+        {
+            continue;
+        }
+        found += line.split(',').size();
+    }
+    return found;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const qint64 megabytes = argc > 1 ? qMax(std::atoll(argv[1]), 1LL) : 256;
+    const QByteArray text = generateBars(megabytes * 1000 * 1000);
+    QVector<quint32> index(CsvParser::ScanBlockSize);
+    std::printf("%.1f MB of csv, %lld byte blocks, selected kernel %s\n", text.size() / 1e6,
+                static_cast<long long>(CsvParser::ScanBlockSize), CsvScanner::kernelName());
+    std::printf("kernel        ms      GB/s   speedup      offsets\n");
+
+    qint64 splitFound = 0;
+    const double splitNs = MinuteBars::bestOf(Runs, [&]() { splitFound = splitLines(text); }) * 1e6;
+    std::printf("%-7s %9.1f %9.2f %8.2fx %12lld\n", "split", splitNs / 1e6, text.size() / splitNs, 1.0,
+                static_cast<long long>(splitFound));
+    int mismatches = 0;
+    for (CsvScanner::Kernel kernel : {CsvScanner::Scalar, CsvScanner::Sse2, CsvScanner::Avx2})
+    {
+        if (!CsvScanner::isSupported(kernel))
+        {
+            continue;
+        }
+        qint64 found = 0;
+        const double bestNs = MinuteBars::bestOf(Runs, [&]() { found = scanBlocks(kernel, text, index); }) * 1e6;
+        std::printf("%-7s %9.1f %9.2f %8.2fx %12lld%s\n", CsvScanner::kernelName(kernel), bestNs / 1e6,
+                    text.size() / bestNs, splitNs / bestNs, static_cast<long long>(found),
+                    found == splitFound ? "" : "  MISMATCH");
+        mismatches += found != splitFound;
+    }
+    return mismatches == 0 ? 0 : 1;
+}
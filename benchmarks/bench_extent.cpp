@@ -0,0 +1,181 @@
+// Scans the value range of a hundred million minute bars held as points and viewed as columns, the
+// way the chart fits its value axis, and prints the time of each, the best of three runs: the first
+// range of all bars, which reads every bar into the range index, the ranges of all bars and of half
+// of them answered by the index, and the range of the positive sign domain, which the index doesn't
+// answer. Some bars have a NaN or infinite low or high, both containers must skip them alike.
+//
+//   bench_extent [bars [held | viewed]]
+//
+// Each container is measured in a process of its own, which prints its times and ranges, so the
+// memory of one doesn't count against the other: without a container the benchmark runs itself for
+// both and compares them.
+#include "minutebars.h"
+#include "qcustomplot.h"
+
+#include <QProcess>
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <limits>
+
+namespace
+{
+constexpr int Runs = 3;
+constexpr qsizetype Chunk = 1 << 20;
+
+using MinuteBars::bestOf;
+
+//bars [first, first + count), prices in quarters so single precision holds them exactly
+QVector<QCPFinancialData> minuteBars(qsizetype first, qsizetype count)
+{
+    QVector<QCPFinancialData> bars;
+    bars.reserve(count);
+    for (qsizetype bar = first; bar < first + count; ++bar)
+    {
+        const double price = 100 + (bar * 7919) % 4001 * 0.25;
+        QCPFinancialData point(MinuteBars::time(bar), price, price + 0.5, price - 0.5, price + 0.25);
+        if (bar % 1000003 == 17)
+        {
+            point.low = -std::numeric_limits<double>::infinity();
+        }
+        else if (bar % 999983 == 29)
+        {
+            point.high = std::numeric_limits<double>::infinity();
+        }
+        else if (bar % 499979 == 3)
+        {
+            point.low = std::numeric_limits<double>::quiet_NaN();
+        }
+        bars.append(point);
+    }
+    return bars;
+}
+
+struct Result
+{
+    double ms[4];
+    QCPRange ranges[3];
+};
+
+//times the ranges of container, drop is called untimed to drop its range index
+Result measure(QCPFinancialDataContainer& container, const std::function<void()>& drop, qsizetype bars)
+{
+    const QCPRange half(MinuteBars::time(bars / 4), MinuteBars::time(bars * 3 / 4));
+    Result result;
+    bool found;
+    result.ms[0] = bestOf(Runs, drop, [&]() { result.ranges[0] = container.valueRange(found); });
+    result.ms[1] = bestOf(Runs, [&]() { container.valueRange(found); });
+    result.ms[2] = bestOf(Runs, [&]() { result.ranges[1] = container.valueRange(found, QCP::sdBoth, half); });
+    result.ms[3] = bestOf(Runs, [&]() { result.ranges[2] = container.valueRange(found, QCP::sdPositive); });
+    return result;
+}
+
+//measures the held or viewed container in this process and prints the result on one line
+void measureContainer(qsizetype bars, const QByteArray& mode)
+{
+    Result result;
+    if (mode == "held")
+    {
+        //the bars are collected in one vector the container then shares, growing the container by chunks would
+        // reallocate it at twice the size
+        QCPFinancialDataContainer container;
+        {
+            QVector<QCPFinancialData> all;
+            all.reserve(bars);
+            for (qsizetype first = 0; first < bars; first += Chunk)
+                all.append(minuteBars(first, qMin(Chunk, bars - first)));
+            container.set(all, true);
+        }
+        result = measure(container, [&]() { container.begin(); }, bars);
+    }
+    else
+    {
+        QCPCompactFinancialData compact;
+        for (qsizetype first = 0; first < bars; first += Chunk)
+            compact.add(minuteBars(first, qMin(Chunk, bars - first)), true);
+        QCPFinancialDataContainer container;
+        compact.view(container);
+        result = measure(
+            container,
+            [&]()
+            {
+                container.clear();
+                compact.view(container);
+            },
+            bars);
+    }
+    std::printf("%.6f %.6f %.6f %.6f", result.ms[0], result.ms[1], result.ms[2], result.ms[3]);
+    for (const QCPRange& range : result.ranges)
+        std::printf(" %.17g %.17g", range.lower, range.upper);
+    std::printf("\n");
+}
+
+//runs this benchmark for the held or viewed container, false if it failed, e.g. ran out of memory
+bool runContainer(const QString& program, qsizetype bars, const QString& mode, Result& result)
+{
+    QProcess process;
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.start(program, {QString::number(qint64(bars)), mode});
+    if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0)
+        return false;
+    const QList<QByteArray> fields = process.readAllStandardOutput().simplified().split(' ');
+    if (fields.size() != 10)
+        return false;
+    for (int path = 0; path < 4; ++path)
+        result.ms[path] = fields.at(path).toDouble();
+    for (int range = 0; range < 3; ++range)
+    {
+        result.ranges[range].lower = fields.at(4 + 2 * range).toDouble();
+        result.ranges[range].upper = fields.at(5 + 2 * range).toDouble();
+    }
+    return true;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const qsizetype bars = argc > 1 ? qsizetype(QByteArray(argv[1]).toLongLong()) : 100000000;
+    const QByteArray mode = argc > 2 ? QByteArray(argv[2]) : QByteArray();
+    if (bars <= 0 || bars > std::numeric_limits<int>::max() || (argc > 2 && mode != "held" && mode != "viewed"))
+    {
+        std::fprintf(stderr, "usage: bench_extent [bars [held | viewed]]\n");
+        return 1;
+    }
+    if (!mode.isEmpty())
+    {
+        measureContainer(bars, mode);
+        return 0;
+    }
+
+    const QString program = QString::fromLocal8Bit(argv[0]);
+    Result held;
+    Result viewed;
+    const bool heldRan = runContainer(program, bars, "held", held);
+    const bool viewedRan = runContainer(program, bars, "viewed", viewed);
+    std::printf("%lld bars, %.0f MB held, %.0f MB viewed\n", qint64(bars),
+                bars * double(sizeof(QCPFinancialData)) / 1e6, bars * (sizeof(double) + 4 * sizeof(float)) / 1e6);
+    if (!heldRan || !viewedRan)
+    {
+        std::printf("FAILED: the %s container didn't finish\n", heldRan ? "viewed" : "held");
+        return 1;
+    }
+    std::printf("%-24s %10s %10s %9s\n", "valueRange", "held ms", "view ms", "speedup");
+    const char* paths[] = {"all bars, first call", "all bars, indexed", "half the keys, indexed",
+                           "positive sign domain"};
+    for (int path = 0; path < 4; ++path)
+        std::printf("%-24s %10.3f %10.3f %8.2fx\n", paths[path], held.ms[path], viewed.ms[path],
+                    held.ms[path] / viewed.ms[path]);
+
+    for (int range = 0; range < 3; ++range)
+    {
+        if (held.ranges[range] != viewed.ranges[range] || !std::isfinite(held.ranges[range].lower)
+            || !std::isfinite(held.ranges[range].upper))
+        {
+            std::printf("MISMATCH: held %g..%g, viewed %g..%g\n", held.ranges[range].lower, held.ranges[range].upper,
+                        viewed.ranges[range].lower, viewed.ranges[range].upper);
+            return 1;
+        }
+    }
+    return 0;
+}
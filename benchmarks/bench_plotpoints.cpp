@@ -0,0 +1,107 @@
+// Hands ten million minute bars to the plottable containers the ways the loader can and prints the
+// time of each, the best of three runs: per bar add() calls, set() sorting the bars again, set()
+// told they are sorted, the check for it, and sorting bars that were out of order.
+//
+//   bench_plotpoints [bars]
+
+#include "minutebars.h"
+#include "qcustomplot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+constexpr int Runs = 3;
+
+using MinuteBars::bestOf;
+
+QVector<QCPFinancialData> minuteBars(qsizetype count)
+{
+    QVector<QCPFinancialData> bars;
+    bars.reserve(count);
+    double price = MinuteBars::FirstPrice;
+    for (qsizetype bar = 0; bar < count; ++bar)
+    {
+        price = MinuteBars::walk(price, bar);
+        bars.append(QCPFinancialData(MinuteBars::time(bar), price, price + 0.25, price - 0.25, price + 0.1));
+    }
+    return bars;
+}
+
+void print(const char* path, double ms, qsizetype bars, double baseline)
+{
+    std::printf("%-28s %10.1f %12.1f %9.2fx\n", path, ms, bars / ms / 1000.0, baseline / ms);
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const qsizetype bars = argc > 1 ? qsizetype(QByteArray(argv[1]).toLongLong()) : 10000000;
+    if (bars <= 0)
+    {
+        std::fprintf(stderr, "usage: bench_plotpoints [bars]\n");
+        return 1;
+    }
+    const QVector<QCPFinancialData> sorted = minuteBars(bars);
+    QVector<QCPFinancialData> shuffled = sorted;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+
+    std::printf("%lld bars, %.0f MB as points\n", qint64(bars), bars * double(sizeof(QCPFinancialData)) / 1e6);
+    std::printf("%-28s %10s %12s %10s\n", "path", "ms", "Mbars/s", "speedup");
+
+    QSharedPointer<QCPFinancialDataContainer> container;
+    QVector<QCPFinancialData> points;
+    auto fresh = [&]()
+    {
+        container.reset(new QCPFinancialDataContainer);
+        points = sorted;
+        points.detach();
+    };
+
+    const double added = bestOf(Runs, fresh,
+                                [&]()
+                                {
+                                    for (const QCPFinancialData& bar : points)
+                                        container->add(bar);
+                                });
+    print("add() per bar", added, bars, added);
+    print("set() sorting again", bestOf(Runs, fresh, [&]() { container->set(points); }), bars, added);
+
+    bool ascending = false;
+    const double checked = bestOf(Runs,
+                                  [&]()
+                                  {
+                                      ascending = std::is_sorted(sorted.constBegin(), sorted.constEnd(),
+                                                                 qcpLessThanSortKey<QCPFinancialData>);
+                                  });
+    print("check keys ascend", checked, bars, added);
+    const double presorted = bestOf(Runs, fresh, [&]() { container->set(points, true); });
+    print("set() presorted", presorted, bars, added);
+    print("check + set() presorted", checked + presorted, bars, added);
+
+    auto freshShuffled = [&]()
+    {
+        container.reset(new QCPFinancialDataContainer);
+        points = shuffled;
+        points.detach();
+    };
+    print("set() out of order", bestOf(Runs, freshShuffled, [&]() { container->set(points); }), bars, added);
+
+    QCPCompactFinancialData compact;
+    const double compacted = bestOf(Runs, [&]() { container.reset(new QCPFinancialDataContainer); },
+                                    [&]()
+                                    {
+                                        compact.set(sorted, true);
+                                        compact.view(*container);
+                                    });
+    print("single precision + view", compacted, bars, added);
+
+    if (!ascending || container->size() != bars)
+    {
+        std::printf("MISMATCH: %lld bars viewed\n", qint64(container->size()));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef MINUTEBARS_H
+#define MINUTEBARS_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+
+#include <functional>
+#include <limits>
+
+// The minute bars the benchmarks load, a random walk of prices a minute apart, and the timing loop
+// they share.
+namespace MinuteBars
+{
+constexpr qint64 FirstTime = 1700000000;
+constexpr double FirstPrice = 100;
+constexpr char CsvHeader[] = "timestamp,price_open,price_high,price_low,price_close,volume,sma9\n";
+
+// the open of bar row, walked from the open of the bar before it
+inline double walk(double price, qint64 row)
+{
+    return price + ((row * 7919) % 201 - 100) * 0.001;
+}
+
+inline qint64 time(qint64 row)
+{
+    return FirstTime + row * 60;
+}
+
+// appends bar row opening at price as a line under CsvHeader, sma9 is empty for the first eight bars
+inline void appendCsvRow(QByteArray& text, qint64 row, double price)
+{
+    text += QByteArray::number(time(row)) + ',' + QByteArray::number(price, 'f', 2) + ','
+            + QByteArray::number(price + 0.25, 'f', 2) + ',' + QByteArray::number(price - 0.25, 'f', 2) + ','
+            + QByteArray::number(price + 0.1, 'f', 2) + ',' + QByteArray::number(1000 + row % 5000) + ','
+            + (row < 8 ? QByteArray() : QByteArray::number(price - 0.05, 'f', 4)) + '\n';
+}
+
+// the best of runs times of run in ms, prepare is called untimed before each
+inline double bestOf(int runs, const std::function<void()>& prepare, const std::function<void()>& run)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < runs; ++i)
+    {
+        prepare();
+        QElapsedTimer timer;
+        timer.start();
+        run();
+        best = qMin(best, timer.nsecsElapsed() / 1e6);
+    }
+    return best;
+}
+
+inline double bestOf(int runs, const std::function<void()>& run)
+{
+    return bestOf(runs, []() {}, run);
+}
+} // namespace MinuteBars
+
+#endif // MINUTEBARS_H
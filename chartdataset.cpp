@@ -0,0 +1,176 @@
+#include "chartdataset.h"
+
+#include <QFileInfo>
+#include <QtConcurrent>
+
+namespace
+{
+// the datasets by canonical path, weak so the windows holding them decide how long they live
+QHash<QString, QWeakPointer<ChartDataset>>& registry()
+{
+    static QHash<QString, QWeakPointer<ChartDataset>> datasets;
+    return datasets;
+}
+
+QString registryKey(const QString& filePath)
+{
+    const QFileInfo info(filePath);
+    const QString canonical = info.canonicalFilePath();
+    return canonical.isEmpty() ? info.absoluteFilePath() : canonical;
+}
+
+QCPDataColumn::Type columnType(CsvColumn::Type type)
+{
+    switch (type)
+    {
+    case CsvColumn::Int64:
+        return QCPDataColumn::ctInt64;
+    case CsvColumn::UInt64:
+        return QCPDataColumn::ctUInt64;
+    case CsvColumn::Float32:
+        return QCPDataColumn::ctFloat32;
+    case CsvColumn::Float64:
+        break;
+    }
+    return QCPDataColumn::ctFloat64;
+}
+
+template <class DataType>
+void view(QSharedPointer<QCPDataContainer<DataType>>& container, const QVector<QCPDataColumn>& columns, qsizetype rows)
+{
+    if (!container)
+    {
+        container.reset(new QCPDataContainer<DataType>);
+    }
+    container->setView(columns, int(rows));
+}
+} // namespace
+
+ChartDataset::ChartDataset(const QString& filePath)
+    : filePath(filePath)
+    , pyramidWatcher(new QFutureWatcher<QVector<BarPyramid::Level>>(this))
+{
+    connect(pyramidWatcher, &QFutureWatcher<QVector<BarPyramid::Level>>::finished, this,
+            &ChartDataset::onPyramidBuilt);
+}
+
+QSharedPointer<ChartDataset> ChartDataset::find(const QString& filePath)
+{
+    return registry().value(registryKey(filePath)).toStrongRef();
+}
+
+QSharedPointer<ChartDataset> ChartDataset::create(const QString& filePath)
+{
+    //entries of datasets every window has let go of are dropped on the way
+    QHash<QString, QWeakPointer<ChartDataset>>& datasets = registry();
+    for (auto entry = datasets.begin(); entry != datasets.end();)
+    {
+        entry = entry.value().isNull() ? datasets.erase(entry) : std::next(entry);
+    }
+    QSharedPointer<ChartDataset> dataset(new ChartDataset(filePath));
+    datasets.insert(registryKey(filePath), dataset);
+    return dataset;
+}
+
+void ChartDataset::acquireIndicator(const QString& key)
+{
+    ++indicatorUsers[key];
+}
+
+void ChartDataset::releaseIndicator(const QString& key)
+{
+    auto users = indicatorUsers.find(key);
+    if (users == indicatorUsers.end() || --users->second > 0)
+    {
+        return;
+    }
+    //the last window drawing the indicator gives its column back, enabling it again parses it again
+    indicatorUsers.erase(users);
+    indicators.erase(key);
+    if (store.hasValues(store.id(key)))
+    {
+        store.removeColumn(store.id(key));
+    }
+}
+
+void ChartDataset::viewColumns()
+{
+    //the containers are repointed in place, so the plottables of every window sharing them follow
+    const QCPDataColumn key = column(keyId);
+    const qsizetype rows = store.rowCount(keyId);
+    view(candles,
+         {key, column(store.id("price_open")), column(store.id("price_high")), column(store.id("price_low")),
+          column(store.id("price_close"))},
+         rows);
+    view(volume, {key, column(store.id("volume"))}, rows);
+    for (auto& [name, indicator] : indicators)
+    {
+        view(indicator, {key, column(store.id(name))}, rows);
+    }
+}
+
+void ChartDataset::viewIndicator(const QString& key)
+{
+    view(indicators[key], {column(keyId), column(store.id(key))}, store.rowCount(keyId));
+}
+
+void ChartDataset::buildPyramid()
+{
+    takeBarSeconds();
+    pyramid.clear();
+    if (pyramidWatcher->isRunning())
+    {
+        pyramidStale = true;
+        return;
+    }
+    //the worker reads copies of the containers, which share the held points or viewed columns with them, and of
+    // the sessions, which appended rows extend meanwhile
+    const QCPFinancialDataContainer candleBars = *candles;
+    const QCPBarsDataContainer volumeBars = *volume;
+    const QSharedPointer<const SessionCalendar> calendar(sessions ? new SessionCalendar(*sessions) : nullptr);
+    pyramidTimer.start();
+    pyramidWatcher->setFuture(QtConcurrent::run(
+        [candleBars, volumeBars, calendar]() { return BarPyramid::build(candleBars, volumeBars, calendar.data()); }));
+}
+
+void ChartDataset::updatePyramid(bool appendedBehind)
+{
+    if (!appendedBehind)
+    {
+        buildPyramid();
+        return;
+    }
+    takeBarSeconds();
+    //a running build merges the bars appended meanwhile when it is done
+    if (!pyramidWatcher->isRunning())
+    {
+        BarPyramid::extend(pyramid, *candles, *volume, sessions.data());
+    }
+}
+
+void ChartDataset::onPyramidBuilt()
+{
+    if (pyramidStale)
+    {
+        pyramidStale = false;
+        buildPyramid();
+        return;
+    }
+    pyramid = pyramidWatcher->result();
+    BarPyramid::extend(pyramid, *candles, *volume, sessions.data());
+    emit pyramidBuilt(pyramidTimer.nsecsElapsed());
+}
+
+QCPDataColumn ChartDataset::column(SeriesStore::ColumnId id) const
+{
+    return QCPDataColumn(columnType(store.type(id)), store.buffer(id), store.validityWords(id));
+}
+
+void ChartDataset::takeBarSeconds()
+{
+    const double seconds = BarPyramid::barSeconds(*candles);
+    if (seconds > 0)
+    {
+        barSeconds = seconds;
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef CHARTDATASET_H
+#define CHARTDATASET_H
+
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QObject>
+#include "barpyramid.h"
+#include "dataset.h"
+#include "qcustomplot.h"
+#include "seriesstore.h"
+#include "sessioncalendar.h"
+
+// The loaded data of one source, shared by every ChartWindow showing it: the
+// columns and the plottable containers the windows' plottables draw from. A
+// process wide registry maps sources to the dataset loaded from them while some
+// window holds it, so opening a source again shares it instead of loading a copy.
+// The last window letting go frees it. Rows appended by one window are appended
+// to the shared containers and announced to all of them. Gui thread only.
+class ChartDataset : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ChartDataset(const QString& filePath);
+
+    // the store column of the session coordinates of the timestamps, not part of the header
+    static inline const QString SessionKeyName = QStringLiteral("timestamp session");
+
+    // the dataset of filePath while a window holds one, null otherwise
+    static QSharedPointer<ChartDataset> find(const QString& filePath);
+    // a new empty dataset of filePath, which later calls of find return in place of an older one
+    static QSharedPointer<ChartDataset> create(const QString& filePath);
+
+    // an indicator's column and container are kept while a window draws it
+    void acquireIndicator(const QString& key);
+    void releaseIndicator(const QString& key);
+
+    // points the containers at the store's columns, so the plottables draw from them without a copy
+    // of the points. Called again after rows are appended, the store may have moved them
+    void viewColumns();
+    void viewIndicator(const QString& key);
+
+    // builds the pyramid of the candles and volume on a worker thread, rebuilt by later calls
+    void buildPyramid();
+    // merges bars appended to the containers into the pyramid, or rebuilds it if they went in before
+    // the bars already there
+    void updatePyramid(bool appendedBehind);
+
+    QString filePath;
+    // of the source as it was read, a later open reads it again once that changed
+    Dataset::Stamp stamp;
+    QStringList header;
+    SeriesStore store;
+    SeriesStore::ColumnId timestampId = SeriesStore::NoColumn;
+    // the column the views take their keys from, the timestamps or their session coordinates
+    SeriesStore::ColumnId keyId = SeriesStore::NoColumn;
+    // the trading sessions the keys of the containers are given in, null if they are the timestamps
+    QSharedPointer<SessionCalendar> sessions;
+    bool keysSorted = true; // the stored rows ascend by timestamp, so rows can be found by key
+    bool viewed = false;    // the containers view the store's columns rather than holding copies
+    QSharedPointer<QCPFinancialDataContainer> candles;
+    // the candles in single precision while they aren't viewed from the store, candles views them
+    QCPCompactFinancialData compactCandles;
+    QSharedPointer<QCPBarsDataContainer> volume;
+    std::unordered_map<QString, QSharedPointer<QCPGraphDataContainer>> indicators;
+    // coarser timeframes of candles and volume for zoomed out charts, empty until built
+    QVector<BarPyramid::Level> pyramid;
+    // the timeframe of the candles, taken with the pyramid, a minute until there are two
+    double barSeconds = 60;
+
+    //tail follow of the source, the first window to see new rows appends them for all
+    qint64 followOffset = 0;
+    bool followable = false;
+
+signals:
+    // rows were appended to the store and containers, with the range of their points
+    void rowsAppended(double minX, double minY, double maxX, double maxY);
+    // the column and container of an indicator were loaded
+    void indicatorAdded(const QString& key);
+    // the pyramid was built, buildNs after buildPyramid was called
+    void pyramidBuilt(qint64 buildNs);
+
+private:
+    QCPDataColumn column(SeriesStore::ColumnId id) const;
+    void takeBarSeconds();
+    void onPyramidBuilt();
+
+    std::unordered_map<QString, int> indicatorUsers;
+    QFutureWatcher<QVector<BarPyramid::Level>>* pyramidWatcher;
+    QElapsedTimer pyramidTimer;
+    bool pyramidStale = false; // bars went in before the ones the running build reads
+};
+
+#endif // CHARTDATASET_H
@@ -1,4 +1,139 @@
 #include "chartwindow.h"
+#include "arrowfile.h"
+#include "chartdataset.h"
+#include "columncache.h"
+#include "csvparser.h"
+#include "csvscanner.h"
+#include "dataset.h"
+#include "seriesfile.h"
+
+#include <QtConcurrent>
+
+namespace
+{
+//columns every chart needs, the others in a csv are indicators drawn over the candles
+const QStringList ChartColumns = {"timestamp", "price_open", "price_high", "price_low", "price_close", "volume"};
+const QColor IndicatorColors[] = {Qt::blue, Qt::darkYellow, Qt::magenta, Qt::darkCyan, Qt::darkGray};
+//the part of its timeframe a candle or volume bar covers, 50 s of minute bars
+constexpr double BarFill = 50.0 / 60.0;
+
+//timestamps and volumes are kept exact, other columns get their inferred type unless the user opted them
+// into single precision, which halves a price column but rounds it to about 7 digits
+std::unordered_map<QString, CsvColumn::Type> columnSchema(const QStringList& keys, const QStringList& singlePrecision)
+{
+    std::unordered_map<QString, CsvColumn::Type> schema;
+    for (const QString& key : keys)
+    {
+        if (singlePrecision.contains(key))
+        {
+            schema[key] = CsvColumn::Float32;
+        }
+    }
+    schema["timestamp"] = CsvColumn::Int64;
+    schema["volume"] = CsvColumn::UInt64;
+    return schema;
+}
+
+//below this many points per thread sorting isn't split up
+const qsizetype MinSortPointsPerThread = 64 * 1024;
+
+// sorts points by key on all cores: runs are sorted concurrently, then neighbouring runs merged pairwise
+template <class DataType>
+void sortByKey(QVector<DataType>& points)
+{
+    const int runs = int(qMin<qsizetype>(QThread::idealThreadCount(), points.size() / MinSortPointsPerThread));
+    DataType* data = points.data();
+    if (runs <= 1)
+    {
+        std::sort(data, data + points.size(), qcpLessThanSortKey<DataType>);
+        return;
+    }
+    QVector<qsizetype> bounds;
+    QVector<int> starts;
+    for (int run = 0; run <= runs; ++run)
+    {
+        bounds.append(points.size() * run / runs);
+        starts.append(run);
+    }
+    starts.removeLast();
+    QtConcurrent::blockingMap(starts, [data, &bounds](int run)
+                              { std::sort(data + bounds[run], data + bounds[run + 1], qcpLessThanSortKey<DataType>); });
+    for (int width = 1; width < runs; width *= 2)
+    {
+        starts.clear();
+        for (int run = 0; run + width < runs; run += 2 * width)
+        {
+            starts.append(run);
+        }
+        QtConcurrent::blockingMap(starts,
+                                  [data, &bounds, width, runs](int run)
+                                  {
+                                      std::inplace_merge(data + bounds[run], data + bounds[run + width],
+                                                         data + bounds[qMin(run + 2 * width, runs)],
+                                                         qcpLessThanSortKey<DataType>);
+                                  });
+    }
+}
+
+// true if the plottables can draw the rows of table from its columns in place: every row has a
+// timestamp, prices and a volume, and the timestamps ascend
+bool viewable(const CsvTable& table)
+{
+    for (const QString& key : ChartColumns)
+    {
+        const qsizetype index = table.keys.indexOf(key);
+        if (index < 0 || !table.columns.at(index).allValid())
+        {
+            return false;
+        }
+    }
+    const CsvColumn& timestamp = table.columns.at(table.keys.indexOf("timestamp"));
+    for (qsizetype i = 1; i < timestamp.size(); i++)
+    {
+        if (timestamp.value(i) < timestamp.value(i - 1))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// extends sessions by the valid timestamps after the key after, which are sorted first if they don't ascend
+void extendSessions(SessionCalendar& sessions, const CsvColumn& timestamp, double after)
+{
+    QVector<double> keys;
+    keys.reserve(timestamp.size());
+    for (const CsvColumn::Span& span : timestamp.validSpans())
+    {
+        for (qsizetype i = span.begin; i < span.end; i++)
+        {
+            if (timestamp.value(i) > after)
+            {
+                keys.append(timestamp.value(i));
+            }
+        }
+    }
+    if (!std::is_sorted(keys.constBegin(), keys.constEnd()))
+    {
+        std::sort(keys.begin(), keys.end());
+    }
+    sessions.extend(keys);
+}
+
+// a container holding points, which are only sorted if they aren't already. The container shares
+// the vector rather than copying it, and skips its own sort
+template <class DataType>
+QSharedPointer<QCPDataContainer<DataType>> toContainer(QVector<DataType>& points, bool sorted)
+{
+    if (!sorted)
+    {
+        sortByKey(points);
+    }
+    QSharedPointer<QCPDataContainer<DataType>> container(new QCPDataContainer<DataType>);
+    container->set(points, true);
+    return container;
+}
+} // namespace
 
 ChartWindow::ChartWindow(QWidget *parent)
     : QMainWindow{parent}
@@ -18,6 +153,83 @@ ChartWindow::ChartWindow(QWidget *parent)
     fileMenu->addAction(openFileAction);
     /*set open file interaction*/
     connect(openFileAction, &QAction::triggered, this, &ChartWindow::openFileActionFn);
+    openDatasetAction = new QAction(tr("Open &Directory..."), this);
+    fileMenu->addAction(openDatasetAction);
+    /*load every file of a directory as one series*/
+    connect(openDatasetAction, &QAction::triggered, this, &ChartWindow::openDatasetActionFn);
+    openPatternAction = new QAction(tr("Open &Pattern..."), this);
+    fileMenu->addAction(openPatternAction);
+    /*load the files matching a glob pattern as one series*/
+    connect(openPatternAction, &QAction::triggered, this, &ChartWindow::openPatternActionFn);
+    cancelLoadAction = new QAction(tr("&Cancel loading"), this);
+    cancelLoadAction->setEnabled(false);
+    fileMenu->addAction(cancelLoadAction);
+    connect(cancelLoadAction, &QAction::triggered, this, &ChartWindow::cancelLoad);
+    followAction = new QAction(tr("&Follow"), this);
+    followAction->setCheckable(true);
+    fileMenu->addAction(followAction);
+    //filled with the indicator columns of each loaded file
+    indicatorsMenu = menuBar->addMenu(tr("&Indicators"));
+    enabledIndicators = QStringList{"sma9"};
+    /*ingest rows appended to the open file as they are written*/
+    connect(followAction, &QAction::toggled, this, &ChartWindow::updateFollowWatch);
+    followWatcher = new QFileSystemWatcher(this);
+    connect(followWatcher, &QFileSystemWatcher::fileChanged, this, &ChartWindow::onFollowedFileChanged);
+    convertAction = new QAction(tr("Con&vert csv to series..."), this);
+    fileMenu->addAction(convertAction);
+    /*write a csv file as a compressed series file*/
+    connect(convertAction, &QAction::triggered, this, &ChartWindow::convertActionFn);
+    viewMenu = menuBar->addMenu(tr("&View"));
+    autoFitAction = new QAction(tr("&Auto-fit price axis"), this);
+    autoFitAction->setCheckable(true);
+    viewMenu->addAction(autoFitAction);
+    /*fit the price and volume axes to the visible bars whenever the time axis pans or zooms*/
+    connect(autoFitAction, &QAction::toggled, this,
+            [this](bool enabled)
+            {
+                if (enabled)
+                {
+                    fitValueAxes(customPlot->xAxis->range());
+                    customPlot->replot();
+                }
+            });
+    sessionAxisAction = new QAction(tr("Hide non-&trading time"), this);
+    sessionAxisAction->setCheckable(true);
+    sessionAxisAction->setChecked(true);
+    viewMenu->addAction(sessionAxisAction);
+    /*leave nights, weekends and holidays out of the time axis, the keys are converted as the source is read again*/
+    connect(sessionAxisAction, &QAction::toggled, this,
+            [this]()
+            {
+                if (dataset)
+                {
+                    loadFile(dataset->filePath, true);
+                }
+            });
+    //filled with the columns of each loaded file, checking one reloads it with that column in single precision
+    precisionMenu = viewMenu->addMenu(tr("Single &precision columns"));
+    convertWatcher = new QFutureWatcher<QString>(this);
+    connect(convertWatcher, &QFutureWatcher<QString>::finished, this,
+            [this]()
+            {
+                logBasic(convertWatcher->result());
+                convertAction->setEnabled(true);
+            });
+
+    //files are loaded on a worker thread, the status bar shows how far along it is
+    loadProgressBar = new QProgressBar(this);
+    loadProgressBar->setRange(0, 100);
+    loadProgressBar->setMaximumWidth(300);
+    loadProgressBar->hide();
+    statusBar()->addPermanentWidget(loadProgressBar);
+    loadProgressTimer = new QTimer(this);
+    loadProgressTimer->setInterval(100);
+    connect(loadProgressTimer, &QTimer::timeout, this, &ChartWindow::updateLoadProgress);
+    loadWatcher = new QFutureWatcher<ChartData>(this);
+    connect(loadWatcher, &QFutureWatcher<ChartData>::finished, this, &ChartWindow::onLoadFinished);
+    loadBytesTotal = 0;
+    columnWatcher = new QFutureWatcher<ChartData>(this);
+    connect(columnWatcher, &QFutureWatcher<ChartData>::finished, this, &ChartWindow::onColumnsLoaded);
 
     customPlot = new QCustomPlot(this);
     customPlot->setMouseTracking(true);
@@ -60,6 +272,9 @@ ChartWindow::ChartWindow(QWidget *parent)
     //tie the volume and candlestick axis range zoom/drags together
     connect(customPlot->xAxis, SIGNAL(rangeChanged(QCPRange)), volumeAxisRect->axis(QCPAxis::atBottom), SLOT(setRange(QCPRange)));
     connect(volumeAxisRect->axis(QCPAxis::atBottom), SIGNAL(rangeChanged(QCPRange)), customPlot->xAxis, SLOT(setRange(QCPRange)));
+    //the bars shown and the value axes follow before the replot the range change is part of
+    connect(customPlot->xAxis, qOverload<const QCPRange&>(&QCPAxis::rangeChanged), this, &ChartWindow::showLevel);
+    connect(customPlot->xAxis, qOverload<const QCPRange&>(&QCPAxis::rangeChanged), this, &ChartWindow::fitValueAxes);
 
     //set layout
     QVBoxLayout* mainLayout = new QVBoxLayout;
@@ -75,160 +290,1124 @@ ChartWindow::ChartWindow(QWidget *parent)
     logBasic("MainWindow initialized\n");
 }
 
+ChartWindow::~ChartWindow()
+{
+    cancelLoad();
+    releaseDataset();
+}
+
 void ChartWindow::openFileActionFn()
 {
     QString filePath = QFileDialog::getOpenFileName(this, tr("Open File"), QDir::homePath());
+    if (!filePath.isEmpty())
+    {
+        loadFile(filePath);
+    }
+}
+
+void ChartWindow::openDatasetActionFn()
+{
+    const QString dirPath = QFileDialog::getExistingDirectory(this, tr("Open Directory"), QDir::homePath());
+    if (!dirPath.isEmpty())
+    {
+        loadFile(dirPath);
+    }
+}
+
+void ChartWindow::openPatternActionFn()
+{
+    const QString pattern = QInputDialog::getText(this, tr("Open Pattern"), tr("Files matching:"), QLineEdit::Normal,
+                                                  QDir(QDir::homePath()).filePath("*.csv"));
+    if (!pattern.isEmpty())
+    {
+        loadFile(pattern);
+    }
+}
+
+void ChartWindow::loadFile(const QString& filePath, bool reload)
+{
+    cancelLoad(); // a newer load replaces one that is still running
+    log("Opening %1\n", filePath);
+    QSharedPointer<ChartDataset> shared = reload ? QSharedPointer<ChartDataset>() : ChartDataset::find(filePath);
+    const bool sessionAxis = sessionAxisAction->isChecked();
+    //a dataset keyed by the other time axis, or read before its source changed, is loaded again rather than shared
+    if (shared && shared->stamp != Dataset::stamp(filePath))
+    {
+        log("%1 changed since it was loaded, reading it again\n", filePath);
+    }
+    else if (shared && shared->sessions.isNull() != sessionAxis)
+    {
+        log("%1 rows already loaded by another window\n", QString::number(shared->store.rowCount(shared->timestampId)));
+        showDataset(shared);
+        return;
+    }
+    loadState.reset(new LoadState);
+    loadBytesTotal = 0;
+    for (const QString& file : Dataset::isDataset(filePath) ? Dataset::files(filePath) : QStringList{filePath})
+    {
+        loadBytesTotal += QFileInfo(file).size();
+    }
+    loadProgressBar->setValue(0);
+    loadProgressBar->show();
+    loadProgressTimer->start();
+    cancelLoadAction->setEnabled(true);
+
+    //only the chart and enabled indicator columns are parsed, others when they get enabled
+    const QStringList projection = ChartColumns + enabledIndicators;
+    const QStringList singlePrecision = singlePrecisionKeys;
+    QSharedPointer<LoadState> state = loadState;
+    loadWatcher->setFuture(
+        QtConcurrent::run([filePath, projection, singlePrecision, state, sessionAxis]()
+                          { return loadChartData(filePath, projection, singlePrecision, state, sessionAxis); }));
+}
+
+void ChartWindow::convertActionFn()
+{
+    const QString csvPath = QFileDialog::getOpenFileName(this, tr("Convert File"), QDir::homePath());
+    if (csvPath.isEmpty())
+    {
+        return;
+    }
+    const QFileInfo csvInfo(csvPath);
+    const QString seriesPath = QFileDialog::getSaveFileName(
+        this, tr("Save Series"), csvInfo.dir().filePath(csvInfo.completeBaseName() + "." + SeriesFile::fileSuffix()),
+        tr("Series files (*.%1)").arg(SeriesFile::fileSuffix()));
+    if (seriesPath.isEmpty())
+    {
+        return;
+    }
+    log("Converting %1\n", csvPath);
+    convertAction->setEnabled(false);
+    convertWatcher->setFuture(
+        QtConcurrent::run([csvPath, seriesPath]() { return convertToSeries(csvPath, seriesPath); }));
+}
+
+QString ChartWindow::convertToSeries(const QString& csvPath, const QString& seriesPath)
+{
     try
     {
-        readCsv(filePath);
+        QFile csvfile(csvPath);
+        if (!csvfile.open(QIODevice::ReadOnly))
+        {
+            throw std::runtime_error(QString("Error opening %1").arg(csvPath).toStdString());
+        }
+        QElapsedTimer timer;
+        timer.start();
+        //every column is converted with inferred types, not the chart's single precision, so the
+        // series keeps the values of the csv exactly
+        const int threadCount = QThread::idealThreadCount();
+        const CsvTable table = CsvParser().parseMapped(csvfile, threadCount);
+        if (!SeriesFile::write(seriesPath, table, threadCount))
+        {
+            throw std::runtime_error(QString("Error writing %1").arg(seriesPath).toStdString());
+        }
+        const qint64 seriesSize = QFileInfo(seriesPath).size();
+        return QString("Converted %1 rows to %2 in %3 ms, %4 MB of csv to %5 MB (%6x smaller)\n")
+            .arg(QString::number(table.rowCount()), seriesPath, QString::number(timer.elapsed()),
+                 QString::number(csvfile.size() / 1e6, 'f', 1), QString::number(seriesSize / 1e6, 'f', 1),
+                 QString::number(double(csvfile.size()) / qMax<qint64>(seriesSize, 1), 'f', 1));
+    }
+    catch (std::exception& e)
+    {
+        return QString("Caught exception: %1\n").arg(QString::fromUtf8(e.what()));
+    }
+}
+
+void ChartWindow::cancelLoad()
+{
+    if (loadState)
+    {
+        loadState->cancelled = true;
+    }
+}
+
+void ChartWindow::updateLoadProgress()
+{
+    if (loadState && loadBytesTotal > 0)
+    {
+        loadProgressBar->setValue(int(qMin<qint64>(loadState->bytesParsed * 100 / loadBytesTotal, 100)));
+    }
+}
+
+void ChartWindow::readCsv(ChartData& data, LoadState& state)
+{
+    if (Dataset::isDataset(data.filePath))
+    {
+        readDataset(data, state);
+        return;
+    }
+    QFile csvfile(data.filePath);
+    if (!csvfile.open(QIODevice::ReadOnly))
+    {
+        throw std::runtime_error(QString("Error opening %1").arg(data.filePath).toStdString());
+    }
+    data.fileSize = csvfile.size();
+
+    QElapsedTimer timer;
+    timer.start();
+    if (SeriesFile::isSeriesFile(data.filePath))
+    {
+        data.fromSeries = true;
+        data.table = SeriesFile::read(data.filePath, data.projection, data.threadCount);
+        data.parseNs = qMax<qint64>(timer.nsecsElapsed(), 1);
+        state.bytesParsed += data.fileSize;
+        return;
+    }
+    if (ArrowFile::isArrowFile(data.filePath))
+    {
+        data.fromArrow = true;
+        data.table = ArrowFile::read(data.filePath, data.projection);
+        data.parseNs = qMax<qint64>(timer.nsecsElapsed(), 1);
+        state.bytesParsed += data.fileSize;
+        return;
+    }
+    const std::unordered_map<QString, CsvColumn::Type> schema = columnSchema(data.projection, data.singlePrecision);
+    if (ColumnCache::load(data.filePath, data.projection, schema, data.table))
+    {
+        data.fromCache = true;
+        data.parseNs = qMax<qint64>(timer.nsecsElapsed(), 1);
+        state.bytesParsed += data.fileSize;
+        return;
+    }
+
+    //large files are memory mapped and parsed on the threads the load may use, small ones streamed
+    data.threadCount = data.fileSize >= CsvParser::MinBytesPerThread * 2 ? data.threadCount : 1;
+    CsvParser parser;
+    parser.setProgress(&state.bytesParsed);
+    parser.setCancelFlag(&state.cancelled);
+    parser.setProjection(data.projection);
+    parser.setSchema(schema);
+    //a followed file may be mid write, its last line is left to the tail reader until it ends
+    parser.setHoldPartialLine(!data.datasetPart);
+    data.table = data.threadCount > 1 ? parser.parseMapped(csvfile, data.threadCount) : parser.parse(csvfile);
+    data.parseNs = qMax<qint64>(timer.nsecsElapsed(), 1);
+
+    ColumnCache::store(data.filePath, data.table); // best effort, the csv directory may be read only
+}
+
+void ChartWindow::readDataset(ChartData& data, LoadState& state)
+{
+    const QStringList files = Dataset::files(data.filePath);
+    if (files.isEmpty())
+    {
+        throw std::runtime_error(QString("No csv, series or arrow files in %1").arg(data.filePath).toStdString());
+    }
 
-        minX = std::numeric_limits<double>::max();
-        minY = std::numeric_limits<double>::max();
-        maxX = std::numeric_limits<double>::min();
-        maxY = std::numeric_limits<double>::min();
+    //the files are read on a thread each, a year of daily files keeps every core busy without splitting any
+    QElapsedTimer timer;
+    timer.start();
+    const QStringList projection = data.projection;
+    const QStringList singlePrecision = data.singlePrecision;
+    const QVector<ChartData> parts = QtConcurrent::blockingMapped<QVector<ChartData>>(
+        files,
+        [&projection, &singlePrecision, &state](const QString& file)
+        {
+            ChartData part;
+            part.filePath = file;
+            part.projection = projection;
+            part.singlePrecision = singlePrecision;
+            part.datasetPart = true;
+            try
+            {
+                readCsv(part, state);
+            }
+            catch (CsvParser::Cancelled&)
+            {
+                part.cancelled = true;
+            }
+            catch (std::exception& e)
+            {
+                part.error = QString::fromUtf8(e.what());
+            }
+            return part;
+        });
 
-        //TODO: make it so we can add multiple indicators
-        indicatorsPlot = customPlot->addGraph();
-        indicatorsPlot->setPen(QPen(Qt::blue));
+    QVector<CsvTable> tables;
+    tables.reserve(parts.size());
+    for (const ChartData& part : parts)
+    {
+        if (part.cancelled)
+        {
+            throw CsvParser::Cancelled();
+        }
+        if (!part.error.isEmpty())
+        {
+            throw std::runtime_error(part.error.toStdString());
+        }
+        data.fileSize += part.fileSize;
+        tables.append(part.table);
+    }
+    data.table = Dataset::merge(std::move(tables));
+    data.fileCount = files.size();
+    data.parseNs = qMax<qint64>(timer.nsecsElapsed(), 1);
+}
 
-        // assuming keys always contain timestamp, price_open, price_high, price_low, price_close, volume
-        log("%1 timestamps read\n", csvDataMap.at("timestamp").size());
+QVector<QCPGraphData> ChartWindow::toIndicatorPoints(const CsvColumn& timestamp, const CsvColumn& values,
+                                                     const SessionCalendar* sessions, bool* sorted)
+{
+    //indicators are only drawn where they have been calculated, the empty rows are skipped span by span
+    QVector<QCPGraphData> points;
+    points.reserve(values.size());
+    const bool timestampsComplete = timestamp.allValid();
+    double previousKey = std::numeric_limits<double>::lowest();
+    bool ascending = true;
+    for (const CsvColumn::Span& span : values.validSpans())
+    {
+        for (qsizetype i = span.begin; i < span.end; i++)
+        {
+            if (timestampsComplete || timestamp.isValid(i))
+            {
+                const double key = sessions ? sessions->toCoord(timestamp.value(i)) : timestamp.value(i);
+                ascending = ascending && previousKey <= key;
+                previousKey = key;
+                points.append(QCPGraphData(key, values.value(i)));
+            }
+        }
+    }
+    if (sorted)
+    {
+        *sorted = ascending;
+    }
+    return points;
+}
 
-        for (int i = 0; i < csvDataMap.at("timestamp").size(); i++)
+ChartWindow::PlotPoints ChartWindow::toPlotPoints(const CsvTable& table, const SessionCalendar* sessions)
+{
+    // assuming keys always contain timestamp, price_open, price_high, price_low, price_close, volume
+    auto column = [&table](const QString& key) -> const CsvColumn&
+    {
+        const qsizetype index = table.keys.indexOf(key);
+        if (index < 0)
         {
-            candlestickPlot->addData(csvDataMap.at("timestamp")[i], csvDataMap.at("price_open")[i],
-                                     csvDataMap.at("price_high")[i], csvDataMap.at("price_low")[i], csvDataMap.at("price_close")[i]);
-            volumeBars->addData(csvDataMap.at("timestamp")[i], csvDataMap.at("volume")[i]);
+            throw std::out_of_range(QString("csv file has no %1 column").arg(key).toStdString());
+        }
+        return table.columns.at(index);
+    };
+    const CsvColumn& timestamp = column("timestamp");
+    const CsvColumn& open = column("price_open");
+    const CsvColumn& high = column("price_high");
+    const CsvColumn& low = column("price_low");
+    const CsvColumn& close = column("price_close");
+    const CsvColumn& volume = column("volume");
 
-            if (csvDataMap.at("sma9").at(i) > -1e6)
+    PlotPoints points;
+    const qsizetype rows = timestamp.size();
+    points.candles.reserve(rows);
+    points.volume.reserve(rows);
+    points.minX = points.minY = std::numeric_limits<double>::max();
+    points.maxX = points.maxY = std::numeric_limits<double>::lowest();
+    //rows without a timestamp are skipped span by span, the other columns are only checked if they have gaps
+    const bool pricesComplete = open.allValid() && high.allValid() && low.allValid() && close.allValid();
+    const bool volumeComplete = volume.allValid();
+    double previousKey = std::numeric_limits<double>::lowest();
+    for (const CsvColumn::Span& span : timestamp.validSpans())
+    {
+        for (qsizetype i = span.begin; i < span.end; i++)
+        {
+            //the stored widths are converted to the doubles qcustomplot draws with here, and the
+            // order of the keys checked on the way so sorted files skip the containers' sort
+            const double key = sessions ? sessions->toCoord(timestamp.value(i)) : timestamp.value(i);
+            points.sorted = points.sorted && previousKey <= key;
+            previousKey = key;
+            if (volumeComplete || volume.isValid(i))
+            {
+                points.volume.append(QCPBarsData(key, volume.value(i)));
+            }
+            if (!pricesComplete && !(open.isValid(i) && high.isValid(i) && low.isValid(i) && close.isValid(i)))
             {
-                indicatorsPlot->addData(csvDataMap.at("timestamp")[i], csvDataMap.at("sma9").at(i));
-                updateMinMaxAxisValues(csvDataMap["timestamp"][i], csvDataMap["price_high"][i]);
+                continue;
             }
+            const double highValue = high.value(i);
+            points.candles.append(QCPFinancialData(key, open.value(i), highValue, low.value(i), close.value(i)));
+            points.minX = qMin(points.minX, key);
+            points.maxX = qMax(points.maxX, key);
+            points.minY = qMin(points.minY, highValue);
+            points.maxY = qMax(points.maxY, highValue);
+        }
+    }
+
+    //every other parsed column is an indicator. Its points are of a subset of the rows, so they ascend
+    // if points.sorted says the rows do
+    for (qsizetype keyIndex = 0; keyIndex < table.keys.size(); keyIndex++)
+    {
+        const QString& key = table.keys.at(keyIndex);
+        if (!ChartColumns.contains(key))
+        {
+            points.indicators[key] = toIndicatorPoints(timestamp, table.columns.at(keyIndex), sessions);
         }
+    }
+    return points;
+}
 
-        //automatically converts the unixtimestamp into string datetime
-        QSharedPointer<QCPAxisTickerDateTime> dateTimeTicker(new QCPAxisTickerDateTime);
-        customPlot->xAxis->setTicker(dateTimeTicker);
-        customPlot->xAxis->setTickLength(csvDataMap.at("timestamp").size());
-        dateTimeTicker->setDateTimeFormat("yyyy-MM-dd\nhh:mm:ss");
+CsvColumn ChartWindow::toSessionKeys(const CsvColumn& timestamp, const SessionCalendar& sessions)
+{
+    CsvColumn keys(CsvColumn::Float64);
+    keys.reserve(timestamp.size());
+    const bool timestampsComplete = timestamp.allValid();
+    for (qsizetype i = 0; i < timestamp.size(); i++)
+    {
+        if (timestampsComplete || timestamp.isValid(i))
+        {
+            keys.appendValue(sessions.toCoord(timestamp.value(i)));
+        }
+        else
+        {
+            keys.appendMissing();
+        }
+    }
+    return keys;
+}
 
-        QSharedPointer<QCPAxisTickerDateTime> volumeDateTimeTicker(new QCPAxisTickerDateTime);
-        volumeAxisRect->axis(QCPAxis::atBottom)->setTicker(volumeDateTimeTicker);
-        volumeDateTimeTicker->setDateTimeFormat("yyyy-MM-dd\nhh:mm:ss");
+ChartWindow::ChartData ChartWindow::loadChartData(const QString& filePath, const QStringList& projection,
+                                                  const QStringList& singlePrecision, QSharedPointer<LoadState> state,
+                                                  bool sessionAxis)
+{
+    ChartData data;
+    data.filePath = filePath;
+    data.projection = projection;
+    data.singlePrecision = singlePrecision;
+    data.threadCount = QThread::idealThreadCount();
+    //taken first, rows written while the source is read make the stamp stale rather than get lost
+    data.stamp = Dataset::stamp(filePath);
+    try
+    {
+        readCsv(data, *state);
 
-        candlestickPlot->setWidth(50);
-        candlestickPlot->rescaleAxes();
-        volumeBars->setWidth(50);
-        volumeBars->rescaleAxes();
-        customPlot->legend->setVisible(true);
-        customPlot->replot();
+        //the plottable containers are filled here too, so the gui thread only swaps them in. Complete
+        // rows in timestamp order need none, the containers view the columns once they are stored
+        QElapsedTimer timer;
+        timer.start();
+        //on a session axis the keys are the timestamps' session coordinates, converted once here rather
+        // than on every draw. Viewed containers get them as a column of their own
+        const qsizetype timestampIndex = data.table.keys.indexOf("timestamp");
+        if (sessionAxis && timestampIndex >= 0)
+        {
+            data.sessions.reset(new SessionCalendar);
+            extendSessions(*data.sessions, data.table.columns.at(timestampIndex),
+                           std::numeric_limits<double>::lowest());
+        }
+        data.viewable = viewable(data.table);
+        if (data.viewable)
+        {
+            if (data.sessions)
+            {
+                data.sessionKeys = toSessionKeys(data.table.columns.at(timestampIndex), *data.sessions);
+            }
+            data.plotNs = timer.nsecsElapsed();
+            return data;
+        }
+        PlotPoints points = toPlotPoints(data.table, data.sessions.data());
+        data.minX = points.minX;
+        data.minY = points.minY;
+        data.maxX = points.maxX;
+        data.maxY = points.maxY;
+        data.sorted = points.sorted;
+        //the candles are kept in single precision columns the container views, 24 instead of 40 bytes a bar
+        if (!points.sorted)
+        {
+            sortByKey(points.candles);
+        }
+        data.compactCandles.set(points.candles, true);
+        points.candles = QVector<QCPFinancialData>();
+        data.candles.reset(new QCPFinancialDataContainer);
+        data.compactCandles.view(*data.candles);
+        data.volume = toContainer(points.volume, points.sorted);
+        for (auto& [key, indicatorPoints] : points.indicators)
+        {
+            data.indicators[key] = toContainer(indicatorPoints, points.sorted);
+        }
+        data.plotNs = timer.nsecsElapsed();
+    }
+    catch (CsvParser::Cancelled&)
+    {
+        data.cancelled = true;
     }
     catch (std::exception& e)
     {
-        log("Caught exception: %1", e.what());
+        data.error = QString::fromUtf8(e.what());
     }
+    return data;
 }
 
-void ChartWindow::updateMinMaxAxisValues(double x, double y)
+ChartWindow::ChartData ChartWindow::loadColumns(const QString& filePath, const QStringList& keys,
+                                                const QStringList& singlePrecision, qint64 sourceBytes)
 {
-    minX = qMin(minX, x);
-    maxX = qMax(maxX, x);
-    minY = qMin(minY, y);
-    maxY = qMax(maxY, y);
+    ChartData data;
+    data.filePath = filePath;
+    data.singlePrecision = singlePrecision;
+    data.projection = keys;
+    try
+    {
+        if (SeriesFile::isSeriesFile(filePath))
+        {
+            data.table = SeriesFile::read(filePath, keys, QThread::idealThreadCount());
+            return data;
+        }
+        if (ArrowFile::isArrowFile(filePath))
+        {
+            data.table = ArrowFile::read(filePath, keys);
+            return data;
+        }
+        if (Dataset::isDataset(filePath))
+        {
+            //the rows only line up with the loaded ones when they are merged by the same timestamps
+            data.projection = keys.contains("timestamp") ? keys : QStringList{"timestamp"} + keys;
+            LoadState state;
+            readDataset(data, state);
+            const qsizetype timestamp = data.table.keys.indexOf("timestamp");
+            if (!keys.contains("timestamp") && timestamp >= 0)
+            {
+                data.table.keys.removeAt(timestamp);
+                data.table.columns.removeAt(timestamp);
+            }
+            return data;
+        }
+        QFile csvfile(filePath);
+        if (!csvfile.open(QIODevice::ReadOnly))
+        {
+            throw std::runtime_error(QString("Error opening %1").arg(filePath).toStdString());
+        }
+        //stop where the loaded rows end, so the new columns line up with them
+        data.threadCount = sourceBytes >= CsvParser::MinBytesPerThread * 2 ? QThread::idealThreadCount() : 1;
+        CsvParser parser;
+        parser.setProjection(keys);
+        parser.setSchema(columnSchema(keys, singlePrecision));
+        data.table = data.threadCount > 1 ? parser.parseMapped(csvfile, data.threadCount, sourceBytes)
+                                          : parser.parse(csvfile, sourceBytes);
+    }
+    catch (std::exception& e)
+    {
+        data.error = QString::fromUtf8(e.what());
+    }
+    return data;
 }
 
-void ChartWindow::readCsv(const QString& filePath)
+void ChartWindow::onLoadFinished()
 {
-    if (!filePath.isEmpty())
+    loadProgressTimer->stop();
+    loadProgressBar->hide();
+    cancelLoadAction->setEnabled(false);
+
+    ChartData data = loadWatcher->future().takeResult();
+    if (data.cancelled)
     {
-        // QVector<double> timestamps, open, high, low, close;
-        csvDataMap.clear();
-        keyIndices.clear();
-        // int keysCount = 0;
+        log("Loading %1 cancelled\n", data.filePath);
+        return;
+    }
+    if (!data.error.isEmpty())
+    {
+        log("Caught exception: %1\n", data.error);
+        return;
+    }
 
-        QFile csvfile(filePath);
-        if (csvfile.open(QIODevice::ReadOnly))
+    if (data.fileCount > 1)
+    {
+        log("Read %1 rows from %2 files in %3 ms on %4 threads\n", QString::number(data.table.rowCount()),
+            QString::number(data.fileCount), QString::number(data.parseNs / 1000000), QString::number(data.threadCount));
+    }
+    else if (data.fromSeries)
+    {
+        log("Decoded %1 rows from %2 in %3 ms on %4 threads\n", QString::number(data.table.rowCount()),
+            data.filePath, QString::number(data.parseNs / 1000000), QString::number(data.threadCount));
+    }
+    else if (data.fromArrow)
+    {
+        log("Mapped %1 rows from %2 in %3 ms\n", QString::number(data.table.rowCount()), data.filePath,
+            QString::number(data.parseNs / 1000000));
+    }
+    else if (data.fromCache)
+    {
+        log("Loaded %1 rows from %2 in %3 ms\n", QString::number(data.table.rowCount()),
+            ColumnCache::cachePath(data.filePath), QString::number(data.parseNs / 1000000));
+    }
+    else
+    {
+        log("Parsed %1 rows in %2 ms on %3 threads (%4 rows/s, %5 MB/s, %6 scanner)\n",
+            QString::number(data.table.rowCount()), QString::number(data.parseNs / 1000000),
+            QString::number(data.threadCount), QString::number(qint64(data.table.rowCount() * 1e9 / data.parseNs)),
+            QString::number(data.fileSize * 1e3 / data.parseNs, 'f', 1), QString::fromLatin1(CsvScanner::kernelName()));
+    }
+
+    //every header column gets its id now, the ones not parsed yet get their values when enabled
+    QSharedPointer<ChartDataset> loaded = ChartDataset::create(data.filePath);
+    loaded->stamp = data.stamp;
+    SeriesStore& store = loaded->store;
+    loaded->header = data.table.header;
+    for (const QString& k : loaded->header)
+    {
+        store.intern(k);
+    }
+    loaded->timestampId = store.id("timestamp");
+    loaded->keyId = loaded->timestampId;
+    loaded->keysSorted = data.sorted;
+    loaded->sessions = data.sessions;
+    logBasic("Found csvkeys: ");
+    for (const QString& k : loaded->header)
+    {
+        log("%1, ", k);
+    }
+    logBasic("\n");
+    logBasic("Column types: ");
+    for (int keyIndex = 0; keyIndex < data.table.keys.size(); keyIndex++)
+    {
+        const QString& k = data.table.keys.at(keyIndex);
+        const CsvColumn& column = data.table.columns.at(keyIndex);
+        log("%1 %2, ", k, QString::fromLatin1(CsvColumn::typeName(column.type())));
+        store.setColumn(store.intern(k), column);
+    }
+    logBasic("\n");
+    const qint64 doubleBytes = qint64(data.table.rowCount()) * data.table.keys.size() * qint64(sizeof(double));
+    log("%1 timestamps read, columns take %2 MB (%3 MB as doubles)\n",
+        QString::number(store.rowCount(loaded->timestampId)), QString::number(store.byteSize() / 1e6, 'f', 1),
+        QString::number(doubleBytes / 1e6, 'f', 1));
+    if (data.viewable)
+    {
+        //the points aren't copied, the plottables read the stored columns
+        const qint64 pointBytes = store.rowCount(loaded->timestampId)
+                                  * qint64(sizeof(QCPFinancialData) + sizeof(QCPBarsData));
+        log("Plottables view the columns, checked in %1 ms (%2 MB of point copies saved)\n",
+            QString::number(data.plotNs / 1e6, 'f', 1), QString::number(pointBytes / 1e6, 'f', 1));
+        loaded->viewed = true;
+        if (data.sessions)
+        {
+            loaded->keyId = store.intern(ChartDataset::SessionKeyName);
+            store.setColumn(loaded->keyId, data.sessionKeys);
+        }
+        loaded->viewColumns();
+        for (const QString& k : data.table.keys)
         {
-            log("Opening %1\n", filePath);
-            QString readData = csvfile.readAll();
-            QStringList lines = readData.split("\n");
-            bool readKeys = true;
-            for (const auto& line : lines)
+            if (!ChartColumns.contains(k))
             {
-                if (readKeys)
+                loaded->viewIndicator(k);
+            }
+        }
+    }
+    else
+    {
+        log("Built plottables in %1 ms, %2, candles take %3 MB in single precision (%4 MB as points)\n",
+            QString::number(data.plotNs / 1e6, 'f', 1),
+            data.sorted ? QString("rows were in timestamp order") : QString("rows had to be sorted"),
+            QString::number(data.compactCandles.byteSize() / 1e6, 'f', 1),
+            QString::number(data.compactCandles.size() * qint64(sizeof(QCPFinancialData)) / 1e6, 'f', 1));
+        loaded->candles = data.candles;
+        loaded->compactCandles = data.compactCandles;
+        loaded->volume = data.volume;
+        loaded->indicators = data.indicators;
+    }
+    if (data.sessions)
+    {
+        log("Time axis leaves out the time between %1 trading sessions\n", QString::number(data.sessions->size()));
+    }
+    loaded->followOffset = data.table.sourceBytes;
+    //series and arrow files are written once, not appended to, and datasets get new files rather than rows
+    loaded->followable = !data.fromSeries && !data.fromArrow && !Dataset::isDataset(data.filePath);
+    loaded->buildPyramid();
+    showDataset(loaded);
+}
+
+void ChartWindow::showDataset(QSharedPointer<ChartDataset> shown)
+{
+    releaseDataset();
+    dataset = shown;
+    connect(dataset.data(), &ChartDataset::rowsAppended, this,
+            [this](double rowsMinX, double rowsMinY, double rowsMaxX, double rowsMaxY)
+            {
+                updateMinMaxAxisValues(rowsMinX, rowsMinY);
+                updateMinMaxAxisValues(rowsMaxX, rowsMaxY);
+                showLevel(customPlot->xAxis->range());
+                customPlot->replot(QCustomPlot::rpQueuedReplot);
+            });
+    connect(dataset.data(), &ChartDataset::pyramidBuilt, this,
+            [this](qint64 buildNs)
+            {
+                if (!dataset->pyramid.isEmpty())
                 {
-                    QStringList keys = line.split(",");
-                    logBasic("Found csvkeys: ");
-                    int keyIndex = 0;
-                    for (const auto& k : keys)
-                    {
-                        if (k.length() == 0)
-                        {
-                            break; // csv file might have a trailing comma
-                        }
-                        log("%1, ", k);
-                        csvDataMap[k] = QVector<double>();
-                        keyIndices[keyIndex++] = k;
-                        // keysCount++;
-                    }
-                    logBasic("\n");
-                    readKeys = false;
+                    log("Merged the bars into %1 coarser timeframes in %2 ms\n",
+                        QString::number(dataset->pyramid.size()), QString::number(buildNs / 1000000));
                 }
-                else
+                showLevel(customPlot->xAxis->range());
+                customPlot->replot();
+            });
+    connect(dataset.data(), &ChartDataset::indicatorAdded, this,
+            [this](const QString& key)
+            {
+                auto indicator = dataset->indicators.find(key);
+                if (enabledIndicators.contains(key) && !indicatorGraphs.count(key)
+                    && indicator != dataset->indicators.end())
+                {
+                    addIndicatorGraph(key, indicator->second);
+                    customPlot->replot();
+                }
+            });
+
+    //the plottables draw from the shared containers, no per point copies on the gui thread
+    candlestickPlot->setData(dataset->candles);
+    volumeBars->setData(dataset->volume);
+    for (const QString& key : enabledIndicators)
+    {
+        auto indicator = dataset->indicators.find(key);
+        if (indicator != dataset->indicators.end())
+        {
+            addIndicatorGraph(key, indicator->second);
+        }
+    }
+    populateIndicatorsMenu();
+    populatePrecisionMenu();
+
+    minX = std::numeric_limits<double>::max();
+    minY = std::numeric_limits<double>::max();
+    maxX = std::numeric_limits<double>::min();
+    maxY = std::numeric_limits<double>::min();
+    bool foundRange;
+    const QCPRange keyRange = dataset->candles->keyRange(foundRange);
+    const QCPRange valueRange = dataset->candles->valueRange(foundRange);
+    if (foundRange)
+    {
+        updateMinMaxAxisValues(keyRange.lower, valueRange.lower);
+        updateMinMaxAxisValues(keyRange.upper, valueRange.upper);
+    }
+
+    //automatically converts the unixtimestamp into string datetime, the session coordinates back to theirs first
+    auto dateTimeTicker = [this]()
+    {
+        QSharedPointer<QCPAxisTickerDateTime> ticker(dataset->sessions ? new SessionTicker(dataset->sessions)
+                                                                       : new QCPAxisTickerDateTime);
+        ticker->setDateTimeFormat("yyyy-MM-dd\nhh:mm:ss");
+        return ticker;
+    };
+    customPlot->xAxis->setTicker(dateTimeTicker());
+    customPlot->xAxis->setTickLength(dataset->store.rowCount(dataset->timestampId));
+    volumeAxisRect->axis(QCPAxis::atBottom)->setTicker(dateTimeTicker());
+
+    candlestickPlot->setWidth(dataset->barSeconds * BarFill);
+    candlestickPlot->rescaleAxes();
+    volumeBars->setWidth(dataset->barSeconds * BarFill);
+    volumeBars->rescaleAxes();
+    customPlot->legend->setVisible(true);
+    customPlot->replot();
+
+    updateFollowWatch();
+    startColumnLoad();
+}
+
+void ChartWindow::releaseDataset()
+{
+    for (auto& [key, graph] : indicatorGraphs)
+    {
+        customPlot->removeGraph(graph);
+        dataset->releaseIndicator(key);
+    }
+    indicatorGraphs.clear();
+    if (dataset)
+    {
+        disconnect(dataset.data(), nullptr, this, nullptr);
+        dataset.reset();
+    }
+}
+
+void ChartWindow::populateIndicatorsMenu()
+{
+    indicatorsMenu->clear();
+    for (const QString& key : dataset->header)
+    {
+        if (ChartColumns.contains(key))
+        {
+            continue;
+        }
+        QAction* action = indicatorsMenu->addAction(key);
+        action->setCheckable(true);
+        action->setChecked(enabledIndicators.contains(key));
+        connect(action, &QAction::toggled, this, [this, key](bool enabled) { setIndicatorEnabled(key, enabled); });
+    }
+}
+
+void ChartWindow::populatePrecisionMenu()
+{
+    precisionMenu->clear();
+    for (const QString& key : dataset->header)
+    {
+        if (key == "timestamp")
+        {
+            continue; // epoch seconds need more digits than a float has
+        }
+        QAction* action = precisionMenu->addAction(key);
+        action->setCheckable(true);
+        action->setChecked(singlePrecisionKeys.contains(key));
+        connect(action, &QAction::toggled, this,
+                [this, key](bool enabled)
                 {
-                    if (line.size() == 0)
+                    singlePrecisionKeys.removeAll(key);
+                    if (enabled)
                     {
-                        continue; // could be an empty line at the end of file
+                        singlePrecisionKeys.append(key);
                     }
-                    QStringList tokens = line.split(",");
-                    int keyIndex = 0;
-                    for (const auto& [index, key] : keyIndices)
-                    // for(int index = 0; index < keysCount; index++)
+                    if (dataset)
                     {
-                        if (tokens.at(index).size() > 0)
-                            csvDataMap.at(key).append(tokens.at(index).toDouble());
-                        else
-                            csvDataMap.at(key).append(-1e6); // use -1e6 as magic value for NaN values for any trailing
-                                // indicators that aren't calculated yet
+                        loadFile(dataset->filePath, true);
                     }
-                }
-            }
+                });
+    }
+}
+
+void ChartWindow::setIndicatorEnabled(const QString& key, bool enabled)
+{
+    enabledIndicators.removeAll(key);
+    if (enabled)
+    {
+        enabledIndicators.append(key);
+        //another window may have loaded it already
+        if (dataset && dataset->indicators.count(key))
+        {
+            addIndicatorGraph(key, dataset->indicators.at(key));
+            customPlot->replot();
+            return;
+        }
+        startColumnLoad();
+        return;
+    }
+
+    auto graph = indicatorGraphs.find(key);
+    if (graph != indicatorGraphs.end())
+    {
+        customPlot->removeGraph(graph->second);
+        indicatorGraphs.erase(graph);
+        dataset->releaseIndicator(key);
+    }
+    customPlot->replot();
+}
+
+void ChartWindow::addIndicatorGraph(const QString& key, QSharedPointer<QCPGraphDataContainer> data)
+{
+    QCPGraph* graph = customPlot->addGraph();
+    graph->setName(key);
+    graph->setPen(QPen(IndicatorColors[indicatorGraphs.size() % std::size(IndicatorColors)]));
+    graph->setData(data);
+    indicatorGraphs[key] = graph;
+    dataset->acquireIndicator(key);
+}
+
+QStringList ChartWindow::loadedKeys() const
+{
+    QStringList keys;
+    for (const QString& key : dataset->header)
+    {
+        if (dataset->store.hasValues(dataset->store.id(key)))
+        {
+            keys.append(key);
+        }
+    }
+    return keys;
+}
+
+void ChartWindow::startColumnLoad()
+{
+    if (loadWatcher->isRunning() || columnWatcher->isRunning() || !dataset)
+    {
+        return; // the running load picks the enabled indicators up when it finishes
+    }
+    QStringList missing;
+    for (const QString& key : enabledIndicators)
+    {
+        if (dataset->header.contains(key) && !dataset->store.hasValues(dataset->store.id(key)))
+        {
+            missing.append(key);
+        }
+    }
+    if (missing.isEmpty())
+    {
+        return;
+    }
+
+    log("Parsing %1 from %2\n", missing.join(", "), dataset->filePath);
+    const QString filePath = dataset->filePath;
+    const QStringList singlePrecision = singlePrecisionKeys;
+    const qint64 sourceBytes = dataset->followOffset;
+    columnWatcher->setFuture(QtConcurrent::run([filePath, missing, singlePrecision, sourceBytes]()
+                                               { return loadColumns(filePath, missing, singlePrecision, sourceBytes); }));
+}
+
+void ChartWindow::onColumnsLoaded()
+{
+    ChartData data = columnWatcher->future().takeResult();
+    if (!data.error.isEmpty())
+    {
+        log("Caught exception: %1\n", data.error);
+        return;
+    }
+    //a file opened or appended to meanwhile leaves columns that don't line up with the loaded rows
+    if (!dataset || data.filePath != dataset->filePath || !dataset->store.hasValues(dataset->timestampId)
+        || data.table.rowCount() != dataset->store.rowCount(dataset->timestampId))
+    {
+        startColumnLoad();
+        return;
+    }
+
+    SeriesStore& store = dataset->store;
+    const CsvColumn timestamp = store.view(dataset->timestampId);
+    for (int keyIndex = 0; keyIndex < data.table.keys.size(); keyIndex++)
+    {
+        const QString& k = data.table.keys.at(keyIndex);
+        const SeriesStore::ColumnId id = store.id(k);
+        if (!enabledIndicators.contains(k) || id == SeriesStore::NoColumn || store.hasValues(id))
+        {
+            continue; // disabled again while it was parsed, or loaded by another window meanwhile
+        }
+        if (dataset->viewed)
+        {
+            store.setColumn(id, data.table.columns.at(keyIndex));
+            dataset->viewIndicator(k);
         }
         else
         {
-            log("Error oepning %1\n", filePath);
+            bool sorted;
+            QVector<QCPGraphData> points =
+                toIndicatorPoints(timestamp, data.table.columns.at(keyIndex), dataset->sessions.data(), &sorted);
+            dataset->indicators[k] = toContainer(points, sorted);
+            store.setColumn(id, data.table.columns.at(keyIndex));
         }
+        emit dataset->indicatorAdded(k); // every window showing the dataset with it enabled draws it
+    }
+
+    startColumnLoad();
+    if (followAction->isChecked() && !columnWatcher->isRunning())
+    {
+        onFollowedFileChanged(dataset->filePath); // rows appended while the columns were parsed
     }
 }
 
-void ChartWindow::onMouseMove(QMouseEvent* event)
+void ChartWindow::updateFollowWatch()
+{
+    if (!followWatcher->files().isEmpty())
+    {
+        followWatcher->removePaths(followWatcher->files());
+    }
+    if (followAction->isChecked() && dataset && dataset->followable)
+    {
+        followWatcher->addPath(dataset->filePath);
+        onFollowedFileChanged(dataset->filePath); // pick up rows written since the load
+    }
+}
+
+void ChartWindow::onFollowedFileChanged(const QString& path)
 {
-    if (candlestickPlot == nullptr)
+    if (!dataset || path != dataset->filePath || !dataset->followable || loadWatcher->isRunning()
+        || columnWatcher->isRunning())
+    {
+        return;
+    }
+    if (!followWatcher->files().contains(path) && QFile::exists(path))
+    {
+        followWatcher->addPath(path); // files replaced by a rename drop out of the watcher
+    }
+
+    //every window following the dataset is told, the first one appends the rows for all of them
+    QFile csvfile(path);
+    if (!csvfile.open(QIODevice::ReadOnly) || csvfile.size() == dataset->followOffset)
+    {
+        return;
+    }
+    if (csvfile.size() < dataset->followOffset)
     {
+        log("%1 was truncated, reloading\n", path);
+        loadFile(path, true);
         return;
     }
-    QVariant details;
-    QCPFinancialDataContainer::const_iterator it = candlestickPlot->data()->constEnd();
-    if (candlestickPlot->selectTest(event->position(), true, &details))
+
+    try
     {
-        QCPDataSelection dataPoints = details.value<QCPDataSelection>();
-        if (dataPoints.dataPointCount() > 0)
+        //appended rows keep the types of the stored columns, whichever window loaded them
+        const QStringList keys = loadedKeys();
+        std::unordered_map<QString, CsvColumn::Type> schema;
+        for (const QString& key : keys)
         {
-            it = candlestickPlot->data()->at(dataPoints.dataRange().begin());
+            schema[key] = dataset->store.type(dataset->store.id(key));
+        }
+        CsvParser parser;
+        parser.setProjection(keys);
+        parser.setSchema(schema);
+        const Dataset::Stamp stamp = Dataset::stamp(path);
+        CsvTable appended = parser.parseTail(csvfile, dataset->header, dataset->followOffset);
+        dataset->followOffset = appended.sourceBytes;
+        dataset->stamp = stamp;
+        appendRows(appended);
+    }
+    catch (std::exception& e)
+    {
+        log("Caught exception: %1\n", e.what());
+    }
+}
 
-            QDateTime dateTime = QDateTime::fromSecsSinceEpoch(static_cast<quint64>(it->key));
-            QString dateString = dateTime.toString("yyyy-MM-dd hh:mm:ss");
-            // Format floating-point numbers with 2 decimal places precision
-            QString openString = QString::number(it->open, 'f', 2);
-            QString highString = QString::number(it->high, 'f', 2);
-            QString lowString = QString::number(it->low, 'f', 2);
-            QString closeString = QString::number(it->close, 'f', 2);
+void ChartWindow::appendRows(const CsvTable& appended)
+{
+    SeriesStore& store = dataset->store;
+    if (appended.rowCount() == 0 || !store.hasValues(dataset->timestampId))
+    {
+        return;
+    }
+    const qsizetype lastRow = store.rowCount(dataset->timestampId) - 1;
+    double lastKey =
+        lastRow >= 0 ? store.value(dataset->timestampId, lastRow) : std::numeric_limits<double>::lowest();
+    //new sessions are added for the rows after the last one, the views get the rows' session coordinates
+    // as a column of the store next to their timestamps
+    CsvTable rows = appended;
+    const qsizetype timestampIndex = appended.keys.indexOf("timestamp");
+    if (dataset->sessions && timestampIndex >= 0)
+    {
+        const CsvColumn& timestamp = appended.columns.at(timestampIndex);
+        extendSessions(*dataset->sessions, timestamp, lastKey);
+        lastKey = dataset->sessions->toCoord(lastKey);
+        if (dataset->keyId != dataset->timestampId)
+        {
+            rows.keys.append(ChartDataset::SessionKeyName);
+            rows.columns.append(toSessionKeys(timestamp, *dataset->sessions));
+        }
+    }
+    store.append(rows);
 
-            QString trackerText = QString("Timestamp: %1\nO: %2\nH: %3\nL: %4\nC: %5")
-                                      .arg(dateString, openString, highString, lowString, closeString);
+    //new bars normally come after the loaded ones, which views pick up from the store and
+    // containers holding points append without a merge
+    PlotPoints points = toPlotPoints(appended, dataset->sessions.data());
+    const bool behind = points.candles.isEmpty() || points.minX >= lastKey;
+    dataset->keysSorted = dataset->keysSorted && points.sorted && behind;
+    if (dataset->viewed && dataset->keysSorted && viewable(appended))
+    {
+        dataset->viewColumns();
+        dataset->updatePyramid(true);
+        emit dataset->rowsAppended(points.minX, points.minY, points.maxX, points.maxY);
+        return;
+    }
+    //rows with gaps or out of order are merged into copies, the views copy their points on the first add.
+    // The candles go to single precision columns instead, which the container views again
+    if (dataset->viewed)
+    {
+        dataset->compactCandles.set(
+            QVector<QCPFinancialData>(dataset->candles->constBegin(), dataset->candles->constEnd()), true);
+    }
+    dataset->viewed = false;
+    dataset->compactCandles.add(points.candles, points.sorted);
+    dataset->compactCandles.view(*dataset->candles);
+    dataset->volume->add(points.volume, points.sorted);
+    for (auto& [key, indicatorPoints] : points.indicators)
+    {
+        auto indicator = dataset->indicators.find(key);
+        if (indicator != dataset->indicators.end())
+        {
+            indicator->second->add(indicatorPoints, points.sorted);
+        }
+    }
+    dataset->updatePyramid(behind);
+    emit dataset->rowsAppended(points.minX, points.minY, points.maxX, points.maxY);
+}
+
+void ChartWindow::updateMinMaxAxisValues(double x, double y)
+{
+    minX = qMin(minX, x);
+    maxX = qMax(maxX, x);
+    minY = qMin(minY, y);
+    maxY = qMax(maxY, y);
+}
 
-            customPlot->setToolTip(trackerText);
+void ChartWindow::showLevel(const QCPRange& keyRange)
+{
+    if (!dataset)
+    {
+        return;
+    }
+    //zoomed out far enough, the bars of a coarser timeframe are drawn so a frame costs about a bar per pixel
+    const int level =
+        BarPyramid::choose(dataset->pyramid, *dataset->candles, keyRange, customPlot->axisRect()->width());
+    const QSharedPointer<QCPFinancialDataContainer> candles =
+        level < 0 ? dataset->candles : dataset->pyramid.at(level).candles;
+    if (candlestickPlot->data() == candles)
+    {
+        return;
+    }
+    double seconds = level < 0 ? dataset->barSeconds : dataset->pyramid.at(level).seconds;
+    //in session coordinates buckets are as far apart as the trading time in them, less than their length
+    if (level >= 0 && dataset->sessions)
+    {
+        const double step = BarPyramid::barSeconds(*candles);
+        if (step > 0)
+        {
+            seconds = qMin(seconds, step);
         }
     }
+    candlestickPlot->setData(candles);
+    candlestickPlot->setWidth(seconds * BarFill);
+    volumeBars->setData(level < 0 ? dataset->volume : dataset->pyramid.at(level).volume);
+    volumeBars->setWidth(seconds * BarFill);
+}
+
+void ChartWindow::fitValueAxes(const QCPRange& keyRange)
+{
+    if (!autoFitAction->isChecked() || !dataset)
+    {
+        return;
+    }
+    //the containers answer the high/low of any key range from their range index, not a scan of the bars
+    bool foundRange;
+    const QCPRange prices = candlestickPlot->getValueRange(foundRange, QCP::sdBoth, keyRange);
+    if (foundRange && QCPRange::validRange(prices))
+    {
+        customPlot->yAxis->setRange(prices);
+    }
+    const QCPRange volumes = volumeBars->getValueRange(foundRange, QCP::sdBoth, keyRange);
+    if (foundRange && QCPRange::validRange(volumes))
+    {
+        volumeAxisRect->axis(QCPAxis::atLeft)->setRange(volumes);
+    }
+}
+
+void ChartWindow::onMouseMove(QMouseEvent* event)
+{
+    if (candlestickPlot == nullptr || !dataset)
+    {
+        return;
+    }
+    //the bar nearest the cursor's key, located in the candles instead of hit testing every visible bar
+    QCPAxis* keyAxis = candlestickPlot->keyAxis();
+    const QPointF position = event->position();
+    const QSharedPointer<QCPFinancialDataContainer> candles = candlestickPlot->data();
+    if (!keyAxis->axisRect()->rect().contains(position.toPoint()) || candles->isEmpty())
+    {
+        return;
+    }
+    const double cursorKey = keyAxis->pixelToCoord(position.x());
+    //findBegin gives the bar before the key, the one after it may be nearer
+    QCPFinancialDataContainer::const_iterator it = candles->findBegin(cursorKey);
+    if (it + 1 != candles->constEnd() && qAbs((it + 1)->key - cursorKey) < qAbs(it->key - cursorKey))
+    {
+        ++it;
+    }
+    if (!keyAxis->range().contains(it->key))
+    {
+        return;
+    }
+
+    const double time = dataset->sessions ? dataset->sessions->toTime(it->key) : it->key;
+    QDateTime dateTime = QDateTime::fromSecsSinceEpoch(static_cast<quint64>(time));
+    QString dateString = dateTime.toString("yyyy-MM-dd hh:mm:ss");
+    // Format floating-point numbers with 2 decimal places precision
+    QString openString = QString::number(it->open, 'f', 2);
+    QString highString = QString::number(it->high, 'f', 2);
+    QString lowString = QString::number(it->low, 'f', 2);
+    QString closeString = QString::number(it->close, 'f', 2);
+
+    QString trackerText = QString("Timestamp: %1\nO: %2\nH: %3\nL: %4\nC: %5")
+                              .arg(dateString, openString, highString, lowString, closeString);
+    //indicator values of the bar's row, found by key in the store
+    const SeriesStore& store = dataset->store;
+    const qsizetype row = dataset->keysSorted && store.hasValues(dataset->timestampId)
+                              ? store.findRow(dataset->timestampId, time)
+                              : -1;
+    for (const QString& key : enabledIndicators)
+    {
+        const SeriesStore::ColumnId id = store.id(key);
+        if (row >= 0 && store.hasValues(id) && store.isValid(id, row))
+        {
+            trackerText += QString("\n%1: %2").arg(key, QString::number(store.value(id, row), 'f', 2));
+        }
+    }
+
+    customPlot->setToolTip(trackerText);
 }
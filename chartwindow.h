@@ -2,16 +2,111 @@
 #define CHARTWINDOW_H
 
 #include <QMainWindow>
+#include "csvparser.h"
+#include "dataset.h"
 #include "qcustomplot.h"
+#include "sessioncalendar.h"
+
+class ChartDataset;
 
 class ChartWindow : public QMainWindow
 {
     Q_OBJECT
 public:
     explicit ChartWindow(QWidget *parent = nullptr);
+    ~ChartWindow() override;
+
+    // state shared between the gui thread and a background load
+    struct LoadState
+    {
+        std::atomic<qint64> bytesParsed{0};
+        std::atomic<bool> cancelled{false};
+    };
+
+    // everything a load produces. Built on a worker thread and moved into the window in one step
+    struct ChartData
+    {
+        QString filePath;
+        QString error;
+        bool cancelled = false;
+        bool fromCache = false;
+        bool fromSeries = false;
+        bool fromArrow = false;
+        bool datasetPart = false; // a file of a dataset, it is read whole as it isn't followed
+        int fileCount = 1;
+        QStringList projection;
+        QStringList singlePrecision; // the columns parsed as Float32 rather than their inferred type
+        CsvTable table;
+        QSharedPointer<QCPFinancialDataContainer> candles; // a view of compactCandles
+        QCPCompactFinancialData compactCandles;
+        QSharedPointer<QCPBarsDataContainer> volume;
+        std::unordered_map<QString, QSharedPointer<QCPGraphDataContainer>> indicators;
+        // the trading sessions of the timestamps if the time axis leaves out the time between them,
+        // and the session coordinates of the rows of a viewable table
+        QSharedPointer<SessionCalendar> sessions;
+        CsvColumn sessionKeys;
+        double minX = 0, minY = 0, maxX = 0, maxY = 0;
+        int threadCount = 1;
+        qint64 parseNs = 0;
+        qint64 plotNs = 0; // building the plottable containers
+        bool sorted = true; // the rows were in timestamp order
+        bool viewable = false; // the plottables can draw from the columns, no containers were filled
+        qint64 fileSize = 0;
+        Dataset::Stamp stamp; // of the source before it was read
+    };
+
+    // plottable points of the rows of a table, in row order
+    struct PlotPoints
+    {
+        QVector<QCPFinancialData> candles;
+        QVector<QCPBarsData> volume;
+        std::unordered_map<QString, QVector<QCPGraphData>> indicators;
+        double minX, minY, maxX, maxY;
+        bool sorted = true; // keys ascend in row order
+    };
+
+    static void readCsv(ChartData& data, LoadState& state);
+    static void readDataset(ChartData& data, LoadState& state);
+    // the points of the rows values has. The keys are the timestamps, or their coordinates in sessions.
+    // sorted, if given, is set to whether they ascend
+    static QVector<QCPGraphData> toIndicatorPoints(const CsvColumn& timestamp, const CsvColumn& values,
+                                                   const SessionCalendar* sessions = nullptr, bool* sorted = nullptr);
+    static PlotPoints toPlotPoints(const CsvTable& table, const SessionCalendar* sessions = nullptr);
+    // the session coordinates of timestamp, missing where it is
+    static CsvColumn toSessionKeys(const CsvColumn& timestamp, const SessionCalendar& sessions);
+    static ChartData loadChartData(const QString& filePath, const QStringList& projection,
+                                   const QStringList& singlePrecision, QSharedPointer<LoadState> state,
+                                   bool sessionAxis);
+    static ChartData loadColumns(const QString& filePath, const QStringList& keys, const QStringList& singlePrecision,
+                                 qint64 sourceBytes);
+    static QString convertToSeries(const QString& csvPath, const QString& seriesPath);
 
     void openFileActionFn();
+    void openDatasetActionFn();
+    void openPatternActionFn();
+    // shows the dataset of filePath, shared with the windows showing it unless reload is set
+    void loadFile(const QString& filePath, bool reload = false);
+    void convertActionFn();
+    void cancelLoad();
+    void onLoadFinished();
+    void showDataset(QSharedPointer<ChartDataset> shown);
+    void releaseDataset();
+    void updateLoadProgress();
+    void updateFollowWatch();
+    void onFollowedFileChanged(const QString& path);
+    void appendRows(const CsvTable& appended);
+    void populateIndicatorsMenu();
+    void populatePrecisionMenu();
+    void setIndicatorEnabled(const QString& key, bool enabled);
+    void addIndicatorGraph(const QString& key, QSharedPointer<QCPGraphDataContainer> data);
+    void startColumnLoad();
+    void onColumnsLoaded();
+    QStringList loadedKeys() const;
     void updateMinMaxAxisValues(double x, double y);
+    // draws the pyramid level with about as many bars in keyRange as the chart is wide in pixels
+    void showLevel(const QCPRange& keyRange);
+    // fits the price and volume axes to the bars in keyRange if auto-fit is checked
+    void fitValueAxes(const QCPRange& keyRange);
     void onMouseWheel(QWheelEvent* event);
     void onMousePress(QMouseEvent* event);
     void onMouseMove(QMouseEvent* event);
@@ -50,27 +145,51 @@ public:
         appendLog(formattedMsg, customFormat);
     }
 
-    void readCsv(const QString& filePath);
-
 private:
     QWidget* centralWidget;
     QMenuBar* menuBar;
     QMenu* fileMenu;
     QAction* openFileAction;
+    QAction* openDatasetAction;
+    QAction* openPatternAction;
+    QMenu* indicatorsMenu;
+    QMenu* viewMenu;
+    QAction* autoFitAction;
+    QAction* sessionAxisAction;
+    QMenu* precisionMenu;
+    QAction* cancelLoadAction;
+    QProgressBar* loadProgressBar;
+    QTimer* loadProgressTimer;
+    QFutureWatcher<ChartData>* loadWatcher;
+    QSharedPointer<LoadState> loadState;
+    qint64 loadBytesTotal;
+
+    //the shown data, shared with other windows showing the same file
+    QSharedPointer<ChartDataset> dataset;
+
+    //tail follow of the dataset's file
+    QAction* followAction;
+    QFileSystemWatcher* followWatcher;
+    QAction* convertAction;
+    QFutureWatcher<QString>* convertWatcher;
+
+    //columns beyond the chart's are parsed the first time their indicator is enabled
+    QStringList enabledIndicators;
+    QFutureWatcher<ChartData>* columnWatcher;
+    //columns the user chose to keep in single precision, the others are parsed in double
+    QStringList singlePrecisionKeys;
 
     QCustomPlot* customPlot;
     QPointF* onMousePressRecordPoint;
     double minX, minY, maxX, maxY;
 
     QCPFinancial* candlestickPlot;
-    QCPGraph* indicatorsPlot;
+    std::unordered_map<QString, QCPGraph*> indicatorGraphs;
     QCPAxisRect* volumeAxisRect;
     QCPBars* volumeBars;
 
     QPlainTextEdit* loggerTextBox;
 
-    std::unordered_map<QString, QVector<double>> csvDataMap;
-    std::unordered_map<int, QString> keyIndices;
 signals:
 };
 
@@ -0,0 +1,239 @@
+#include "columncache.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+const char Magic[8] = {'Q', 'T', 'C', 'O', 'L', 'C', 'H', 'E'};
+const quint32 ByteOrderMark = 0x01020304;
+
+// file layout: Header, source path, csv header line, column names, one ColumnEntry
+// per column, then the columns, each followed by its validity bitmap if it has one,
+// every array starting on an Alignment boundary
+struct Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    qint64 sourceSize;
+    qint64 sourceModified;
+    qint64 parsedBytes; // the bytes of the csv the rows are from, a held partial last line isn't
+    quint64 rowCount;
+    quint32 columnCount;
+    quint32 pathLength;
+    quint32 namesLength;
+    quint32 headerLength;
+};
+static_assert(sizeof(Header) == 64, "sidecar header layout changed");
+
+struct ColumnEntry
+{
+    quint64 dataOffset;
+    quint64 validityOffset; // 0 if every row is valid
+    quint32 nameOffset;
+    quint32 nameLength;
+    quint32 type; // CsvColumn::Type
+    quint32 reserved;
+};
+static_assert(sizeof(ColumnEntry) == 32, "sidecar column entry layout changed");
+
+struct SourceInfo
+{
+    QByteArray path;
+    qint64 size;
+    qint64 modified;
+};
+
+SourceInfo sourceInfo(const QString& csvPath)
+{
+    const QFileInfo info(csvPath);
+    return {info.absoluteFilePath().toUtf8(), info.size(), info.lastModified().toMSecsSinceEpoch()};
+}
+
+//whether parsing with the schema could have given a column of this type: its declared type or an
+// inferred one, either widened to Float64 by a value it couldn't hold
+bool parsedType(const std::unordered_map<QString, CsvColumn::Type>& schema, const QString& key, CsvColumn::Type type)
+{
+    auto declared = schema.find(key);
+    if (type == CsvColumn::Float64)
+    {
+        return true;
+    }
+    return declared == schema.end() ? type == CsvColumn::Int64 : type == declared->second;
+}
+
+qint64 alignUp(qint64 offset)
+{
+    return (offset + ColumnCache::Alignment - 1) / ColumnCache::Alignment * ColumnCache::Alignment;
+}
+} // namespace
+
+QString ColumnCache::cachePath(const QString& csvPath)
+{
+    return csvPath + ".colcache";
+}
+
+bool ColumnCache::load(const QString& csvPath, const QStringList& projection,
+                       const std::unordered_map<QString, CsvColumn::Type>& schema, CsvTable& table)
+{
+    QFile file(cachePath(csvPath));
+    if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(Header)))
+    {
+        return false;
+    }
+    const qint64 fileSize = file.size();
+    uchar* mapped = file.map(0, fileSize);
+    if (mapped == nullptr)
+    {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, mapped, sizeof(Header));
+    const SourceInfo source = sourceInfo(csvPath);
+    const qint64 headerOffset = sizeof(Header) + qint64(header.pathLength);
+    const qint64 namesOffset = headerOffset + header.headerLength;
+    const qint64 entriesOffset = namesOffset + header.namesLength;
+    bool valid = std::memcmp(header.magic, Magic, sizeof(Magic)) == 0 && header.version == Version
+                 && header.byteOrder == ByteOrderMark && header.sourceSize == source.size
+                 && header.sourceModified == source.modified && header.parsedBytes >= 0
+                 && header.parsedBytes <= header.sourceSize && header.pathLength == quint32(source.path.size())
+                 && header.rowCount <= quint64(fileSize) / sizeof(float)
+                 && entriesOffset + qint64(header.columnCount) * qint64(sizeof(ColumnEntry)) <= fileSize
+                 && std::memcmp(mapped + sizeof(Header), source.path.constData(), header.pathLength) == 0;
+
+    //entries of the cached columns by name
+    const qint64 validityBytes = qint64((header.rowCount + 63) / 64) * qint64(sizeof(quint64));
+    std::unordered_map<QString, ColumnEntry> cachedColumns;
+    for (quint32 column = 0; valid && column < header.columnCount; column++)
+    {
+        ColumnEntry entry;
+        std::memcpy(&entry, mapped + entriesOffset + column * sizeof(ColumnEntry), sizeof(ColumnEntry));
+        valid = quint64(entry.nameOffset) + entry.nameLength <= header.namesLength && entry.type <= CsvColumn::Float64
+                && entry.dataOffset + header.rowCount * CsvColumn::elementSize(CsvColumn::Type(entry.type))
+                       <= quint64(fileSize)
+                && entry.validityOffset + validityBytes <= quint64(fileSize);
+        if (valid)
+        {
+            const char* name = reinterpret_cast<const char*>(mapped + namesOffset + entry.nameOffset);
+            cachedColumns[QString::fromUtf8(name, entry.nameLength)] = entry;
+        }
+    }
+
+    CsvTable cached;
+    if (valid)
+    {
+        const char* csvHeader = reinterpret_cast<const char*>(mapped + headerOffset);
+        cached.header = QString::fromUtf8(csvHeader, header.headerLength).split(',', Qt::SkipEmptyParts);
+    }
+    for (qsizetype field = 0; valid && field < cached.header.size(); field++)
+    {
+        const QString& key = cached.header.at(field);
+        if (!projection.isEmpty() && !projection.contains(key))
+        {
+            continue;
+        }
+        auto found = cachedColumns.find(key);
+        valid = found != cachedColumns.end() && parsedType(schema, key, CsvColumn::Type(found->second.type));
+        if (valid)
+        {
+            CsvColumn values(CsvColumn::Type(found->second.type));
+            values.resize(qsizetype(header.rowCount));
+            std::memcpy(values.data(), mapped + found->second.dataOffset, values.byteSize());
+            if (found->second.validityOffset != 0)
+            {
+                QVector<quint64> words(validityBytes / qint64(sizeof(quint64)));
+                std::memcpy(words.data(), mapped + found->second.validityOffset, validityBytes);
+                values.setValidityWords(words);
+            }
+            cached.keys.append(key);
+            cached.columns.append(std::move(values));
+        }
+    }
+    file.unmap(mapped);
+
+    if (valid)
+    {
+        cached.sourceBytes = header.parsedBytes;
+        table = std::move(cached);
+    }
+    return valid;
+}
+
+bool ColumnCache::store(const QString& csvPath, const CsvTable& table)
+{
+    const SourceInfo source = sourceInfo(csvPath);
+    const QByteArray csvHeader = table.header.join(',').toUtf8();
+    QByteArray names;
+    QVector<ColumnEntry> entries;
+    for (qsizetype column = 0; column < table.keys.size(); column++)
+    {
+        const QByteArray name = table.keys.at(column).toUtf8();
+        entries.append({0, 0, quint32(names.size()), quint32(name.size()), quint32(table.columns.at(column).type()), 0});
+        names.append(name);
+    }
+    const qint64 rowCount = table.rowCount();
+    qint64 written = sizeof(Header) + source.path.size() + csvHeader.size() + names.size()
+                     + entries.size() * qint64(sizeof(ColumnEntry));
+    qint64 dataOffset = alignUp(written);
+    for (qsizetype column = 0; column < entries.size(); column++)
+    {
+        const CsvColumn& values = table.columns.at(column);
+        entries[column].dataOffset = quint64(dataOffset);
+        dataOffset = alignUp(dataOffset + values.byteSize());
+        if (!values.allValid())
+        {
+            entries[column].validityOffset = quint64(dataOffset);
+            dataOffset = alignUp(dataOffset + values.validityWords().size() * qint64(sizeof(quint64)));
+        }
+    }
+
+    Header header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.byteOrder = ByteOrderMark;
+    header.sourceSize = source.size;
+    header.sourceModified = source.modified;
+    header.parsedBytes = qMin(table.sourceBytes, source.size);
+    header.rowCount = quint64(rowCount);
+    header.columnCount = quint32(table.keys.size());
+    header.pathLength = quint32(source.path.size());
+    header.namesLength = quint32(names.size());
+    header.headerLength = quint32(csvHeader.size());
+
+    //written to a temporary and renamed on commit, a reader never sees half a sidecar
+    QSaveFile file(cachePath(csvPath));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(source.path);
+    file.write(csvHeader);
+    file.write(names);
+    file.write(reinterpret_cast<const char*>(entries.constData()), entries.size() * qint64(sizeof(ColumnEntry)));
+
+    const char padding[Alignment] = {};
+    for (qsizetype column = 0; column < table.columns.size(); column++)
+    {
+        const CsvColumn& values = table.columns.at(column);
+        const qint64 offset = qint64(entries.at(column).dataOffset);
+        file.write(padding, offset - written);
+        file.write(static_cast<const char*>(values.constData()), values.byteSize());
+        written = offset + values.byteSize();
+        if (!values.allValid())
+        {
+            const qint64 validityOffset = qint64(entries.at(column).validityOffset);
+            const qint64 validityBytes = values.validityWords().size() * qint64(sizeof(quint64));
+            file.write(padding, validityOffset - written);
+            file.write(reinterpret_cast<const char*>(values.validityWords().constData()), validityBytes);
+            written = validityOffset + validityBytes;
+        }
+    }
+    return file.commit();
+}
@@ -0,0 +1,28 @@
+#ifndef COLUMNCACHE_H
+#define COLUMNCACHE_H
+
+#include "csvparser.h"
+
+// Binary sidecar written next to a csv file after its first parse, holding the
+// csv header and each parsed column as a contiguous 64 byte aligned array in its
+// storage type, plus its validity bitmap, behind a small header.
+// A sidecar is only used while the csv still has the path, size and modification
+// time recorded in it, later opens map it instead of parsing the csv again.
+class ColumnCache
+{
+public:
+    static constexpr quint32 Version = 5;
+    static constexpr qint64 Alignment = 64;
+
+    static QString cachePath(const QString& csvPath);
+
+    // fills table with the projected columns (all if projection is empty) from the sidecar of
+    // csvPath, returns false if there is none, it is stale or it lacks one of the columns. A column
+    // cached in another type than parsing with schema (see CsvParser::setSchema) gives is lacking too
+    static bool load(const QString& csvPath, const QStringList& projection,
+                     const std::unordered_map<QString, CsvColumn::Type>& schema, CsvTable& table);
+    // writes the sidecar of csvPath, returns false if it couldn't be written
+    static bool store(const QString& csvPath, const CsvTable& table);
+};
+
+#endif // COLUMNCACHE_H
@@ -0,0 +1,1021 @@
+#include "csvparser.h"
+#include "csvscanner.h"
+
+#include <QtAlgorithms>
+
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+const double powersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                              1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline void trim(const char*& begin, const char*& end)
+{
+    while (begin < end && isBlank(*begin))
+        ++begin;
+    while (end > begin && isBlank(end[-1]))
+        --end;
+}
+
+inline const char* findChar(const char* begin, const char* end, char c)
+{
+    const void* found = std::memchr(begin, c, end - begin);
+    return found ? static_cast<const char*>(found) : end;
+}
+
+// parses a plain integer field, false if the field holds anything else
+template <class Integer>
+inline bool parseInteger(const char* begin, const char* end, Integer& value)
+{
+    if (begin < end && *begin == '+')
+        ++begin;
+    const std::from_chars_result result = std::from_chars(begin, end, value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+// the value of the Count digits at p, -1 if one of them isn't a digit. All of them are combined
+// before the single check, so well formed fields take no branches
+template <int Count>
+inline int parseDigits(const char* p)
+{
+    int value = 0;
+    unsigned invalid = 0;
+    for (int i = 0; i < Count; ++i)
+    {
+        const unsigned digit = unsigned(p[i] - '0');
+        invalid |= unsigned(digit > 9);
+        value = value * 10 + int(digit);
+    }
+    return invalid ? -1 : value;
+}
+
+// days from 1970-01-01 to y-m-d of the proleptic gregorian calendar (Howard Hinnant's days_from_civil)
+constexpr qint64 daysFromCivil(qint64 y, int m, int d)
+{
+    y -= m <= 2;
+    const qint64 era = (y >= 0 ? y : y - 399) / 400;
+    const qint64 yearOfEra = y - era * 400;
+    const qint64 dayOfYear = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const qint64 dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// days from the epoch to the first of every month of the years market data is from, so a date costs
+// one lookup. The entry after a month is its end, which bounds its days
+struct MonthStarts
+{
+    static constexpr int FirstYear = 1900;
+    static constexpr int LastYear = 2099;
+    qint32 days[(LastYear - FirstYear + 1) * 12 + 1];
+
+    constexpr MonthStarts()
+        : days()
+    {
+        for (int month = 0; month <= (LastYear - FirstYear + 1) * 12; ++month)
+        {
+            days[month] = qint32(daysFromCivil(FirstYear + month / 12, month % 12 + 1, 1));
+        }
+    }
+};
+constexpr MonthStarts monthStarts;
+
+// days from the epoch to y-m-d, false if the month has no such day
+inline bool daysFromDate(int y, int m, int d, qint64& days)
+{
+    if (m < 1 || m > 12 || d < 1)
+        return false;
+    if (y >= MonthStarts::FirstYear && y <= MonthStarts::LastYear)
+    {
+        const int month = (y - MonthStarts::FirstYear) * 12 + m - 1;
+        days = monthStarts.days[month] + d - 1;
+        return days < monthStarts.days[month + 1];
+    }
+    days = daysFromCivil(y, m, d);
+    return d <= daysFromCivil(m == 12 ? y + 1 : y, m == 12 ? 1 : m + 1, 1) - daysFromCivil(y, m, 1);
+}
+
+// a cheap test for fields parseTimestamp may accept, no number has a '-' or '/' after 4 digits
+inline bool looksLikeDate(const char* begin, const char* end)
+{
+    return end - begin >= 10 && (begin[4] == '-' || begin[4] == '/');
+}
+
+// converts a field into its column, an integer column meeting a value it can't hold is widened to Float64.
+// Timestamps become epoch seconds, ones with a fraction widen the column to Float64
+inline void appendField(CsvColumn& column, const char* begin, const char* end)
+{
+    trim(begin, end);
+    if (begin == end)
+    {
+        column.appendMissing();
+        return;
+    }
+    switch (column.type())
+    {
+    case CsvColumn::Int64:
+    {
+        qint64 value;
+        if (parseInteger(begin, end, value))
+        {
+            column.appendValue(value);
+            return;
+        }
+        qint32 nanoseconds;
+        if (looksLikeDate(begin, end) && CsvParser::parseTimestamp(begin, end, value, nanoseconds) && nanoseconds == 0)
+        {
+            column.appendValue(value);
+            return;
+        }
+        column.setType(CsvColumn::Float64);
+        break;
+    }
+    case CsvColumn::UInt64:
+    {
+        quint64 value;
+        if (parseInteger(begin, end, value))
+        {
+            column.appendValue(value);
+            return;
+        }
+        column.setType(CsvColumn::Float64);
+        break;
+    }
+    case CsvColumn::Float32:
+    case CsvColumn::Float64:
+        break;
+    }
+    double value;
+    qint64 seconds;
+    qint32 nanoseconds;
+    if (looksLikeDate(begin, end) && CsvParser::parseTimestamp(begin, end, seconds, nanoseconds))
+        value = double(seconds) + nanoseconds * 1e-9;
+    else
+        value = CsvParser::parseDouble(begin, end);
+    if (column.type() == CsvColumn::Float32)
+        column.appendValue(float(value));
+    else
+        column.appendValue(value);
+}
+
+template <class T>
+QVector<T> convertValues(const CsvColumn& column)
+{
+    QVector<T> converted(column.size());
+    for (qsizetype row = 0; row < converted.size(); ++row)
+        converted[row] = T(column.value(row));
+    return converted;
+}
+
+// rows in a word of a bitmap that covers rows rows
+inline quint64 wordMask(qsizetype rows, qsizetype word)
+{
+    const qsizetype inWord = rows - word * 64;
+    return inWord >= 64 ? ~quint64(0) : (quint64(1) << inWord) - 1;
+}
+
+inline bool isBlankLine(const char* begin, const char* end)
+{
+    while (begin < end && isBlank(*begin))
+        ++begin;
+    return begin == end;
+}
+
+// parses the complete rows in [begin, end) using the structural index of that range, field
+// boundaries come from the index so no byte is looked at twice outside of the number parser.
+// Field f of a row goes to columns[targets[f]], fields with a negative target are skipped unconverted
+void parseIndexedRows(const char* begin, const char* end, const quint32* index, const quint32* indexEnd,
+                      CsvColumn* columns, const QVector<qsizetype>& targets)
+{
+    const qsizetype fieldCount = targets.size();
+    const qsizetype* target = targets.constData();
+    const char* fieldBegin = begin;
+    while (index < indexEnd || fieldBegin < end)
+    {
+        //a line that isn't terminated by a newline ends at the range end
+        const char* lineEnd = end;
+        const quint32* lineIndex = index;
+        while (lineIndex < indexEnd && begin[*lineIndex] != '\n')
+            ++lineIndex;
+        if (lineIndex < indexEnd)
+            lineEnd = begin + *lineIndex;
+
+        if (lineIndex == index && isBlankLine(fieldBegin, lineEnd))
+        {
+            // could be an empty line at the end of file
+        }
+        else
+        {
+            qsizetype field = 0;
+            for (; index < lineIndex && field < fieldCount; ++index, ++field)
+            {
+                const char* fieldEnd = begin + *index;
+                if (target[field] >= 0)
+                    appendField(columns[target[field]], fieldBegin, fieldEnd);
+                fieldBegin = fieldEnd + 1;
+            }
+            if (field < fieldCount)
+            {
+                if (target[field] >= 0)
+                    appendField(columns[target[field]], fieldBegin, lineEnd);
+                ++field;
+            }
+            for (; field < fieldCount; ++field)
+            {
+                if (target[field] >= 0)
+                    columns[target[field]].appendMissing();
+            }
+        }
+
+        if (lineIndex == indexEnd)
+            break;
+        index = lineIndex + 1;
+        fieldBegin = lineEnd + 1;
+    }
+}
+
+// progress is bumped and cancelFlag checked once per block, a cancelled parse just stops
+void parseRows(const char* begin, const char* end, QVector<CsvColumn>& columns, const QVector<qsizetype>& targets,
+               std::atomic<qint64>* progress, const std::atomic<bool>* cancelFlag)
+{
+    CsvColumn* columnData = columns.data();
+    QVector<quint32> index;
+    while (begin < end && !(cancelFlag && cancelFlag->load(std::memory_order_relaxed)))
+    {
+        //scan a cache sized block, only the rows completed inside it are parsed
+        const char* blockEnd = end - begin > CsvParser::ScanBlockSize ? begin + CsvParser::ScanBlockSize : end;
+        qsizetype count = 0;
+        while (true)
+        {
+            if (index.size() < blockEnd - begin)
+                index.resize(blockEnd - begin);
+            count = CsvScanner::scan(begin, blockEnd, index.data());
+            if (blockEnd == end)
+                break;
+            while (count > 0 && begin[index[count - 1]] != '\n')
+                --count;
+            if (count > 0)
+            {
+                blockEnd = begin + index[count - 1] + 1;
+                break;
+            }
+            blockEnd = findChar(blockEnd, end, '\n'); // a line longer than the block
+            blockEnd = blockEnd == end ? end : blockEnd + 1;
+        }
+        parseIndexedRows(begin, blockEnd, index.constData(), index.constData() + count, columnData, targets);
+        if (progress)
+            progress->fetch_add(blockEnd - begin, std::memory_order_relaxed);
+        begin = blockEnd;
+    }
+}
+
+// threads that are joined before it is destroyed, also when an exception unwinds past them, which
+// would otherwise terminate the program. An exception a thread throws is kept for join to rethrow
+class JoinedThreads
+{
+public:
+    explicit JoinedThreads(int count)
+        : errors(count)
+    {
+        threads.reserve(count);
+    }
+    ~JoinedThreads()
+    {
+        waitAll();
+    }
+
+    template <class Function>
+    void start(Function function)
+    {
+        std::exception_ptr& error = errors[threads.size()];
+        threads.emplace_back(
+            [function, &error]()
+            {
+                try
+                {
+                    function();
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+            });
+    }
+
+    // waits for every thread and rethrows the first exception one of them threw
+    void join()
+    {
+        waitAll();
+        for (const std::exception_ptr& error : errors)
+        {
+            if (error)
+                std::rethrow_exception(error);
+        }
+    }
+
+private:
+    void waitAll()
+    {
+        for (std::thread& thread : threads)
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors; // sized up front, the threads write to their own entry
+};
+} // namespace
+
+CsvColumn::CsvColumn(Type type)
+{
+    setType(type);
+}
+
+const char* CsvColumn::typeName(Type type)
+{
+    switch (type)
+    {
+    case Int64:
+        return "int64";
+    case UInt64:
+        return "uint64";
+    case Float32:
+        return "float32";
+    case Float64:
+        break;
+    }
+    return "float64";
+}
+
+qsizetype CsvColumn::elementSize(Type type)
+{
+    return type == Float32 ? qsizetype(sizeof(float)) : qsizetype(sizeof(double));
+}
+
+CsvColumn CsvColumn::borrow(Type type, const void* values, qsizetype rows, std::shared_ptr<const void> owner)
+{
+    CsvColumn column(type);
+    column.borrowedValues = values;
+    column.borrowedRows = rows;
+    column.owner = std::move(owner);
+    return column;
+}
+
+void CsvColumn::detach()
+{
+    if (!owner)
+    {
+        return;
+    }
+    std::visit(
+        [this](auto& values)
+        {
+            using T = typename std::decay_t<decltype(values)>::value_type;
+            values.resize(borrowedRows);
+            std::memcpy(values.data(), borrowedValues, borrowedRows * sizeof(T));
+        },
+        storage);
+    borrowedValues = nullptr;
+    borrowedRows = 0;
+    owner.reset();
+}
+
+qsizetype CsvColumn::size() const
+{
+    if (owner)
+    {
+        return borrowedRows;
+    }
+    return std::visit([](const auto& values) { return qsizetype(values.size()); }, storage);
+}
+
+void CsvColumn::reserve(qsizetype rows)
+{
+    detach();
+    std::visit([rows](auto& values) { values.reserve(rows); }, storage);
+}
+
+void CsvColumn::resize(qsizetype rows)
+{
+    const qsizetype oldRows = size();
+    detach();
+    std::visit([rows](auto& values) { values.resize(rows); }, storage);
+    if (!validity.isEmpty())
+    {
+        validity.resize((rows + 63) / 64);
+        for (qsizetype row = oldRows; row < rows; ++row)
+            setValidBit(row);
+        if (rows < oldRows && rows % 64 != 0)
+            validity.last() &= wordMask(rows, validity.size() - 1);
+    }
+}
+
+const void* CsvColumn::constData() const
+{
+    if (owner)
+    {
+        return borrowedValues;
+    }
+    return std::visit([](const auto& values) -> const void* { return values.constData(); }, storage);
+}
+
+void* CsvColumn::data()
+{
+    detach();
+    return std::visit([](auto& values) -> void* { return values.data(); }, storage);
+}
+
+void CsvColumn::appendMissing()
+{
+    detach();
+    if (validity.isEmpty())
+    {
+        allocateValidity();
+    }
+    std::visit([](auto& values) { values.append({}); }, storage);
+    const qsizetype words = (size() + 63) / 64;
+    if (validity.size() < words)
+    {
+        validity.resize(words);
+    }
+}
+
+void CsvColumn::setValidBit(qsizetype row)
+{
+    const qsizetype word = row >> 6;
+    if (word >= validity.size())
+    {
+        validity.resize(word + 1);
+    }
+    validity[word] |= quint64(1) << (row & 63);
+}
+
+void CsvColumn::allocateValidity()
+{
+    const qsizetype rows = size();
+    validity.fill(~quint64(0), (rows + 63) / 64);
+    if (rows % 64 != 0)
+    {
+        validity.last() = wordMask(rows, validity.size() - 1);
+    }
+}
+
+void CsvColumn::setValidityWords(const QVector<quint64>& words)
+{
+    validity = words;
+}
+
+QVector<CsvColumn::Span> CsvColumn::validSpans() const
+{
+    QVector<Span> spans;
+    const qsizetype rows = size();
+    if (validity.isEmpty())
+    {
+        if (rows > 0)
+            spans.append({0, rows});
+        return spans;
+    }
+
+    //first row at or after from whose bit equals set, whole words of the other value are skipped
+    const qsizetype words = validity.size();
+    auto nextRow = [this, words, rows](qsizetype from, bool set) -> qsizetype
+    {
+        qsizetype word = from >> 6;
+        if (word >= words)
+            return rows;
+        quint64 bits = (set ? validity[word] : ~validity[word]) & (~quint64(0) << (from & 63));
+        while (bits == 0)
+        {
+            if (++word == words)
+                return rows;
+            bits = set ? validity[word] : ~validity[word];
+        }
+        return qMin(word * 64 + qCountTrailingZeroBits(bits), rows);
+    };
+    for (qsizetype row = nextRow(0, true); row < rows; row = nextRow(row, true))
+    {
+        const qsizetype end = nextRow(row, false);
+        spans.append({row, end});
+        row = end;
+    }
+    return spans;
+}
+
+void CsvColumn::setType(Type type)
+{
+    if (type == this->type())
+    {
+        return;
+    }
+    switch (type)
+    {
+    case Int64:
+        storage = convertValues<qint64>(*this);
+        break;
+    case UInt64:
+        storage = convertValues<quint64>(*this);
+        break;
+    case Float32:
+        storage = convertValues<float>(*this);
+        break;
+    case Float64:
+        storage = convertValues<double>(*this);
+        break;
+    }
+    borrowedValues = nullptr;
+    borrowedRows = 0;
+    owner.reset();
+}
+
+void CsvColumn::append(const CsvColumn& other)
+{
+    if (other.size() == 0)
+    {
+        return;
+    }
+    if (size() == 0)
+    {
+        *this = other;
+        return;
+    }
+    detach();
+    const qsizetype rows = size();
+    const bool tracksValidity = !validity.isEmpty() || !other.validity.isEmpty();
+    if (tracksValidity && validity.isEmpty())
+    {
+        allocateValidity();
+    }
+    if (other.type() != type())
+    {
+        setType(Float64);
+        CsvColumn widened = other;
+        widened.setType(Float64);
+        values<double>().append(widened.values<double>());
+    }
+    else
+    {
+        std::visit(
+            [&other](auto& values)
+            {
+                using T = typename std::decay_t<decltype(values)>::value_type;
+                const qsizetype rows = values.size();
+                values.resize(rows + other.size());
+                std::memcpy(values.data() + rows, other.constValues<T>(), other.size() * sizeof(T));
+            },
+            storage);
+    }
+    if (!tracksValidity)
+    {
+        return;
+    }
+
+    //shift the words of other in behind the rows already here
+    validity.resize((size() + 63) / 64);
+    const qsizetype otherRows = other.size();
+    const int shift = int(rows & 63);
+    for (qsizetype word = 0; word * 64 < otherRows; ++word)
+    {
+        const quint64 bits = other.validity.isEmpty() ? wordMask(otherRows, word) : other.validity[word];
+        const qsizetype target = (rows >> 6) + word;
+        validity[target] |= bits << shift;
+        if (shift != 0 && target + 1 < validity.size())
+            validity[target + 1] |= bits >> (64 - shift);
+    }
+}
+
+CsvColumn CsvColumn::selectRows(const QVector<qsizetype>& rows) const
+{
+    CsvColumn selected(type());
+    std::visit(
+        [this, &rows](auto& values)
+        {
+            using T = typename std::decay_t<decltype(values)>::value_type;
+            const T* source = constValues<T>();
+            values.resize(rows.size());
+            for (qsizetype i = 0; i < rows.size(); ++i)
+            {
+                values[i] = source[rows[i]];
+            }
+        },
+        selected.storage);
+    if (validity.isEmpty())
+    {
+        return selected;
+    }
+    selected.validity.resize((rows.size() + 63) / 64);
+    for (qsizetype i = 0; i < rows.size(); ++i)
+    {
+        if (isValid(rows[i]))
+            selected.setValidBit(i);
+    }
+    return selected;
+}
+
+CsvParser::CsvParser(qint64 chunkSize)
+    : chunkSize(qMax<qint64>(chunkSize, 1024))
+    , headerParsed(false)
+    , holdPartialLine(false)
+    , progress(nullptr)
+    , cancelFlag(nullptr)
+{
+}
+
+void CsvParser::setProgress(std::atomic<qint64>* progress)
+{
+    this->progress = progress;
+}
+
+void CsvParser::setCancelFlag(const std::atomic<bool>* cancelFlag)
+{
+    this->cancelFlag = cancelFlag;
+}
+
+void CsvParser::setProjection(const QStringList& keys)
+{
+    projection = keys;
+}
+
+void CsvParser::setSchema(const std::unordered_map<QString, CsvColumn::Type>& types)
+{
+    schema = types;
+}
+
+void CsvParser::setHoldPartialLine(bool hold)
+{
+    holdPartialLine = hold;
+}
+
+CsvTable CsvParser::parse(QIODevice& device, qint64 maxBytes)
+{
+    CsvTable table;
+    headerParsed = false;
+    qint64 totalRead = 0;
+
+    QByteArray buffer(chunkSize, Qt::Uninitialized);
+    qint64 carried = 0; // bytes of an incomplete line kept from the previous chunk
+    qint64 consumed = 0;
+    bool reserved = device.isSequential();
+    while (true)
+    {
+        if (buffer.size() - carried < chunkSize)
+        {
+            buffer.resize(carried + chunkSize); // a single line is longer than a chunk
+        }
+        const qint64 toRead = maxBytes < 0 ? chunkSize : qMin(chunkSize, maxBytes - totalRead);
+        const qint64 bytesRead = toRead > 0 ? device.read(buffer.data() + carried, toRead) : 0;
+        if (bytesRead < 0)
+        {
+            throw std::runtime_error(device.errorString().toStdString());
+        }
+        totalRead += bytesRead;
+
+        const char* begin = buffer.constData();
+        const char* end = begin + carried + bytesRead;
+        if (bytesRead == 0)
+        {
+            //last line may have no trailing newline, a held one is read by parseTail once it has
+            if (holdPartialLine && headerParsed)
+            {
+                totalRead -= carried;
+            }
+            else
+            {
+                parseLines(begin, end, table);
+            }
+            break;
+        }
+        if (cancelFlag && cancelFlag->load(std::memory_order_relaxed))
+        {
+            break;
+        }
+
+        const char* lastNewline = end;
+        while (lastNewline > begin && lastNewline[-1] != '\n')
+            --lastNewline;
+        if (lastNewline == begin)
+        {
+            carried = end - begin;
+            continue;
+        }
+
+        parseLines(begin, lastNewline, table);
+        consumed += lastNewline - begin;
+        carried = end - lastNewline;
+        std::memmove(buffer.data(), lastNewline, carried);
+
+        //size the columns once from the average row length of the first chunk
+        if (!reserved && table.rowCount() > 0)
+        {
+            const qint64 estimatedBytes = maxBytes < 0 ? device.size() : qMin(maxBytes, device.size());
+            const qint64 estimatedRows = estimatedBytes / qMax<qint64>(consumed / table.rowCount(), 1);
+            for (auto& column : table.columns)
+                column.reserve(estimatedRows + estimatedRows / 16);
+            reserved = true;
+        }
+    }
+    if (cancelFlag && cancelFlag->load())
+    {
+        throw Cancelled();
+    }
+    table.sourceBytes = totalRead;
+    return table;
+}
+
+void CsvParser::parseLines(const char* begin, const char* end, CsvTable& table)
+{
+    if (!headerParsed && begin < end)
+    {
+        const char* lineEnd = findChar(begin, end, '\n');
+        parseHeader(begin, lineEnd, table);
+        begin = lineEnd == end ? end : lineEnd + 1;
+        inferTypes(begin, end, table);
+    }
+    parseRows(begin, end, table.columns, fieldTargets, progress, cancelFlag);
+}
+
+CsvTable CsvParser::parseMapped(QFile& file, int threadCount, qint64 maxBytes)
+{
+    const qint64 fileSize = maxBytes < 0 ? file.size() : qMin(maxBytes, file.size());
+    uchar* mapped = fileSize > 0 ? file.map(0, fileSize) : nullptr;
+    if (mapped == nullptr)
+    {
+        file.seek(0);
+        return parse(file, maxBytes);
+    }
+
+    CsvTable table;
+    headerParsed = false;
+    const char* begin = reinterpret_cast<const char*>(mapped);
+    const char* end = begin + fileSize;
+    const char* headerEnd = findChar(begin, end, '\n');
+    parseHeader(begin, headerEnd, table);
+    const char* dataBegin = headerEnd == end ? end : headerEnd + 1;
+    while (holdPartialLine && end > dataBegin && end[-1] != '\n')
+        --end;
+    inferTypes(dataBegin, end, table);
+    if (progress)
+        progress->fetch_add(dataBegin - begin, std::memory_order_relaxed);
+
+    //split the rows into byte ranges that start right after a newline
+    threadCount = int(qBound<qint64>(1, threadCount, qMax<qint64>((end - dataBegin) / MinBytesPerThread, 1)));
+    QVector<const char*> bounds(threadCount + 1);
+    bounds[0] = dataBegin;
+    bounds[threadCount] = end;
+    for (int i = 1; i < threadCount; i++)
+    {
+        const char* bound = qMax(dataBegin + (end - dataBegin) * i / threadCount, bounds[i - 1]);
+        if (bound > dataBegin && bound < end && bound[-1] != '\n')
+        {
+            bound = findChar(bound, end, '\n');
+            bound = bound == end ? end : bound + 1;
+        }
+        bounds[i] = bound;
+    }
+
+    //each worker fills its own column segments, appended in file order afterwards
+    QVector<QVector<CsvColumn>> segments(threadCount, table.columns);
+    JoinedThreads workers(threadCount - 1);
+    for (int i = 1; i < threadCount; i++)
+    {
+        workers.start([this, &bounds, &segments, i]()
+                      { parseRows(bounds[i], bounds[i + 1], segments[i], fieldTargets, progress, cancelFlag); });
+    }
+    parseRows(bounds[0], bounds[1], table.columns, fieldTargets, progress, cancelFlag);
+    workers.join();
+    if (cancelFlag && cancelFlag->load())
+    {
+        file.unmap(mapped);
+        throw Cancelled();
+    }
+
+    for (qsizetype column = 0; column < table.columns.size(); ++column)
+    {
+        qsizetype rows = table.columns[column].size();
+        for (int i = 1; i < threadCount; i++)
+            rows += segments[i][column].size();
+        table.columns[column].reserve(rows);
+        for (int i = 1; i < threadCount; i++)
+        {
+            table.columns[column].append(segments[i][column]);
+            segments[i][column] = CsvColumn();
+        }
+    }
+
+    file.unmap(mapped);
+    table.sourceBytes = end - begin;
+    return table;
+}
+
+CsvTable CsvParser::parseTail(QIODevice& device, const QStringList& header, qint64 offset)
+{
+    CsvTable table;
+    setupColumns(header, table);
+    table.sourceBytes = offset;
+    if (!device.seek(offset))
+    {
+        throw std::runtime_error(device.errorString().toStdString());
+    }
+
+    //a row that is still being written has no newline yet and is left for the next call
+    const QByteArray appended = device.read(qMax<qint64>(device.size() - offset, 0));
+    const char* begin = appended.constData();
+    const char* end = begin + appended.size();
+    while (end > begin && end[-1] != '\n')
+        --end;
+    inferTypes(begin, end, table);
+    parseRows(begin, end, table.columns, fieldTargets, progress, cancelFlag);
+    table.sourceBytes += end - begin;
+    return table;
+}
+
+void CsvParser::parseHeader(const char* begin, const char* end, CsvTable& table)
+{
+    headerParsed = true;
+    QStringList header;
+    while (begin < end)
+    {
+        const char* fieldEnd = findChar(begin, end, ',');
+        const char* keyBegin = begin;
+        const char* keyEnd = fieldEnd;
+        trim(keyBegin, keyEnd);
+        if (keyBegin == keyEnd)
+        {
+            break; // csv file might have a trailing comma
+        }
+        header.append(QString::fromUtf8(keyBegin, keyEnd - keyBegin));
+        begin = fieldEnd == end ? end : fieldEnd + 1;
+    }
+    setupColumns(header, table);
+}
+
+void CsvParser::setupColumns(const QStringList& header, CsvTable& table)
+{
+    table.header = header;
+    table.keys.clear();
+    table.columns.clear();
+    fieldTargets.fill(-1, header.size());
+    for (qsizetype field = 0; field < header.size(); ++field)
+    {
+        if (projection.isEmpty() || projection.contains(header.at(field)))
+        {
+            fieldTargets[field] = table.keys.size();
+            table.keys.append(header.at(field));
+            auto type = schema.find(header.at(field));
+            table.columns.append(CsvColumn(type == schema.end() ? CsvColumn::Float64 : type->second));
+        }
+    }
+}
+
+void CsvParser::inferTypes(const char* begin, const char* end, CsvTable& table)
+{
+    //a column without a declared type is Int64 if all of its sampled fields are integers
+    QVector<bool> integral(table.columns.size(), true);
+    for (int row = 0; row < TypeSampleRows && begin < end; ++row)
+    {
+        const char* lineEnd = findChar(begin, end, '\n');
+        const char* fieldBegin = begin;
+        for (qsizetype field = 0; field < fieldTargets.size() && fieldBegin <= lineEnd; ++field)
+        {
+            const char* fieldEnd = findChar(fieldBegin, lineEnd, ',');
+            const qsizetype column = fieldTargets[field];
+            if (column >= 0 && integral[column])
+            {
+                const char* valueBegin = fieldBegin;
+                const char* valueEnd = fieldEnd;
+                trim(valueBegin, valueEnd);
+                qint64 value;
+                qint32 nanoseconds;
+                integral[column] = valueBegin == valueEnd || parseInteger(valueBegin, valueEnd, value)
+                                   || (looksLikeDate(valueBegin, valueEnd)
+                                       && parseTimestamp(valueBegin, valueEnd, value, nanoseconds) && nanoseconds == 0);
+            }
+            fieldBegin = fieldEnd + 1;
+        }
+        begin = lineEnd == end ? end : lineEnd + 1;
+    }
+
+    for (qsizetype column = 0; column < table.columns.size(); ++column)
+    {
+        if (schema.find(table.keys.at(column)) == schema.end())
+        {
+            table.columns[column].setType(integral[column] ? CsvColumn::Int64 : CsvColumn::Float64);
+        }
+    }
+}
+
+bool CsvParser::parseTimestamp(const char* begin, const char* end, qint64& seconds, qint32& nanoseconds)
+{
+    const qsizetype length = end - begin;
+    if (length < 10 || (begin[4] != '-' && begin[4] != '/') || begin[7] != begin[4])
+        return false;
+    const int year = parseDigits<4>(begin);
+    const int month = parseDigits<2>(begin + 5);
+    const int day = parseDigits<2>(begin + 8);
+    qint64 days;
+    if (year < 0 || month < 0 || day < 0 || !daysFromDate(year, month, day, days))
+        return false;
+    seconds = days * 86400;
+    nanoseconds = 0;
+    const char* p = begin + 10;
+    if (p == end)
+        return true;
+
+    //hh:mm, then optionally :ss and a fraction
+    if ((*p != 'T' && *p != ' ') || end - p < 6 || p[3] != ':')
+        return false;
+    const int hour = parseDigits<2>(p + 1);
+    const int minute = parseDigits<2>(p + 4);
+    if (hour < 0 || hour > 23 || minute < 0 || minute > 59)
+        return false;
+    seconds += hour * 3600 + minute * 60;
+    p += 6;
+    if (end - p >= 3 && *p == ':')
+    {
+        const int second = parseDigits<2>(p + 1);
+        if (second < 0 || second > 60) // 60 is a leap second
+            return false;
+        seconds += second;
+        p += 3;
+        if (p < end && (*p == '.' || *p == ','))
+        {
+            int digits = 0;
+            for (++p; p < end && unsigned(*p - '0') < 10; ++p, ++digits)
+            {
+                if (digits < 9)
+                    nanoseconds = nanoseconds * 10 + (*p - '0');
+            }
+            if (digits == 0)
+                return false;
+            for (; digits < 9; ++digits)
+                nanoseconds *= 10;
+        }
+    }
+    if (p == end)
+        return true;
+
+    //Z or an offset from utc, the local time minus the offset is utc
+    if (*p == 'Z' || *p == 'z')
+        return p + 1 == end;
+    if ((*p != '+' && *p != '-') || end - p < 3)
+        return false;
+    const int sign = *p == '-' ? -1 : 1;
+    const int offsetHours = parseDigits<2>(p + 1);
+    int offsetMinutes = 0;
+    p += 3;
+    if (p < end)
+    {
+        p += *p == ':';
+        if (end - p != 2)
+            return false;
+        offsetMinutes = parseDigits<2>(p);
+    }
+    if (offsetHours < 0 || offsetHours > 23 || offsetMinutes < 0 || offsetMinutes > 59)
+        return false;
+    seconds -= sign * (offsetHours * 3600 + offsetMinutes * 60);
+    return true;
+}
+
+double CsvParser::parseDouble(const char* begin, const char* end)
+{
+    bool negative = false;
+    if (begin < end && (*begin == '-' || *begin == '+'))
+    {
+        negative = *begin == '-';
+        ++begin;
+    }
+
+    //fast path: a plain decimal with at most 15 digits is exactly representable
+    // as an integer mantissa, and one division by an exact power of ten rounds correctly
+    quint64 mantissa = 0;
+    int digits = 0;
+    int fractionDigits = 0;
+    const char* p = begin;
+    for (; p < end && unsigned(*p - '0') < 10; ++p, ++digits)
+        mantissa = mantissa * 10 + unsigned(*p - '0');
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && unsigned(*p - '0') < 10; ++p, ++digits, ++fractionDigits)
+            mantissa = mantissa * 10 + unsigned(*p - '0');
+    }
+    double value = 0;
+    if (p == end && digits > 0 && digits <= 15)
+    {
+        value = double(mantissa) / powersOfTen[fractionDigits];
+    }
+    else
+    {
+        std::from_chars(begin, end, value); // exponents, long mantissas, inf/nan; leaves 0 on failure
+    }
+    return negative ? -value : value;
+}
@@ -0,0 +1,236 @@
+#ifndef CSVPARSER_H
+#define CSVPARSER_H
+
+#include <QFile>
+#include <QIODevice>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <variant>
+
+// A parsed csv column stored in its native width: exact integers for epoch
+// timestamps and counts, single or double precision for prices. Empty cells are
+// tracked in a validity bitmap, one bit per row, which is only allocated once the
+// column has its first empty cell. A column can also borrow its values from memory
+// it doesn't own, such as a mapped file, until it is first changed.
+class CsvColumn
+{
+public:
+    enum Type
+    {
+        Int64,
+        UInt64,
+        Float32,
+        Float64
+    };
+
+    // rows [begin, end)
+    struct Span
+    {
+        qsizetype begin;
+        qsizetype end;
+    };
+
+    explicit CsvColumn(Type type = Float64);
+    // a column of rows values of type owned by someone else and kept alive by owner. The values are
+    // copied into the column the first time it is changed
+    static CsvColumn borrow(Type type, const void* values, qsizetype rows, std::shared_ptr<const void> owner);
+
+    Type type() const
+    {
+        return Type(storage.index());
+    }
+    static const char* typeName(Type type);
+    static qsizetype elementSize(Type type);
+
+    qsizetype size() const;
+    qsizetype byteSize() const
+    {
+        return size() * elementSize(type());
+    }
+    void reserve(qsizetype rows);
+    // rows added are valid
+    void resize(qsizetype rows);
+    const void* constData() const;
+    void* data();
+
+    bool isBorrowed() const
+    {
+        return owner != nullptr;
+    }
+
+    template <class T>
+    QVector<T>& values()
+    {
+        if (owner)
+        {
+            detach();
+        }
+        return std::get<QVector<T>>(storage);
+    }
+    template <class T>
+    const T* constValues() const
+    {
+        return owner ? static_cast<const T*>(borrowedValues) : std::get<QVector<T>>(storage).constData();
+    }
+
+    template <class T>
+    void appendValue(T value)
+    {
+        values<T>().append(value);
+        if (!validity.isEmpty())
+        {
+            setValidBit(size() - 1);
+        }
+    }
+    // appends an empty cell, stored as 0
+    void appendMissing();
+
+    // converts the stored values to type, empty cells stay empty
+    void setType(Type type);
+    // appends the rows of other, widening this column to Float64 if the types differ
+    void append(const CsvColumn& other);
+    // a column of the given rows in their order, empty cells stay empty
+    CsvColumn selectRows(const QVector<qsizetype>& rows) const;
+
+    bool allValid() const
+    {
+        return validity.isEmpty();
+    }
+    bool isValid(qsizetype row) const
+    {
+        return validity.isEmpty() || (validity[row >> 6] >> (row & 63)) & 1;
+    }
+    // the bitmap, bit row % 64 of word row / 64 is set for a valid row. Empty while all rows are valid
+    const QVector<quint64>& validityWords() const
+    {
+        return validity;
+    }
+    void setValidityWords(const QVector<quint64>& words);
+    // the maximal runs of valid rows, found a 64 row word at a time
+    QVector<Span> validSpans() const;
+
+    // the value of a valid row for plotting
+    double value(qsizetype row) const;
+
+private:
+    void setValidBit(qsizetype row);
+    void allocateValidity(); // an all valid bitmap for the current rows
+    void detach();           // copies borrowed values into storage
+
+    // alternatives in the order of Type, an empty vector of the type while the values are borrowed
+    std::variant<QVector<qint64>, QVector<quint64>, QVector<float>, QVector<double>> storage;
+    QVector<quint64> validity;
+    const void* borrowedValues = nullptr;
+    qsizetype borrowedRows = 0;
+    std::shared_ptr<const void> owner;
+};
+
+// Columns of a parsed csv file, in header order. keys names the parsed
+// columns, which may be a subset of header.
+struct CsvTable
+{
+    QStringList header;
+    QStringList keys;
+    QVector<CsvColumn> columns;
+    qint64 sourceBytes = 0; // bytes of the csv file the rows were read from
+
+    qsizetype rowCount() const
+    {
+        return columns.isEmpty() ? 0 : columns.first().size();
+    }
+};
+
+// Streaming csv reader. The input is consumed in fixed size chunks of raw
+// utf-8 bytes, fields are tokenized in place and numbers are converted
+// straight into the column buffers, so peak memory is one chunk plus the
+// output columns.
+class CsvParser
+{
+public:
+    static constexpr qint64 DefaultChunkSize = 4 * 1024 * 1024;
+    static constexpr qint64 MinBytesPerThread = 1024 * 1024;
+    static constexpr qint64 ScanBlockSize = 64 * 1024;
+    static constexpr int TypeSampleRows = 1000;
+
+    // thrown out of parse() and parseMapped() once the cancel flag is set
+    struct Cancelled : std::runtime_error
+    {
+        Cancelled()
+            : std::runtime_error("csv parsing cancelled")
+        {
+        }
+    };
+
+    explicit CsvParser(qint64 chunkSize = DefaultChunkSize);
+
+    // bytes parsed so far are added to progress, which may be polled from another thread
+    void setProgress(std::atomic<qint64>* progress);
+    void setCancelFlag(const std::atomic<bool>* cancelFlag);
+    // only the named columns are converted, the other fields are skipped. Empty parses all columns
+    void setProjection(const QStringList& keys);
+    // storage types of columns by name. The type of any other column is inferred from the first
+    // TypeSampleRows rows: Int64 if they are all integers or whole second timestamps, Float64
+    // otherwise. A column that later meets a value its type can't hold is widened to Float64.
+    // Timestamp fields are stored as seconds since the epoch, see parseTimestamp
+    void setSchema(const std::unordered_map<QString, CsvColumn::Type>& types);
+    // takes a last line without a newline as one still being written: parse() and parseMapped() leave
+    // it unparsed and end sourceBytes before it, so parseTail reads it once it is complete. Off by
+    // default, the last line is parsed like the others
+    void setHoldPartialLine(bool hold);
+
+    // parses header and rows from the current position of device until eof or maxBytes were read.
+    // sourceBytes of the result is the number of bytes the rows were parsed from
+    CsvTable parse(QIODevice& device, qint64 maxBytes = -1);
+    // memory maps the first maxBytes (all if negative) of file and parses line aligned byte
+    // ranges of it on threadCount threads, falls back to parse() if the file can't be mapped
+    CsvTable parseMapped(QFile& file, int threadCount, qint64 maxBytes = -1);
+    // parses the rows appended after offset to a csv file with the given header. Only complete
+    // lines are consumed, sourceBytes of the result is the offset to continue from next time
+    CsvTable parseTail(QIODevice& device, const QStringList& header, qint64 offset);
+
+    static double parseDouble(const char* begin, const char* end);
+    // parses a yyyy-MM-dd date (or yyyy/MM/dd), optionally followed by 'T' or ' ' and hh:mm, :ss, a
+    // fraction of up to 9 digits and Z or a fixed +hh:mm / +hhmm / +hh offset, into seconds since
+    // the epoch in utc and the nanoseconds of the fraction. Times without an offset are taken as
+    // utc. False if the field holds anything else
+    static bool parseTimestamp(const char* begin, const char* end, qint64& seconds, qint32& nanoseconds);
+
+private:
+    void parseHeader(const char* begin, const char* end, CsvTable& table);
+    void parseLines(const char* begin, const char* end, CsvTable& table);
+    void setupColumns(const QStringList& header, CsvTable& table);
+    void inferTypes(const char* begin, const char* end, CsvTable& table);
+
+    qint64 chunkSize;
+    bool headerParsed;
+    bool holdPartialLine;
+    QStringList projection;
+    std::unordered_map<QString, CsvColumn::Type> schema;
+    QVector<qsizetype> fieldTargets; // column of each header field, -1 if not parsed
+    std::atomic<qint64>* progress;
+    const std::atomic<bool>* cancelFlag;
+};
+
+// inline, it is called per row when building plot points
+inline double CsvColumn::value(qsizetype row) const
+{
+    switch (type())
+    {
+    case Int64:
+        return double(constValues<qint64>()[row]);
+    case UInt64:
+        return double(constValues<quint64>()[row]);
+    case Float32:
+        return constValues<float>()[row];
+    case Float64:
+        break;
+    }
+    return constValues<double>()[row];
+}
+
+#endif // CSVPARSER_H
@@ -0,0 +1,157 @@
+#include "csvscanner.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CSVSCANNER_X86
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(CSVSCANNER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CSVSCANNER_AVX2 // msvc builds don't probe the cpu and stay on sse2
+#endif
+
+namespace
+{
+inline int countTrailingZeros(quint32 mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#elif defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return int(bit);
+#else
+    int bit = 0;
+    while (!(mask & 1u))
+    {
+        mask >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+inline quint32* emitOffsets(quint32 mask, quint32 offset, quint32* out)
+{
+    while (mask)
+    {
+        *out++ = offset + quint32(countTrailingZeros(mask));
+        mask &= mask - 1;
+    }
+    return out;
+}
+
+quint32* scanScalar(const char* begin, const char* p, const char* end, quint32* out)
+{
+    for (; p < end; ++p)
+    {
+        if (*p == ',' || *p == '\n')
+            *out++ = quint32(p - begin);
+    }
+    return out;
+}
+
+#ifdef CSVSCANNER_X86
+qsizetype scanSse2(const char* begin, const char* end, quint32* index)
+{
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    quint32* out = index;
+    const char* p = begin;
+    for (; end - p >= 16; p += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(bytes, comma), _mm_cmpeq_epi8(bytes, newline));
+        out = emitOffsets(quint32(_mm_movemask_epi8(hits)), quint32(p - begin), out);
+    }
+    return scanScalar(begin, p, end, out) - index;
+}
+#endif
+
+#ifdef CSVSCANNER_AVX2
+__attribute__((target("avx2"))) qsizetype scanAvx2(const char* begin, const char* end, quint32* index)
+{
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    quint32* out = index;
+    const char* p = begin;
+    for (; end - p >= 32; p += 32)
+    {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, comma), _mm256_cmpeq_epi8(bytes, newline));
+        out = emitOffsets(quint32(_mm256_movemask_epi8(hits)), quint32(p - begin), out);
+    }
+    return scanScalar(begin, p, end, out) - index;
+}
+#endif
+
+CsvScanner::Kernel detectKernel()
+{
+#ifdef CSVSCANNER_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return CsvScanner::Avx2;
+#endif
+#ifdef CSVSCANNER_X86
+    return CsvScanner::Sse2;
+#else
+    return CsvScanner::Scalar;
+#endif
+}
+} // namespace
+
+CsvScanner::Kernel CsvScanner::kernel()
+{
+    static const Kernel selected = detectKernel();
+    return selected;
+}
+
+const char* CsvScanner::kernelName()
+{
+    return kernelName(kernel());
+}
+
+const char* CsvScanner::kernelName(Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Avx2:
+        return "avx2";
+    case Sse2:
+        return "sse2";
+    case Scalar:
+        break;
+    }
+    return "scalar";
+}
+
+bool CsvScanner::isSupported(Kernel kernel)
+{
+    //the kernels are ordered, the selected one is the widest the cpu runs
+    return kernel <= CsvScanner::kernel();
+}
+
+qsizetype CsvScanner::scan(const char* begin, const char* end, quint32* index)
+{
+    return scan(kernel(), begin, end, index);
+}
+
+qsizetype CsvScanner::scan(Kernel kernel, const char* begin, const char* end, quint32* index)
+{
+    switch (kernel)
+    {
+#ifdef CSVSCANNER_AVX2
+    case Avx2:
+        return scanAvx2(begin, end, index);
+#endif
+#ifdef CSVSCANNER_X86
+    case Sse2:
+        return scanSse2(begin, end, index);
+#endif
+    default:
+        return scanScalar(begin, begin, end, index) - index;
+    }
+}
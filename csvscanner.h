@@ -0,0 +1,34 @@
+#ifndef CSVSCANNER_H
+#define CSVSCANNER_H
+
+#include <QtGlobal>
+
+// Builds the structural index of a csv byte range: the offsets of every ','
+// and '\n' in it. The kernel (AVX2, SSE2 or scalar) is picked once at runtime
+// from the cpu the program runs on.
+class CsvScanner
+{
+public:
+    enum Kernel
+    {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    static Kernel kernel();
+    static const char* kernelName();
+    static const char* kernelName(Kernel kernel);
+    // true if kernel was compiled in and the cpu runs it
+    static bool isSupported(Kernel kernel);
+
+    // writes the offsets relative to begin of all delimiters and newlines in
+    // [begin, end) to index, which must have room for (end - begin) entries.
+    // Returns the number of offsets written.
+    static qsizetype scan(const char* begin, const char* end, quint32* index);
+    // scan with the given kernel rather than the selected one, for benchmarks. The kernel
+    // must be supported
+    static qsizetype scan(Kernel kernel, const char* begin, const char* end, quint32* index);
+};
+
+#endif // CSVSCANNER_H
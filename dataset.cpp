@@ -0,0 +1,234 @@
+#include "dataset.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <tuple>
+
+namespace
+{
+const QStringList DatasetFilters = {"*.csv", "*.series", "*.arrow", "*.feather"};
+
+bool isPattern(const QString& fileName)
+{
+    return fileName.contains('*') || fileName.contains('?') || fileName.contains('[');
+}
+
+// the rows of one table with the merged columns, and the range of its keys
+struct Part
+{
+    QVector<CsvColumn> columns;
+    double firstKey = std::numeric_limits<double>::infinity();
+    double lastKey = -std::numeric_limits<double>::infinity();
+    bool sorted = true;
+};
+
+// a column of rows empty cells
+CsvColumn missingColumn(CsvColumn::Type type, qsizetype rows)
+{
+    CsvColumn column(type);
+    column.resize(rows);
+    column.setValidityWords(QVector<quint64>((rows + 63) / 64, 0));
+    return column;
+}
+
+// the first row in [row, end) with a key, end if there is none
+qsizetype nextKeyRow(const CsvColumn& key, qsizetype row, qsizetype end)
+{
+    while (row < end && !key.isValid(row))
+        ++row;
+    return row;
+}
+
+// merges the overlapping parts [begin, end) row by row onto columns. Parts sorted by key are merged k ways,
+// a group with an unsorted one is sorted as a whole. Of rows with equal keys only the earliest is kept
+void mergeOverlapping(const QVector<Part>& parts, qsizetype begin, qsizetype end, qsizetype keyColumn,
+                      QVector<CsvColumn>& columns)
+{
+    //the rows of the parts one after the other, those of part i start at offsets[i - begin]
+    QVector<CsvColumn> group(columns.size());
+    QVector<qsizetype> offsets;
+    bool sorted = true;
+    for (qsizetype i = begin; i < end; ++i)
+    {
+        offsets.append(group.at(keyColumn).size());
+        for (qsizetype c = 0; c < columns.size(); ++c)
+        {
+            group[c].append(parts.at(i).columns.at(c));
+        }
+        sorted = sorted && parts.at(i).sorted;
+    }
+    const CsvColumn& key = group.at(keyColumn);
+    offsets.append(key.size());
+
+    QVector<qsizetype> order;
+    order.reserve(key.size());
+    if (sorted)
+    {
+        //the next row of every part by (key, row), ties go to the earlier part since its rows come first
+        using Head = std::tuple<double, qsizetype, qsizetype>; // key, row, part
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+        for (qsizetype part = 0; part + 1 < offsets.size(); ++part)
+        {
+            const qsizetype row = nextKeyRow(key, offsets.at(part), offsets.at(part + 1));
+            if (row < offsets.at(part + 1))
+                heads.emplace(key.value(row), row, part);
+        }
+        while (!heads.empty())
+        {
+            const auto [value, row, part] = heads.top();
+            heads.pop();
+            order.append(row);
+            const qsizetype next = nextKeyRow(key, row + 1, offsets.at(part + 1));
+            if (next < offsets.at(part + 1))
+                heads.emplace(key.value(next), next, part);
+        }
+    }
+    else
+    {
+        for (qsizetype row = nextKeyRow(key, 0, key.size()); row < key.size(); row = nextKeyRow(key, row + 1, key.size()))
+        {
+            order.append(row);
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&key](qsizetype a, qsizetype b) { return key.value(a) < key.value(b); });
+    }
+
+    QVector<qsizetype> rows;
+    rows.reserve(order.size());
+    for (qsizetype row : order)
+    {
+        if (rows.isEmpty() || key.value(row) != key.value(rows.last()))
+            rows.append(row);
+    }
+    for (qsizetype c = 0; c < columns.size(); ++c)
+    {
+        columns[c].append(group.at(c).selectRows(rows));
+    }
+}
+} // namespace
+
+bool Dataset::isDataset(const QString& path)
+{
+    const QFileInfo info(path);
+    return info.isDir() || isPattern(info.fileName());
+}
+
+QStringList Dataset::files(const QString& path)
+{
+    const QFileInfo info(path);
+    const QDir dir = info.isDir() ? QDir(path) : info.dir();
+    const QStringList filters = info.isDir() ? DatasetFilters : QStringList{info.fileName()};
+    QStringList files;
+    for (const QString& name : dir.entryList(filters, QDir::Files, QDir::Name))
+    {
+        files.append(dir.filePath(name));
+    }
+    return files;
+}
+
+Dataset::Stamp Dataset::stamp(const QString& path)
+{
+    Stamp stamp;
+    stamp.size = 0;
+    for (const QString& file : isDataset(path) ? files(path) : QStringList{path})
+    {
+        const QFileInfo info(file);
+        stamp.size += info.size();
+        stamp.modified = qMax(stamp.modified, info.lastModified().toMSecsSinceEpoch());
+    }
+    return stamp;
+}
+
+CsvTable Dataset::merge(QVector<CsvTable> tables)
+{
+    CsvTable merged;
+    QVector<CsvColumn::Type> types;
+    for (const CsvTable& table : tables)
+    {
+        for (const QString& name : table.header)
+        {
+            if (!merged.header.contains(name))
+                merged.header.append(name);
+        }
+        for (qsizetype i = 0; i < table.keys.size(); ++i)
+        {
+            if (!merged.keys.contains(table.keys.at(i)))
+            {
+                merged.keys.append(table.keys.at(i));
+                types.append(table.columns.at(i).type());
+            }
+        }
+    }
+    if (merged.keys.isEmpty())
+    {
+        return merged;
+    }
+    const qsizetype keyColumn = qMax<qsizetype>(merged.keys.indexOf("timestamp"), 0);
+
+    //every table gets the merged columns in merged order and its key range
+    QVector<Part> parts;
+    for (CsvTable& table : tables)
+    {
+        merged.sourceBytes += table.sourceBytes;
+        const qsizetype rows = table.rowCount();
+        Part part;
+        for (qsizetype c = 0; c < merged.keys.size(); ++c)
+        {
+            const qsizetype index = table.keys.indexOf(merged.keys.at(c));
+            part.columns.append(index >= 0 ? std::move(table.columns[index]) : missingColumn(types.at(c), rows));
+        }
+        const CsvColumn& key = part.columns.at(keyColumn);
+        double previous = -std::numeric_limits<double>::infinity();
+        for (const CsvColumn::Span& span : key.validSpans())
+        {
+            for (qsizetype row = span.begin; row < span.end; ++row)
+            {
+                const double value = key.value(row);
+                part.firstKey = qMin(part.firstKey, value);
+                part.lastKey = qMax(part.lastKey, value);
+                part.sorted = part.sorted && previous <= value;
+                previous = value;
+            }
+        }
+        if (part.firstKey <= part.lastKey)
+        {
+            parts.append(std::move(part)); // tables without keys have no place in the order
+        }
+    }
+    tables.clear();
+
+    //files normally follow each other and are just concatenated, only runs of overlapping ones are merged
+    std::stable_sort(parts.begin(), parts.end(), [](const Part& a, const Part& b) { return a.firstKey < b.firstKey; });
+    for (CsvColumn::Type type : types)
+    {
+        merged.columns.append(CsvColumn(type));
+    }
+    for (qsizetype begin = 0; begin < parts.size();)
+    {
+        qsizetype end = begin + 1;
+        double lastKey = parts.at(begin).lastKey;
+        while (end < parts.size() && parts.at(end).firstKey <= lastKey)
+        {
+            lastKey = qMax(lastKey, parts.at(end).lastKey);
+            ++end;
+        }
+        if (end - begin == 1 && parts.at(begin).sorted)
+        {
+            for (qsizetype c = 0; c < merged.columns.size(); ++c)
+            {
+                merged.columns[c].append(parts.at(begin).columns.at(c));
+            }
+        }
+        else
+        {
+            mergeOverlapping(parts, begin, end, keyColumn, merged.columns);
+        }
+        begin = end;
+    }
+    return merged;
+}
@@ -0,0 +1,43 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include "csvparser.h"
+
+// A series split over several files, such as one csv per trading day, named by
+// a directory or a glob pattern. The files are read separately and combined into
+// one table by merge: files whose key ranges don't overlap are concatenated in
+// key order, overlapping ones are merged row by row with duplicate keys dropped.
+class Dataset
+{
+public:
+    // the total size and latest modification time of the files of a source, which change when one of
+    // them is written to, added or removed
+    struct Stamp
+    {
+        qint64 size = -1;
+        qint64 modified = -1;
+
+        bool operator==(const Stamp& other) const
+        {
+            return size == other.size && modified == other.modified;
+        }
+        bool operator!=(const Stamp& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    // true if path is a directory or its file name is a glob pattern
+    static bool isDataset(const QString& path);
+    // the csv, series and arrow files of a directory or the files matching a glob pattern, by name
+    static QStringList files(const QString& path);
+    // the stamp of path, a dataset or a single file
+    static Stamp stamp(const QString& path);
+
+    // the rows of tables ordered by the timestamp column (else the first), the other columns matched
+    // by name. Cells of columns a table doesn't have are empty. Where tables overlap, or a table's rows
+    // are out of order, rows without a key are dropped and of rows with equal keys the first is kept
+    static CsvTable merge(QVector<CsvTable> tables);
+};
+
+#endif // DATASET_H
@@ -40,6 +40,7 @@ MainWindow::MainWindow(QWidget* parent)
 void MainWindow::addChartMenuAction()
 {
     ChartWindow* chartWindow = new ChartWindow(this);
+    chartWindow->setAttribute(Qt::WA_DeleteOnClose); // a closed chart lets go of its shared dataset
     chartWindow->show();
 }
 
@@ -1210,6 +1210,7 @@ void QCPLayer::replot()
         {
             pb->clear(Qt::transparent);
             drawToPaintBuffer();
+            mParentPlot->frameArena()->reset();
             pb->setInvalidated(false); // since layer is lmBuffered, we know only this layer is on buffer and we can
                                        // reset invalidated flag
             mParentPlot->update();
@@ -11490,6 +11491,542 @@ void QCPScatterStyle::drawShape(QCPPainter* painter, double x, double y) const
 }
 /* end of 'src/scatterstyle.cpp' */
 
+/* including file 'src/datacolumn.cpp'      */
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define QCP_DATACOLUMN_X86
+#include <immintrin.h>
+#endif
+#if defined(QCP_DATACOLUMN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define QCP_DATACOLUMN_AVX2 // msvc builds don't probe the cpu and stay on sse2
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataColumn
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \internal
+
+  Widens \a minimum and \a maximum to the values among \a values [\a begin, \a end) that lie in the
+  open interval (\a above, \a below), which skips NaN as well.
+*/
+template <class T>
+static void qcpScalarExtent(
+    const T* values, int begin, int end, double above, double below, double& minimum, double& maximum)
+{
+    for (int i = begin; i < end; ++i)
+    {
+        const double value = double(values[i]);
+        if (value > above && value < below)
+        {
+            minimum = qMin(minimum, value);
+            maximum = qMax(maximum, value);
+        }
+    }
+}
+
+#ifdef QCP_DATACOLUMN_X86
+/*! \internal
+
+  The SSE2 kernels of \ref QCPDataColumn::extent. Values outside (\a above, \a below) and NaN are
+  replaced by the neutral infinity of the minimum and maximum before they are compared, the lanes
+  are reduced at the end and the remainder is left to the scalar loop.
+*/
+static void qcpSse2Extent(
+    const float* values, int begin, int end, double above, double below, double& minimum, double& maximum)
+{
+    const __m128 infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    const __m128 negativeInfinity = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+    const __m128 lowest = _mm_set1_ps(float(above));
+    const __m128 highest = _mm_set1_ps(float(below));
+    __m128 lower = infinity;
+    __m128 upper = negativeInfinity;
+    int i = begin;
+    for (; end - i >= 4; i += 4)
+    {
+        const __m128 value = _mm_loadu_ps(values + i);
+        const __m128 inside = _mm_and_ps(_mm_cmpgt_ps(value, lowest), _mm_cmplt_ps(value, highest)); // false for NaN
+        lower = _mm_min_ps(lower, _mm_or_ps(_mm_and_ps(inside, value), _mm_andnot_ps(inside, infinity)));
+        upper = _mm_max_ps(upper, _mm_or_ps(_mm_and_ps(inside, value), _mm_andnot_ps(inside, negativeInfinity)));
+    }
+    float lanes[8];
+    _mm_storeu_ps(lanes, lower);
+    _mm_storeu_ps(lanes + 4, upper);
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        minimum = qMin(minimum, double(lanes[lane]));
+        maximum = qMax(maximum, double(lanes[lane + 4]));
+    }
+    qcpScalarExtent(values, i, end, above, below, minimum, maximum);
+}
+
+static void qcpSse2Extent(
+    const double* values, int begin, int end, double above, double below, double& minimum, double& maximum)
+{
+    const __m128d infinity = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    const __m128d negativeInfinity = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+    const __m128d lowest = _mm_set1_pd(above);
+    const __m128d highest = _mm_set1_pd(below);
+    __m128d lower = infinity;
+    __m128d upper = negativeInfinity;
+    int i = begin;
+    for (; end - i >= 2; i += 2)
+    {
+        const __m128d value = _mm_loadu_pd(values + i);
+        const __m128d inside = _mm_and_pd(_mm_cmpgt_pd(value, lowest), _mm_cmplt_pd(value, highest));
+        lower = _mm_min_pd(lower, _mm_or_pd(_mm_and_pd(inside, value), _mm_andnot_pd(inside, infinity)));
+        upper = _mm_max_pd(upper, _mm_or_pd(_mm_and_pd(inside, value), _mm_andnot_pd(inside, negativeInfinity)));
+    }
+    double lanes[4];
+    _mm_storeu_pd(lanes, lower);
+    _mm_storeu_pd(lanes + 2, upper);
+    minimum = qMin(minimum, qMin(lanes[0], lanes[1]));
+    maximum = qMax(maximum, qMax(lanes[2], lanes[3]));
+    qcpScalarExtent(values, i, end, above, below, minimum, maximum);
+}
+#endif
+
+#ifdef QCP_DATACOLUMN_AVX2
+/*! \internal
+
+  The AVX2 kernels of \ref QCPDataColumn::extent, twice as wide as the SSE2 ones.
+*/
+__attribute__((target("avx2"))) static void qcpAvx2Extent(
+    const float* values, int begin, int end, double above, double below, double& minimum, double& maximum)
+{
+    const __m256 infinity = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    const __m256 negativeInfinity = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+    const __m256 lowest = _mm256_set1_ps(float(above));
+    const __m256 highest = _mm256_set1_ps(float(below));
+    __m256 lower = infinity;
+    __m256 upper = negativeInfinity;
+    int i = begin;
+    for (; end - i >= 8; i += 8)
+    {
+        const __m256 value = _mm256_loadu_ps(values + i);
+        const __m256 inside =
+            _mm256_and_ps(_mm256_cmp_ps(value, lowest, _CMP_GT_OQ), _mm256_cmp_ps(value, highest, _CMP_LT_OQ));
+        lower = _mm256_min_ps(lower, _mm256_blendv_ps(infinity, value, inside));
+        upper = _mm256_max_ps(upper, _mm256_blendv_ps(negativeInfinity, value, inside));
+    }
+    float lanes[16];
+    _mm256_storeu_ps(lanes, lower);
+    _mm256_storeu_ps(lanes + 8, upper);
+    for (int lane = 0; lane < 8; ++lane)
+    {
+        minimum = qMin(minimum, double(lanes[lane]));
+        maximum = qMax(maximum, double(lanes[lane + 8]));
+    }
+    qcpScalarExtent(values, i, end, above, below, minimum, maximum);
+}
+
+__attribute__((target("avx2"))) static void qcpAvx2Extent(
+    const double* values, int begin, int end, double above, double below, double& minimum, double& maximum)
+{
+    const __m256d infinity = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    const __m256d negativeInfinity = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+    const __m256d lowest = _mm256_set1_pd(above);
+    const __m256d highest = _mm256_set1_pd(below);
+    __m256d lower = infinity;
+    __m256d upper = negativeInfinity;
+    int i = begin;
+    for (; end - i >= 4; i += 4)
+    {
+        const __m256d value = _mm256_loadu_pd(values + i);
+        const __m256d inside =
+            _mm256_and_pd(_mm256_cmp_pd(value, lowest, _CMP_GT_OQ), _mm256_cmp_pd(value, highest, _CMP_LT_OQ));
+        lower = _mm256_min_pd(lower, _mm256_blendv_pd(infinity, value, inside));
+        upper = _mm256_max_pd(upper, _mm256_blendv_pd(negativeInfinity, value, inside));
+    }
+    double lanes[8];
+    _mm256_storeu_pd(lanes, lower);
+    _mm256_storeu_pd(lanes + 4, upper);
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        minimum = qMin(minimum, lanes[lane]);
+        maximum = qMax(maximum, lanes[lane + 4]);
+    }
+    qcpScalarExtent(values, i, end, above, below, minimum, maximum);
+}
+
+static bool qcpHasAvx2()
+{
+    static const bool supported = []
+    {
+        __builtin_cpu_init();
+        return bool(__builtin_cpu_supports("avx2"));
+    }();
+    return supported;
+}
+#endif
+
+/*! \internal
+
+  Dispatches the floating point columns to the widest kernel the cpu runs.
+*/
+template <class T>
+static void qcpFloatExtent(
+    const T* values, int begin, int end, double above, double below, double& minimum, double& maximum)
+{
+#ifdef QCP_DATACOLUMN_AVX2
+    if (qcpHasAvx2())
+        return qcpAvx2Extent(values, begin, end, above, below, minimum, maximum);
+#endif
+#ifdef QCP_DATACOLUMN_X86
+    qcpSse2Extent(values, begin, end, above, below, minimum, maximum);
+#else
+    qcpScalarExtent(values, begin, end, above, below, minimum, maximum);
+#endif
+}
+
+/*!
+  Sets \a minimum and \a maximum to the smallest and largest finite value among the values at the
+  indices [\a begin, \a end). NaN, infinite and missing values are skipped. If there is no finite
+  value, \a minimum is left at positive and \a maximum at negative infinity.
+
+  Floating point columns without missing values are scanned with SIMD instructions. This is what
+  \ref QCPDataContainer::valueRange uses for views, touching only the columns bounding the values.
+*/
+void QCPDataColumn::extent(int begin, int end, double& minimum, double& maximum) const
+{
+    extent(begin, end, QCP::sdBoth, minimum, maximum);
+}
+
+/*! \overload
+
+  Only considers the values in \a signDomain, zero is in neither the positive nor the negative
+  domain. The sign is checked in the same pass, so the SIMD kernels serve every sign domain.
+*/
+void QCPDataColumn::extent(int begin, int end, QCP::SignDomain signDomain, double& minimum, double& maximum) const
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    const double above = signDomain == QCP::sdPositive ? 0 : -infinity;
+    const double below = signDomain == QCP::sdNegative ? 0 : infinity;
+    minimum = infinity;
+    maximum = -infinity;
+    if (!mValidity.isEmpty())
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            const double current = value(i); // NaN if missing
+            if (current > above && current < below)
+            {
+                minimum = qMin(minimum, current);
+                maximum = qMax(maximum, current);
+            }
+        }
+        return;
+    }
+    switch (mType)
+    {
+    case ctInt64:
+        qcpScalarExtent(static_cast<const qint64*>(mValues), begin, end, above, below, minimum, maximum);
+        return;
+    case ctUInt64:
+        qcpScalarExtent(static_cast<const quint64*>(mValues), begin, end, above, below, minimum, maximum);
+        return;
+    case ctFloat32:
+        qcpFloatExtent(static_cast<const float*>(mValues), begin, end, above, below, minimum, maximum);
+        return;
+    case ctFloat64:
+        break;
+    }
+    qcpFloatExtent(static_cast<const double*>(mValues), begin, end, above, below, minimum, maximum);
+}
+
+/* end of 'src/datacolumn.cpp' */
+
+/* including file 'src/rangeindex.cpp'      */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPRangeIndex
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \fn int QCPRangeIndex::size() const
+
+  Returns the number of data points the blocks of this index summarize.
+*/
+
+/*!
+  Creates an empty index without a window.
+*/
+QCPRangeIndex::QCPRangeIndex()
+    : mOffset(0)
+    , mEnd(0)
+    , mLeaves(0)
+    , mWindowed(false)
+{
+}
+
+/*!
+  Removes all blocks, the index summarizes no data points afterwards. The room of a window is kept.
+*/
+void QCPRangeIndex::clear()
+{
+    mOffset = 0;
+    mEnd = 0;
+    if (mWindowed)
+        return;
+    mLeaves = 0;
+    mLower.clear();
+    mUpper.clear();
+}
+
+/*!
+  Drops the blocks from the one holding data point \a size on, for data points removed from the
+  end. The blocks before it are kept.
+*/
+void QCPRangeIndex::truncate(int size)
+{
+    mEnd = qMin(mEnd, (mOffset + size) / blockSize * blockSize);
+}
+
+/*!
+  Shifts the blocks for \a count data points removed from the front. Blocks holding removed points
+  are no longer looked up as a whole. With a window, block positions are kept below a few windows,
+  so an index evicting points forever doesn't run out of them.
+*/
+void QCPRangeIndex::evict(int count)
+{
+    mOffset += count;
+    if (mWindowed && mOffset >= blockSize * mLeaves)
+    {
+        // shifting by the whole tree keeps every block on its leaf
+        const int shift = mOffset / (blockSize * mLeaves) * (blockSize * mLeaves);
+        mOffset -= shift;
+        mEnd = qMax(mEnd - shift, mOffset);
+    }
+}
+
+/*!
+  Gives the tree fixed room for the blocks of any \a size consecutive data points, for containers
+  that never hold more than \a size points (see \ref QCPDataContainer::setCapacity). A \a size of
+  0 lets the tree grow with the points instead. Clears the index.
+*/
+void QCPRangeIndex::setWindow(int size)
+{
+    mWindowed = false;
+    clear();
+    if (size <= 0)
+        return;
+    // a run of size points touches one block more than it fills, one more is being appended to
+    int leaves = 1;
+    while (leaves < size / blockSize + 2)
+        leaves *= 2;
+    mLeaves = leaves;
+    mLower = QVector<double>(2 * leaves, std::numeric_limits<double>::infinity());
+    mUpper = QVector<double>(2 * leaves, -std::numeric_limits<double>::infinity());
+    mWindowed = true;
+}
+
+/*! \internal
+
+  Sets the lowest lower bound \a lower and highest upper bound \a upper of the data points in \a
+  block, and updates the nodes of the tree above it. A block without finite bounds has \a lower at
+  positive and \a upper at negative infinity.
+
+  Without a window, setting a block beyond the ones the tree has room for doubles its leaves until
+  it fits, so setting the blocks in ascending order as points are appended is amortized logarithmic
+  per block.
+*/
+void QCPRangeIndex::setBlock(int block, double lower, double upper)
+{
+    if (mWindowed)
+        block %= mLeaves;
+    else if (block >= mLeaves)
+    {
+        int leaves = qMax(mLeaves, 1);
+        while (leaves <= block)
+            leaves *= 2;
+        QVector<double> newLower(2 * leaves, std::numeric_limits<double>::infinity());
+        QVector<double> newUpper(2 * leaves, -std::numeric_limits<double>::infinity());
+        std::copy(mLower.constBegin() + mLeaves, mLower.constEnd(), newLower.begin() + leaves);
+        std::copy(mUpper.constBegin() + mLeaves, mUpper.constEnd(), newUpper.begin() + leaves);
+        for (int node = leaves - 1; node > 0; --node)
+        {
+            newLower[node] = qMin(newLower.at(2 * node), newLower.at(2 * node + 1));
+            newUpper[node] = qMax(newUpper.at(2 * node), newUpper.at(2 * node + 1));
+        }
+        mLower.swap(newLower);
+        mUpper.swap(newUpper);
+        mLeaves = leaves;
+    }
+    int node = mLeaves + block;
+    mLower[node] = lower;
+    mUpper[node] = upper;
+    for (node /= 2; node > 0; node /= 2)
+    {
+        mLower[node] = qMin(mLower.at(2 * node), mLower.at(2 * node + 1));
+        mUpper[node] = qMax(mUpper.at(2 * node), mUpper.at(2 * node + 1));
+    }
+}
+
+/*! \internal
+
+  Sets \a lower and \a upper to the lowest lower and highest upper bound of the blocks [\a
+  beginBlock, \a endBlock), which must have been set. With a window, the blocks may wrap around the
+  end of the leaves.
+*/
+void QCPRangeIndex::blockRange(int beginBlock, int endBlock, double& lower, double& upper) const
+{
+    lower = std::numeric_limits<double>::infinity();
+    upper = -std::numeric_limits<double>::infinity();
+    if (mWindowed)
+    {
+        const int count = endBlock - beginBlock;
+        beginBlock %= mLeaves;
+        endBlock = beginBlock + count;
+        if (endBlock > mLeaves)
+        {
+            leafRange(0, endBlock - mLeaves, lower, upper);
+            endBlock = mLeaves;
+        }
+    }
+    leafRange(beginBlock, endBlock, lower, upper);
+}
+
+/*! \internal
+
+  Widens \a lower and \a upper to the bounds of the leaves [\a beginLeaf, \a endLeaf), visiting
+  two nodes per level of the tree at most.
+*/
+void QCPRangeIndex::leafRange(int beginLeaf, int endLeaf, double& lower, double& upper) const
+{
+    for (int left = mLeaves + beginLeaf, right = mLeaves + endLeaf; left < right; left /= 2, right /= 2)
+    {
+        if (left & 1)
+        {
+            lower = qMin(lower, mLower.at(left));
+            upper = qMax(upper, mUpper.at(left));
+            ++left;
+        }
+        if (right & 1)
+        {
+            --right;
+            lower = qMin(lower, mLower.at(right));
+            upper = qMax(upper, mUpper.at(right));
+        }
+    }
+}
+
+/* end of 'src/rangeindex.cpp' */
+
+/* including file 'src/keygrid.cpp'         */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPKeyGrid
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \fn int QCPKeyGrid::size() const
+
+  Returns the number of data points the runs cover.
+*/
+
+/*! \fn bool QCPKeyGrid::isRegular() const
+
+  Returns whether the keys of the data points lie on a grid with few enough gaps for \ref locate.
+  Once false, it stays so until the index is cleared.
+*/
+
+/*! \fn double QCPKeyGrid::stride() const
+
+  Returns the step between the keys of a run, or 0 if it isn't known yet.
+*/
+
+/*!
+  Creates an empty index.
+*/
+QCPKeyGrid::QCPKeyGrid()
+    : mStride(0)
+    , mOffset(0)
+    , mEnd(0)
+    , mFirstRun(0)
+    , mIrregular(false)
+{
+}
+
+/*!
+  Removes all runs and forgets the stride, the index covers no data points afterwards.
+*/
+void QCPKeyGrid::clear()
+{
+    mStride = 0;
+    mOffset = 0;
+    mEnd = 0;
+    mFirstRun = 0;
+    mIrregular = false;
+    mRuns.clear();
+}
+
+/*!
+  Drops the runs from data point \a size on, for data points removed from the end. The runs before
+  it are kept.
+*/
+void QCPKeyGrid::truncate(int size)
+{
+    mEnd = qMin(mEnd, mOffset + qMax(0, size));
+    while (mRuns.size() > mFirstRun && mRuns.last().index >= mEnd)
+        mRuns.removeLast();
+}
+
+/*!
+  Shifts the runs for \a count data points removed from the front. Runs left without points are
+  dropped, so the table stays as short as the runs of the remaining points.
+*/
+void QCPKeyGrid::evict(int count)
+{
+    mOffset += count;
+    if (mOffset >= mEnd)
+    {
+        // nothing indexed is left, the next update starts a new run
+        mRuns.clear();
+        mFirstRun = 0;
+        mEnd = mOffset;
+    }
+    else
+    {
+        while (mFirstRun + 1 < mRuns.size() && mRuns.at(mFirstRun + 1).index <= mOffset)
+            ++mFirstRun;
+    }
+    // drop the runs evicted once they make up half the table, and keep positions far below overflow
+    if (mFirstRun > pointsPerRun && mFirstRun * 2 > mRuns.size())
+    {
+        mRuns.remove(0, mFirstRun);
+        mFirstRun = 0;
+    }
+    if (mOffset >= (1 << 30))
+    {
+        for (Run& run : mRuns)
+            run.index -= mOffset;
+        mEnd -= mOffset;
+        mOffset = 0;
+    }
+}
+
+/*!
+  Returns the index of the first data point with a sort key not less than \a sortKey, as far as
+  the grid tells it. Keys that were a little off the grid may make it miss by a point or so, which
+  the caller settles by comparing the keys beside it. Returns -1 if nothing can be located, because
+  the index covers no points or isn't regular.
+*/
+int QCPKeyGrid::locate(double sortKey) const
+{
+    if (mIrregular || mFirstRun >= mRuns.size())
+        return -1;
+    // the last run starting at or before sortKey, halving without branches since lookups are random
+    const Run* run = mRuns.constData() + mFirstRun;
+    if (sortKey < run->key)
+        return 0;
+    for (int count = mRuns.size() - mFirstRun; count > 1; count -= count / 2)
+        run = run[count / 2].key <= sortKey ? run + count / 2 : run;
+    const int runEnd = run + 1 == mRuns.constData() + mRuns.size() ? mEnd : (run + 1)->index;
+    const double offset = std::ceil((sortKey - run->key) / mStride);
+    const int index = offset < runEnd - run->index ? run->index + int(offset) : runEnd;
+    return qMax(index, mOffset) - mOffset;
+}
+
+/* end of 'src/keygrid.cpp' */
+
 /* including file 'src/plottable.cpp'       */
 /* modified 2022-11-06T12:45:56, size 38818 */
 
@@ -13769,6 +14306,103 @@ QCP::Interaction QCPAbstractItem::selectionCategory() const
 }
 /* end of 'src/item.cpp' */
 
+/* including file 'src/framearena.cpp'      */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPFrameArena
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \fn qint64 QCPFrameArena::allocations() const
+
+  Returns the number of heap allocations of the buffers since the arena was created. A buffer that
+  grew several times in one frame counts once.
+*/
+
+/*! \fn int QCPFrameArena::frameAllocations() const
+
+  Returns the number of heap allocations of the buffers taken in the last frame, up to its \ref
+  reset. Once every buffer has grown to the size the frames need, this is zero.
+*/
+
+/*!
+  Creates an arena without buffers.
+*/
+QCPFrameArena::QCPFrameArena()
+    : mAllocations(0)
+    , mFrameAllocations(0)
+    , mTakeAllocations(0)
+    , mScoped(false)
+{
+}
+
+QCPFrameArena::~QCPFrameArena()
+{
+    qDeleteAll(mPools);
+}
+
+/*!
+  Ends the frame: takes back every buffer taken since the last reset, keeping their capacity for
+  the next frame, and counts the allocations of the frame. References to the buffers must not be
+  used after this.
+*/
+void QCPFrameArena::reset()
+{
+    int allocations = mTakeAllocations;
+    foreach (AbstractPool* pool, mPools)
+    {
+        if (pool)
+            allocations += pool->reset();
+    }
+    mTakeAllocations = 0;
+    mFrameAllocations = allocations;
+    mAllocations += allocations;
+}
+
+/*! \internal
+
+  Returns a new index into the pools of the arenas, called once per container type.
+*/
+int QCPFrameArena::nextPoolIndex()
+{
+    static QAtomicInt count(0);
+    return count.fetchAndAddRelaxed(1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPFrameArena::Scope
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!
+  Opens a scope of \a arena: the buffers taken from it from now on are taken back when the scope
+  is destroyed, rather than by the next \ref QCPFrameArena::reset. Their allocations are counted
+  to the frame that isn't reset yet.
+*/
+QCPFrameArena::Scope::Scope(QCPFrameArena* arena)
+    : mArena(arena->mScoped ? nullptr : arena)
+{
+    if (!mArena)
+        return;
+    mArena->mScoped = true;
+    foreach (AbstractPool* pool, mArena->mPools)
+    {
+        if (pool)
+            pool->markScope();
+    }
+}
+
+QCPFrameArena::Scope::~Scope()
+{
+    if (!mArena)
+        return;
+    foreach (AbstractPool* pool, mArena->mPools)
+    {
+        if (pool)
+            mArena->mTakeAllocations += pool->rewindScope();
+    }
+    mArena->mScoped = false;
+}
+/* end of 'src/framearena.cpp' */
+
 /* including file 'src/core.cpp'             */
 /* modified 2022-11-06T12:45:56, size 127625 */
 
@@ -15684,6 +16318,7 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
         layer->drawToPaintBuffer();
     foreach (QSharedPointer<QCPAbstractPaintBuffer> buffer, mPaintBuffers)
         buffer->setInvalidated(false);
+    mFrameArena.reset(); // the plottables' scratch buffers are free for the next frame
 
     if ((refreshPriority == rpRefreshHint && mPlottingHints.testFlag(QCP::phImmediateRefresh)) ||
         refreshPriority == rpImmediateRefresh)
@@ -15717,6 +16352,13 @@ double QCustomPlot::replotTime(bool average) const
     return average ? mReplotTimeAverage : mReplotTime;
 }
 
+/*! \fn QCPFrameArena* QCustomPlot::frameArena()
+
+  Returns the arena the plottables take their scratch buffers from while drawing. It is reset after
+  each replot, its \ref QCPFrameArena::frameAllocations tell whether the last one needed heap
+  allocations for them.
+*/
+
 /*!
   Rescales the axes such that all plottables (like graphs) in the plot are fully visible.
 
@@ -16311,6 +16953,7 @@ void QCustomPlot::draw(QCPPainter* painter)
     // draw all layered objects (grid, axes, plottables, items, legend,...):
     foreach (QCPLayer* layer, mLayers)
         layer->draw(painter);
+    mFrameArena.reset();
 
     /* Debug code to draw all layout element rects
     foreach (QCPLayoutElement *el, findChildren<QCPLayoutElement*>())
@@ -21874,11 +22517,15 @@ void QCPGraph::draw(QCPPainter* painter)
     if (mLineStyle == lsNone && mScatterStyle.isNone())
         return;
 
-    QVector<QPointF> lines,
-        scatters; // line and (if necessary) scatter pixel coordinates will be stored here while iterating over segments
+    // line and (if necessary) scatter pixel coordinates will be stored here while iterating over segments:
+    QCPFrameArena* arena = mParentPlot->frameArena();
+    QVector<QPointF>& lines = arena->take<QVector<QPointF> >();
+    QVector<QPointF>& scatters = arena->take<QVector<QPointF> >();
 
     // loop over and draw segments of unselected/selected data:
-    QList<QCPDataRange> selectedSegments, unselectedSegments, allSegments;
+    QList<QCPDataRange>& selectedSegments = arena->take<QList<QCPDataRange> >();
+    QList<QCPDataRange>& unselectedSegments = arena->take<QList<QCPDataRange> >();
+    QList<QCPDataRange>& allSegments = arena->take<QList<QCPDataRange> >();
     getDataSegments(selectedSegments, unselectedSegments);
     allSegments << unselectedSegments << selectedSegments;
     for (int i = 0; i < allSegments.size(); ++i)
@@ -22014,7 +22661,7 @@ void QCPGraph::getLines(QVector<QPointF>* lines, const QCPDataRange& dataRange)
         return;
     }
 
-    QVector<QCPGraphData> lineData;
+    QVector<QCPGraphData>& lineData = mParentPlot->frameArena()->take<QVector<QCPGraphData> >();
     if (mLineStyle != lsNone)
         getOptimizedLineData(&lineData, begin, end);
 
@@ -22029,19 +22676,19 @@ void QCPGraph::getLines(QVector<QPointF>* lines, const QCPDataRange& dataRange)
             lines->clear();
             break;
         case lsLine:
-            *lines = dataToLines(lineData);
+            dataToLines(lineData, lines);
             break;
         case lsStepLeft:
-            *lines = dataToStepLeftLines(lineData);
+            dataToStepLeftLines(lineData, lines);
             break;
         case lsStepRight:
-            *lines = dataToStepRightLines(lineData);
+            dataToStepRightLines(lineData, lines);
             break;
         case lsStepCenter:
-            *lines = dataToStepCenterLines(lineData);
+            dataToStepCenterLines(lineData, lines);
             break;
         case lsImpulse:
-            *lines = dataToImpulseLines(lineData);
+            dataToImpulseLines(lineData, lines);
             break;
     }
 }
@@ -22079,7 +22726,7 @@ void QCPGraph::getScatters(QVector<QPointF>* scatters, const QCPDataRange& dataR
         return;
     }
 
-    QVector<QCPGraphData> data;
+    QVector<QCPGraphData>& data = mParentPlot->frameArena()->take<QVector<QCPGraphData> >();
     getOptimizedScatterData(&data, begin, end);
 
     if (mKeyAxis->rangeReversed() !=
@@ -22114,7 +22761,7 @@ void QCPGraph::getScatters(QVector<QPointF>* scatters, const QCPDataRange& dataR
 
 /*! \internal
 
-  Takes raw data points in plot coordinates as \a data, and returns a vector containing pixel
+  Takes raw data points in plot coordinates as \a data, and returns via \a lines the pixel
   coordinate points which are suitable for drawing the line style \ref lsLine.
 
   The source of \a data is usually \ref getOptimizedLineData, and this method is called in \a
@@ -22122,15 +22769,16 @@ void QCPGraph::getScatters(QVector<QPointF>* scatters, const QCPDataRange& dataR
 
   \see dataToStepLeftLines, dataToStepRightLines, dataToStepCenterLines, dataToImpulseLines, getLines, drawLinePlot
 */
-QVector<QPointF> QCPGraph::dataToLines(const QVector<QCPGraphData>& data) const
+void QCPGraph::dataToLines(const QVector<QCPGraphData>& data, QVector<QPointF>* lines) const
 {
-    QVector<QPointF> result;
+    QVector<QPointF>& result = *lines;
     QCPAxis* keyAxis = mKeyAxis.data();
     QCPAxis* valueAxis = mValueAxis.data();
     if (!keyAxis || !valueAxis)
     {
         qDebug() << Q_FUNC_INFO << "invalid key or value axis";
-        return result;
+        result.clear();
+        return;
     }
 
     result.resize(data.size());
@@ -22152,12 +22800,11 @@ QVector<QPointF> QCPGraph::dataToLines(const QVector<QCPGraphData>& data) const
             result[i].setY(valueAxis->coordToPixel(data.at(i).value));
         }
     }
-    return result;
 }
 
 /*! \internal
 
-  Takes raw data points in plot coordinates as \a data, and returns a vector containing pixel
+  Takes raw data points in plot coordinates as \a data, and returns via \a lines the pixel
   coordinate points which are suitable for drawing the line style \ref lsStepLeft.
 
   The source of \a data is usually \ref getOptimizedLineData, and this method is called in \a
@@ -22165,15 +22812,16 @@ QVector<QPointF> QCPGraph::dataToLines(const QVector<QCPGraphData>& data) const
 
   \see dataToLines, dataToStepRightLines, dataToStepCenterLines, dataToImpulseLines, getLines, drawLinePlot
 */
-QVector<QPointF> QCPGraph::dataToStepLeftLines(const QVector<QCPGraphData>& data) const
+void QCPGraph::dataToStepLeftLines(const QVector<QCPGraphData>& data, QVector<QPointF>* lines) const
 {
-    QVector<QPointF> result;
+    QVector<QPointF>& result = *lines;
     QCPAxis* keyAxis = mKeyAxis.data();
     QCPAxis* valueAxis = mValueAxis.data();
     if (!keyAxis || !valueAxis)
     {
         qDebug() << Q_FUNC_INFO << "invalid key or value axis";
-        return result;
+        result.clear();
+        return;
     }
 
     result.resize(data.size() * 2);
@@ -22205,12 +22853,11 @@ QVector<QPointF> QCPGraph::dataToStepLeftLines(const QVector<QCPGraphData>& data
             result[i * 2 + 1].setY(lastValue);
         }
     }
-    return result;
 }
 
 /*! \internal
 
-  Takes raw data points in plot coordinates as \a data, and returns a vector containing pixel
+  Takes raw data points in plot coordinates as \a data, and returns via \a lines the pixel
   coordinate points which are suitable for drawing the line style \ref lsStepRight.
 
   The source of \a data is usually \ref getOptimizedLineData, and this method is called in \a
@@ -22218,15 +22865,16 @@ QVector<QPointF> QCPGraph::dataToStepLeftLines(const QVector<QCPGraphData>& data
 
   \see dataToLines, dataToStepLeftLines, dataToStepCenterLines, dataToImpulseLines, getLines, drawLinePlot
 */
-QVector<QPointF> QCPGraph::dataToStepRightLines(const QVector<QCPGraphData>& data) const
+void QCPGraph::dataToStepRightLines(const QVector<QCPGraphData>& data, QVector<QPointF>* lines) const
 {
-    QVector<QPointF> result;
+    QVector<QPointF>& result = *lines;
     QCPAxis* keyAxis = mKeyAxis.data();
     QCPAxis* valueAxis = mValueAxis.data();
     if (!keyAxis || !valueAxis)
     {
         qDebug() << Q_FUNC_INFO << "invalid key or value axis";
-        return result;
+        result.clear();
+        return;
     }
 
     result.resize(data.size() * 2);
@@ -22258,12 +22906,11 @@ QVector<QPointF> QCPGraph::dataToStepRightLines(const QVector<QCPGraphData>& dat
             result[i * 2 + 1].setY(value);
         }
     }
-    return result;
 }
 
 /*! \internal
 
-  Takes raw data points in plot coordinates as \a data, and returns a vector containing pixel
+  Takes raw data points in plot coordinates as \a data, and returns via \a lines the pixel
   coordinate points which are suitable for drawing the line style \ref lsStepCenter.
 
   The source of \a data is usually \ref getOptimizedLineData, and this method is called in \a
@@ -22271,15 +22918,16 @@ QVector<QPointF> QCPGraph::dataToStepRightLines(const QVector<QCPGraphData>& dat
 
   \see dataToLines, dataToStepLeftLines, dataToStepRightLines, dataToImpulseLines, getLines, drawLinePlot
 */
-QVector<QPointF> QCPGraph::dataToStepCenterLines(const QVector<QCPGraphData>& data) const
+void QCPGraph::dataToStepCenterLines(const QVector<QCPGraphData>& data, QVector<QPointF>* lines) const
 {
-    QVector<QPointF> result;
+    QVector<QPointF>& result = *lines;
     QCPAxis* keyAxis = mKeyAxis.data();
     QCPAxis* valueAxis = mValueAxis.data();
     if (!keyAxis || !valueAxis)
     {
         qDebug() << Q_FUNC_INFO << "invalid key or value axis";
-        return result;
+        result.clear();
+        return;
     }
 
     result.resize(data.size() * 2);
@@ -22323,12 +22971,11 @@ QVector<QPointF> QCPGraph::dataToStepCenterLines(const QVector<QCPGraphData>& da
         result[data.size() * 2 - 1].setX(lastKey);
         result[data.size() * 2 - 1].setY(lastValue);
     }
-    return result;
 }
 
 /*! \internal
 
-  Takes raw data points in plot coordinates as \a data, and returns a vector containing pixel
+  Takes raw data points in plot coordinates as \a data, and returns via \a lines the pixel
   coordinate points which are suitable for drawing the line style \ref lsImpulse.
 
   The source of \a data is usually \ref getOptimizedLineData, and this method is called in \a
@@ -22336,15 +22983,16 @@ QVector<QPointF> QCPGraph::dataToStepCenterLines(const QVector<QCPGraphData>& da
 
   \see dataToLines, dataToStepLeftLines, dataToStepRightLines, dataToStepCenterLines, getLines, drawImpulsePlot
 */
-QVector<QPointF> QCPGraph::dataToImpulseLines(const QVector<QCPGraphData>& data) const
+void QCPGraph::dataToImpulseLines(const QVector<QCPGraphData>& data, QVector<QPointF>* lines) const
 {
-    QVector<QPointF> result;
+    QVector<QPointF>& result = *lines;
     QCPAxis* keyAxis = mKeyAxis.data();
     QCPAxis* valueAxis = mValueAxis.data();
     if (!keyAxis || !valueAxis)
     {
         qDebug() << Q_FUNC_INFO << "invalid key or value axis";
-        return result;
+        result.clear();
+        return;
     }
 
     result.resize(data.size() * 2);
@@ -22390,7 +23038,6 @@ QVector<QPointF> QCPGraph::dataToImpulseLines(const QVector<QCPGraphData>& data)
             }
         }
     }
-    return result;
 }
 
 /*! \internal
@@ -22428,7 +23075,7 @@ void QCPGraph::drawFill(QCPPainter* painter, QVector<QPointF>* lines) const
     else
     {
         // draw fill between this graph and mChannelFillGraph:
-        QVector<QPointF> otherLines;
+        QVector<QPointF>& otherLines = mParentPlot->frameArena()->take<QVector<QPointF> >();
         mChannelFillGraph->getLines(&otherLines, QCPDataRange(0, mChannelFillGraph->dataCount()));
         if (!otherLines.isEmpty())
         {
@@ -23396,7 +24043,8 @@ double QCPGraph::pointDistance(const QPointF& pixelPoint, QCPGraphDataContainer:
     if (mLineStyle != lsNone)
     {
         // line displayed, calculate distance to line segments:
-        QVector<QPointF> lineData;
+        QCPFrameArena::Scope scope(mParentPlot->frameArena()); // gives the buffers back on return
+        QVector<QPointF>& lineData = mParentPlot->frameArena()->take<QVector<QPointF> >();
         getLines(&lineData,
             QCPDataRange(0, dataCount())); // don't limit data range further since with sharp data spikes, line segments
                                            // may be closer to test point than segments with closer key coordinate
@@ -26127,6 +26775,17 @@ QCPRange QCPBars::getValueRange(bool& foundRange, QCP::SignDomain inSignDomain,
     range.upper = mBaseValue;
     bool haveLower = true; // set to true, because baseValue should always be visible in bar charts
     bool haveUpper = true; // set to true, because baseValue should always be visible in bar charts
+    if (!mBarBelow && inSignDomain == QCP::sdBoth)
+    {
+        // unstacked bars span their values offset by the base value, which the container's range
+        // index finds without visiting every bar:
+        bool foundValues;
+        const QCPRange values = mDataContainer->valueRange(foundValues, QCP::sdBoth, inKeyRange);
+        if (foundValues)
+            range.expand(QCPRange(values.lower + mBaseValue, values.upper + mBaseValue));
+        foundRange = true;
+        return range;
+    }
     QCPBarsDataContainer::const_iterator itBegin = mDataContainer->constBegin();
     QCPBarsDataContainer::const_iterator itEnd = mDataContainer->constEnd();
     if (inKeyRange != QCPRange())
@@ -26137,7 +26796,7 @@ QCPRange QCPBars::getValueRange(bool& foundRange, QCP::SignDomain inSignDomain,
     for (QCPBarsDataContainer::const_iterator it = itBegin; it != itEnd; ++it)
     {
         const double current = it->value + getStackedBaseValue(it->key, it->value >= 0);
-        if (qIsNaN(current))
+        if (!std::isfinite(current)) // like the container's valueRange above, also skips NaN
             continue;
         if (inSignDomain == QCP::sdBoth || (inSignDomain == QCP::sdNegative && current < 0) ||
             (inSignDomain == QCP::sdPositive && current > 0))
@@ -26203,7 +26862,10 @@ void QCPBars::draw(QCPPainter* painter)
     getVisibleDataBounds(visibleBegin, visibleEnd);
 
     // loop over and draw segments of unselected/selected data:
-    QList<QCPDataRange> selectedSegments, unselectedSegments, allSegments;
+    QCPFrameArena* arena = mParentPlot->frameArena();
+    QList<QCPDataRange>& selectedSegments = arena->take<QList<QCPDataRange> >();
+    QList<QCPDataRange>& unselectedSegments = arena->take<QList<QCPDataRange> >();
+    QList<QCPDataRange>& allSegments = arena->take<QList<QCPDataRange> >();
     getDataSegments(selectedSegments, unselectedSegments);
     allSegments << unselectedSegments << selectedSegments;
     for (int i = 0; i < allSegments.size(); ++i)
@@ -26235,7 +26897,11 @@ void QCPBars::draw(QCPPainter* painter)
                 painter->setPen(mPen);
             }
             applyDefaultAntialiasingHint(painter);
-            painter->drawPolygon(getBarRect(it->key, it->value));
+            // the closed polygon of the rect, without the heap allocation of a QPolygonF:
+            const QRectF barRect = getBarRect(it->key, it->value);
+            const QPointF barPolygon[] = {
+                barRect.topLeft(), barRect.topRight(), barRect.bottomRight(), barRect.bottomLeft(), barRect.topLeft()};
+            painter->drawPolygon(barPolygon, 5);
         }
     }
 
@@ -28490,6 +29156,221 @@ QCPFinancialData::QCPFinancialData(double key, double open, double high, double
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPCompactFinancialData
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPCompactFinancialData
+  \brief Holds financial data points in single precision for QCPFinancial.
+
+  The keys are stored as doubles, the open, high, low and close values as floats, in a column each.
+  A point takes 24 bytes instead of the 40 of a \ref QCPFinancialData, which matters for charts
+  holding many series of bars. Single precision keeps about seven significant digits, so prices
+  below 100000 keep their cents.
+
+  A \ref QCPFinancialDataContainer draws from the columns in place (see \ref view and \ref
+  QCPDataContainer::setView), so a \ref QCPFinancial using it draws and selects the points as if
+  it held them.
+
+  Points appended behind the last one are written into spare room of the columns, which grows
+  geometrically. Copies share the columns. Only the object that grew them appends in place, a copy
+  moves to new columns when points are added to it, so the points a view reads never change.
+*/
+
+/*! \fn int QCPCompactFinancialData::size() const
+
+  Returns the number of data points.
+*/
+
+/*! \fn bool QCPCompactFinancialData::isEmpty() const
+
+  Returns whether there are no data points.
+*/
+
+/*!
+  Creates an empty object.
+*/
+QCPCompactFinancialData::QCPCompactFinancialData()
+    : mSize(0)
+    , mCapacity(0)
+    , mAppendable(false)
+    , mRewritten(true)
+{
+}
+
+/*!
+  Creates a copy of \a other, sharing its columns.
+*/
+QCPCompactFinancialData::QCPCompactFinancialData(const QCPCompactFinancialData& other)
+    : mKeys(other.mKeys)
+    , mPrices(other.mPrices)
+    , mSize(other.mSize)
+    , mCapacity(other.mCapacity)
+    , mAppendable(false) // the room behind the points stays with other
+    , mRewritten(other.mRewritten)
+{
+}
+
+/*!
+  Makes this object a copy of \a other, sharing its columns.
+*/
+QCPCompactFinancialData& QCPCompactFinancialData::operator=(const QCPCompactFinancialData& other)
+{
+    if (this != &other)
+    {
+        mKeys = other.mKeys;
+        mPrices = other.mPrices;
+        mSize = other.mSize;
+        mCapacity = other.mCapacity;
+        mAppendable = false;
+        mRewritten = other.mRewritten;
+    }
+    return *this;
+}
+
+/*!
+  Returns the bytes taken by the columns, including their spare room.
+*/
+qint64 QCPCompactFinancialData::byteSize() const
+{
+    return qint64(mCapacity) * qint64(sizeof(double) + 4 * sizeof(float));
+}
+
+/*!
+  Replaces the data points with \a data, whose values are rounded to single precision.
+
+  If \a data is sorted by key already, set \a alreadySorted to true to skip sorting a copy of it.
+*/
+void QCPCompactFinancialData::set(const QVector<QCPFinancialData>& data, bool alreadySorted)
+{
+    clear();
+    add(data, alreadySorted);
+}
+
+/*!
+  Adds the data points in \a data, whose values are rounded to single precision. Points with keys
+  not less than the last key are appended in place, others are merged in, which rewrites the
+  columns.
+
+  If \a data is sorted by key already, set \a alreadySorted to true to skip sorting a copy of it.
+*/
+void QCPCompactFinancialData::add(const QVector<QCPFinancialData>& data, bool alreadySorted)
+{
+    if (data.isEmpty())
+        return;
+    if (!alreadySorted)
+    {
+        QVector<QCPFinancialData> sorted = data;
+        std::sort(sorted.begin(), sorted.end(), qcpLessThanSortKey<QCPFinancialData>);
+        add(sorted, true);
+        return;
+    }
+    if (mSize > 0 && data.first().key < mKeys.get()[mSize - 1])
+    {
+        QVector<QCPFinancialData> merged;
+        merged.reserve(mSize + data.size());
+        for (int i = 0; i < mSize; ++i)
+            merged.append(at(i));
+        merged.append(data);
+        std::inplace_merge(merged.begin(), merged.begin() + mSize, merged.end(), qcpLessThanSortKey<QCPFinancialData>);
+        clear();
+        add(merged, true);
+        return;
+    }
+    reserve(mSize + int(data.size()));
+    double* keys = mKeys.get();
+    float* open = mPrices.get();
+    float* high = open + mCapacity;
+    float* low = high + mCapacity;
+    float* close = low + mCapacity;
+    for (const QCPFinancialData& point : data)
+    {
+        keys[mSize] = point.key;
+        open[mSize] = float(point.open);
+        high[mSize] = float(point.high);
+        low[mSize] = float(point.low);
+        close[mSize] = float(point.close);
+        ++mSize;
+    }
+}
+
+/*!
+  Removes all data points. Views of the columns keep reading them.
+*/
+void QCPCompactFinancialData::clear()
+{
+    mKeys.reset();
+    mPrices.reset();
+    mSize = 0;
+    mCapacity = 0;
+    mAppendable = false;
+    mRewritten = true;
+}
+
+/*!
+  Returns the data point at \a index, which must be less than \ref size.
+*/
+QCPFinancialData QCPCompactFinancialData::at(int index) const
+{
+    const float* open = mPrices.get() + index;
+    const qint64 capacity = mCapacity;
+    return QCPFinancialData(mKeys.get()[index], open[0], open[capacity], open[2 * capacity], open[3 * capacity]);
+}
+
+/*!
+  Returns the key, open, high, low and close columns, which share ownership of the values.
+*/
+QVector<QCPDataColumn> QCPCompactFinancialData::columns() const
+{
+    QVector<QCPDataColumn> columns;
+    columns.append(QCPDataColumn(QCPDataColumn::ctFloat64, mKeys));
+    for (int column = 0; column < 4; ++column)
+        columns.append(QCPDataColumn(
+            QCPDataColumn::ctFloat32, std::shared_ptr<const void>(mPrices, mPrices.get() + column * qint64(mCapacity))));
+    return columns;
+}
+
+/*!
+  Makes \a container a view of the columns. Points added later are picked up by calling this
+  method again. Points appended since the last call extend the view, which keeps the indexes \a
+  container has of the points viewed before. After points were merged in or replaced, the indexes
+  are dropped (see \ref QCPDataContainer::setView). The rewrites are tracked since the last call, so
+  only one container should be kept up to date this way.
+*/
+void QCPCompactFinancialData::view(QCPFinancialDataContainer& container)
+{
+    container.setView(columns(), mSize, !mRewritten);
+    mRewritten = false;
+}
+
+/*! \internal
+
+  Makes room for \a size data points, moving the points to new columns with room for at least
+  twice as many if they don't fit or the room isn't this object's. The old columns stay alive as
+  long as views or copies hold them.
+*/
+void QCPCompactFinancialData::reserve(int size)
+{
+    if (size <= mCapacity && mAppendable)
+        return;
+    const int capacity = qMax(size, 2 * mSize);
+    std::shared_ptr<double> keys(new double[capacity], std::default_delete<double[]>());
+    std::shared_ptr<float> prices(new float[4 * qint64(capacity)], std::default_delete<float[]>());
+    if (mSize > 0)
+    {
+        std::copy(mKeys.get(), mKeys.get() + mSize, keys.get());
+        for (int column = 0; column < 4; ++column)
+        {
+            const float* values = mPrices.get() + column * qint64(mCapacity);
+            std::copy(values, values + mSize, prices.get() + column * qint64(capacity));
+        }
+    }
+    mKeys = keys;
+    mPrices = prices;
+    mCapacity = capacity;
+    mAppendable = true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPFinancial
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -28931,7 +29812,10 @@ void QCPFinancial::draw(QCPPainter* painter)
     getVisibleDataBounds(visibleBegin, visibleEnd);
 
     // loop over and draw segments of unselected/selected data:
-    QList<QCPDataRange> selectedSegments, unselectedSegments, allSegments;
+    QCPFrameArena* arena = mParentPlot->frameArena();
+    QList<QCPDataRange>& selectedSegments = arena->take<QList<QCPDataRange> >();
+    QList<QCPDataRange>& unselectedSegments = arena->take<QList<QCPDataRange> >();
+    QList<QCPDataRange>& allSegments = arena->take<QList<QCPDataRange> >();
     getDataSegments(selectedSegments, unselectedSegments);
     allSegments << unselectedSegments << selectedSegments;
     for (int i = 0; i < allSegments.size(); ++i)
@@ -69,6 +69,8 @@
 
 #include <algorithm>
 #include <limits>
+#include <memory>
+#include <new>
 #include <qmath.h>
 #ifdef QCP_OPENGL_FBO
 #include <QtGui/QOpenGLContext>
@@ -3361,11 +3363,446 @@ inline bool qcpLessThanSortKey(const DataType& a, const DataType& b)
     return a.sortKey() < b.sortKey();
 }
 
+/*! \relates QCPDataContainer
+  A column of values a \ref QCPDataContainer can draw its data points from in place, see \ref
+  QCPDataContainer::setView. The values are stored as one of the \ref Type "types" in memory the
+  column shares ownership of. An optional validity bitmap, in which bit \a i%64 of word \a i/64 is
+  cleared for a missing value, marks values that are read as NaN.
+*/
+class QCP_LIB_DECL QCPDataColumn
+{
+public:
+    enum Type
+    {
+        ctInt64,
+        ctUInt64,
+        ctFloat32,
+        ctFloat64
+    };
+
+    QCPDataColumn()
+        : mType(ctFloat64)
+        , mValues(nullptr)
+    {
+    }
+    QCPDataColumn(Type type, std::shared_ptr<const void> values, const QVector<quint64>& validity = QVector<quint64>())
+        : mType(type)
+        , mValues(values.get())
+        , mOwner(std::move(values))
+        , mValidity(validity)
+    {
+    }
+
+    Type type() const
+    {
+        return mType;
+    }
+    const void* constData() const
+    {
+        return mValues;
+    }
+    bool allValid() const
+    {
+        return mValidity.isEmpty();
+    }
+
+    inline double value(int index) const
+    {
+        if (!mValidity.isEmpty() && !((mValidity.at(index >> 6) >> (index & 63)) & 1))
+            return qQNaN();
+        switch (mType)
+        {
+        case ctInt64:
+            return double(static_cast<const qint64*>(mValues)[index]);
+        case ctUInt64:
+            return double(static_cast<const quint64*>(mValues)[index]);
+        case ctFloat32:
+            return double(static_cast<const float*>(mValues)[index]);
+        case ctFloat64:
+            break;
+        }
+        return static_cast<const double*>(mValues)[index];
+    }
+    void extent(int begin, int end, double& minimum, double& maximum) const;
+    void extent(int begin, int end, QCP::SignDomain signDomain, double& minimum, double& maximum) const;
+
+protected:
+    Type mType;
+    const void* mValues;
+    std::shared_ptr<const void> mOwner;
+    QVector<quint64> mValidity;
+};
+
+/*! \relates QCPDataContainer
+  Describes how a data point of \a DataType is assembled from the columns of a \ref
+  QCPDataContainer::setView "view". Data types can only be viewed if they specialize this template
+  with a nonzero \a columnCount and a static <tt>DataType point(const QCPDataColumn *columns, int
+  index)</tt>. Column 0 always holds the sort key, which must be the main key. The lower bound of the
+  value range of a data point is the value of column \a lowerColumn, the upper bound the one of
+  column \a upperColumn.
+*/
+template <class DataType>
+struct QCPDataColumnLayout
+{
+    enum
+    {
+        columnCount = 0
+    };
+};
+
+/*! \relates QCPDataContainer
+  Summarizes the value ranges of the data points of a \ref QCPDataContainer in blocks of \a
+  blockSize points, and answers the lowest lower and highest upper bound of any run of data points
+  in logarithmic time with a segment tree over the blocks. The container updates the index with the
+  points appended since, see \ref QCPDataContainer::valueRange.
+
+  Blocks are numbered from the first point the index saw, so points evicted from the front (\ref
+  evict) shift the blocks rather than invalidating them. With a window set (\ref setWindow), the
+  tree has fixed room for the blocks of that many points, and blocks reuse the leaves of the blocks
+  a window before them.
+*/
+class QCP_LIB_DECL QCPRangeIndex
+{
+public:
+    enum
+    {
+        blockSize = 64
+    };
+
+    QCPRangeIndex();
+
+    int size() const
+    {
+        return qMax(0, mEnd - mOffset);
+    }
+
+    void clear();
+    void truncate(int size);
+    void evict(int count);
+    void setWindow(int size);
+    template <class Scan>
+    void update(int size, Scan scan);
+    template <class Scan>
+    void range(int begin, int end, double& lower, double& upper, Scan scan) const;
+
+protected:
+    int mOffset;    // the block position of data point 0, the points evicted before it
+    int mEnd;       // the block position behind the last point the blocks summarize
+    int mLeaves;    // the blocks the tree has room for, a power of two
+    bool mWindowed; // the tree has fixed room, block b is leaf b%mLeaves
+    // the tree nodes, node i combines nodes 2i and 2i+1, block b is leaf node mLeaves+b:
+    QVector<double> mLower, mUpper;
+
+    void setBlock(int block, double lower, double upper);
+    void blockRange(int beginBlock, int endBlock, double& lower, double& upper) const;
+    void leafRange(int beginLeaf, int endLeaf, double& lower, double& upper) const;
+};
+
+/*!
+  Sets the blocks of the data points [\ref size, \a size) that were appended since the last call.
+  \a scan is called as <tt>scan(int begin, int end, double &lower, double &upper)</tt> and must
+  widen \a lower and \a upper to the finite bounds of the data points [\a begin, \a end). The last
+  block of the previous call is summarized again, it may have been partial.
+*/
+template <class Scan>
+void QCPRangeIndex::update(int size, Scan scan)
+{
+    const int end = mOffset + size;
+    if (mEnd >= end)
+        return;
+    for (int block = qMax(mEnd, mOffset) / blockSize; block * blockSize < end; ++block)
+    {
+        double lower = std::numeric_limits<double>::infinity();
+        double upper = -std::numeric_limits<double>::infinity();
+        scan(qMax(block * blockSize, mOffset) - mOffset, qMin((block + 1) * blockSize, end) - mOffset, lower, upper);
+        setBlock(block, lower, upper);
+    }
+    mEnd = end;
+}
+
+/*!
+  Sets \a lower and \a upper to the lowest lower and highest upper bound of the data points [\a
+  begin, \a end), which must be within \ref size. The whole blocks of the run are looked up in the
+  tree, the points beside them are passed to \a scan like in \ref update. If none of the points
+  has finite bounds, \a lower is left at positive and \a upper at negative infinity.
+*/
+template <class Scan>
+void QCPRangeIndex::range(int begin, int end, double& lower, double& upper, Scan scan) const
+{
+    lower = std::numeric_limits<double>::infinity();
+    upper = -std::numeric_limits<double>::infinity();
+    const int beginBlock = (mOffset + begin + blockSize - 1) / blockSize;
+    const int endBlock = (mOffset + end) / blockSize;
+    if (beginBlock >= endBlock)
+    {
+        scan(begin, end, lower, upper);
+        return;
+    }
+    blockRange(beginBlock, endBlock, lower, upper);
+    scan(begin, beginBlock * blockSize - mOffset, lower, upper);
+    scan(endBlock * blockSize - mOffset, end, lower, upper);
+}
+
+/*! \relates QCPDataContainer
+  Locates sort keys among data points whose keys lie on a regular grid, like the timestamps of bars
+  of a fixed timeframe, by arithmetic instead of a binary search over the points. The points are
+  split into runs of keys one \ref stride apart, and a key is looked up in the short table of the
+  runs and then offset within its run. Gaps in the grid start a new run. The stride is the smallest
+  step between the first keys.
+
+  Points whose runs average fewer than \a pointsPerRun points aren't located (see \ref isRegular),
+  a binary search over them is about as fast. Like the blocks of \ref QCPRangeIndex, runs are
+  numbered from the first point the index saw, so points evicted from the front (\ref evict) shift
+  them rather than invalidating them.
+*/
+class QCP_LIB_DECL QCPKeyGrid
+{
+public:
+    enum
+    {
+        strideSamples = 1024,
+        pointsPerRun = 16
+    };
+
+    QCPKeyGrid();
+
+    int size() const
+    {
+        return mEnd - mOffset;
+    }
+    bool isRegular() const
+    {
+        return !mIrregular;
+    }
+    double stride() const
+    {
+        return mStride;
+    }
+
+    void clear();
+    void truncate(int size);
+    void evict(int count);
+    template <class Key>
+    void update(int size, Key key);
+    int locate(double sortKey) const;
+
+protected:
+    struct Run
+    {
+        int index;  // the position of the first point of the run
+        double key; // the sort key of that point
+    };
+    double mStride;   // 0 while it isn't known yet
+    int mOffset;      // the position of data point 0, the points evicted before it
+    int mEnd;         // the position behind the last point the runs cover
+    int mFirstRun;    // the first run holding points that weren't evicted
+    bool mIrregular;  // too many runs, nothing is located until cleared
+    QVector<Run> mRuns;
+};
+
+/*!
+  Adds the data points [\ref size, \a size) that were appended since the last call to the runs.
+  \a key is called as <tt>key(int index)</tt> and must return the sort key of data point \a index.
+  The stride is taken from the first call with at least two points.
+*/
+template <class Key>
+void QCPKeyGrid::update(int size, Key key)
+{
+    const int end = mOffset + size;
+    if (mIrregular || mEnd >= end)
+        return;
+    if (mStride == 0)
+    {
+        const int count = qMin(size, int(strideSamples));
+        double stride = std::numeric_limits<double>::infinity();
+        for (int i = 1; i < count; ++i)
+        {
+            const double step = key(i) - key(i - 1);
+            if (step > 0 && step < stride)
+                stride = step;
+        }
+        if (!std::isfinite(stride))
+            return;
+        mStride = stride;
+    }
+    for (int i = mEnd; i < end; ++i)
+    {
+        const double current = key(i - mOffset);
+        if (mFirstRun < mRuns.size())
+        {
+            // keys a small fraction of the stride off the grid stay in the run, lookups settle rounding
+            const Run& run = mRuns.last();
+            if (qAbs(current - (run.key + (i - run.index) * mStride)) <= mStride * 1e-6)
+                continue;
+        }
+        mRuns.append({i, current});
+        if (mRuns.size() - mFirstRun > (i - mOffset) / pointsPerRun + pointsPerRun)
+        {
+            clear();
+            mIrregular = true;
+            return;
+        }
+    }
+    mEnd = end;
+}
+
+/*! \relates QCPDataContainer
+  The const iterator of a \ref QCPDataContainer of a data type that can be viewed (see \ref
+  QCPDataColumnLayout). Dereferencing returns data points by value: copies of the points the
+  container holds, or points assembled from the columns of its view.
+*/
+template <class DataType>
+class QCPDataViewIterator
+{
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef DataType value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef DataType reference;
+    // points to a held data point, or carries an assembled one. Held points aren't copied and the
+    // storage of assembled ones isn't constructed for them
+    class pointer
+    {
+    public:
+        explicit pointer(const DataType* address)
+            : mAddress(address)
+        {
+        }
+        explicit pointer(const DataType& point)
+            : mAddress(nullptr)
+        {
+            new (&mStorage.point) DataType(point);
+        }
+        const DataType* operator->() const
+        {
+            return mAddress ? mAddress : &mStorage.point;
+        }
+
+    private:
+        const DataType* mAddress;
+        union Storage
+        {
+            Storage()
+            {
+            }
+            DataType point;
+        } mStorage;
+    };
+
+    QCPDataViewIterator()
+        : mPoints(nullptr)
+        , mColumns(nullptr)
+        , mIndex(0)
+    {
+    }
+    QCPDataViewIterator(const DataType* points, const QCPDataColumn* columns, int index)
+        : mPoints(points)
+        , mColumns(columns)
+        , mIndex(index)
+    {
+    }
+
+    inline reference operator*() const
+    {
+        return mColumns ? QCPDataColumnLayout<DataType>::point(mColumns, mIndex) : mPoints[mIndex];
+    }
+    inline pointer operator->() const
+    {
+        return mColumns ? pointer(QCPDataColumnLayout<DataType>::point(mColumns, mIndex)) : pointer(mPoints + mIndex);
+    }
+    inline reference operator[](difference_type offset) const
+    {
+        return *(*this + offset);
+    }
+
+    inline QCPDataViewIterator& operator++()
+    {
+        ++mIndex;
+        return *this;
+    }
+    inline QCPDataViewIterator operator++(int)
+    {
+        QCPDataViewIterator previous = *this;
+        ++mIndex;
+        return previous;
+    }
+    inline QCPDataViewIterator& operator--()
+    {
+        --mIndex;
+        return *this;
+    }
+    inline QCPDataViewIterator operator--(int)
+    {
+        QCPDataViewIterator previous = *this;
+        --mIndex;
+        return previous;
+    }
+    inline QCPDataViewIterator& operator+=(difference_type offset)
+    {
+        mIndex += int(offset);
+        return *this;
+    }
+    inline QCPDataViewIterator& operator-=(difference_type offset)
+    {
+        mIndex -= int(offset);
+        return *this;
+    }
+    inline QCPDataViewIterator operator+(difference_type offset) const
+    {
+        return QCPDataViewIterator(mPoints, mColumns, mIndex + int(offset));
+    }
+    inline QCPDataViewIterator operator-(difference_type offset) const
+    {
+        return QCPDataViewIterator(mPoints, mColumns, mIndex - int(offset));
+    }
+    friend inline QCPDataViewIterator operator+(difference_type offset, const QCPDataViewIterator& it)
+    {
+        return it + offset;
+    }
+    inline difference_type operator-(const QCPDataViewIterator& other) const
+    {
+        return mIndex - other.mIndex;
+    }
+
+    inline bool operator==(const QCPDataViewIterator& other) const
+    {
+        return mIndex == other.mIndex;
+    }
+    inline bool operator!=(const QCPDataViewIterator& other) const
+    {
+        return mIndex != other.mIndex;
+    }
+    inline bool operator<(const QCPDataViewIterator& other) const
+    {
+        return mIndex < other.mIndex;
+    }
+    inline bool operator>(const QCPDataViewIterator& other) const
+    {
+        return mIndex > other.mIndex;
+    }
+    inline bool operator<=(const QCPDataViewIterator& other) const
+    {
+        return mIndex <= other.mIndex;
+    }
+    inline bool operator>=(const QCPDataViewIterator& other) const
+    {
+        return mIndex >= other.mIndex;
+    }
+
+private:
+    const DataType* mPoints;       // the points of a container holding its data, indexed from its first one
+    const QCPDataColumn* mColumns; // the columns of a viewing container, null otherwise
+    int mIndex;
+};
+
 template <class DataType>
 class QCPDataContainer // no QCP_LIB_DECL, template class ends up in header (cpp included below)
 {
 public:
-    typedef typename QVector<DataType>::const_iterator const_iterator;
+    // data types that can be viewed are iterated by index, the others directly over the held points
+    typedef typename std::conditional<QCPDataColumnLayout<DataType>::columnCount != 0,
+        QCPDataViewIterator<DataType>,
+        typename QVector<DataType>::const_iterator>::type const_iterator;
     typedef typename QVector<DataType>::iterator iterator;
 
     QCPDataContainer();
@@ -3373,7 +3810,7 @@ public:
     // getters:
     int size() const
     {
-        return mData.size() - mPreallocSize;
+        return isView() ? mViewSize : mRing ? mRingSize : mData.size() - mPreallocSize;
     }
     bool isEmpty() const
     {
@@ -3383,13 +3820,23 @@ public:
     {
         return mAutoSqueeze;
     }
+    bool isView() const
+    {
+        return !mViewColumns.isEmpty();
+    }
+    int capacity() const
+    {
+        return mCapacity;
+    }
 
     // setters:
     void setAutoSqueeze(bool enabled);
+    void setCapacity(int capacity);
 
     // non-virtual methods:
     void set(const QCPDataContainer<DataType>& data);
     void set(const QVector<DataType>& data, bool alreadySorted = false);
+    void setView(const QVector<QCPDataColumn>& columns, int size, bool extendsPrevious = true);
     void add(const QCPDataContainer<DataType>& data);
     void add(const QVector<DataType>& data, bool alreadySorted = false);
     void add(const DataType& data);
@@ -3403,18 +3850,24 @@ public:
 
     const_iterator constBegin() const
     {
-        return mData.constBegin() + mPreallocSize;
+        return iteratorAt(0);
     }
     const_iterator constEnd() const
     {
-        return mData.constEnd();
+        return iteratorAt(size());
     }
     iterator begin()
     {
+        detach();
+        mRangeIndex.clear();
+        mKeyGrid.clear();
         return mData.begin() + mPreallocSize;
     }
     iterator end()
     {
+        detach();
+        mRangeIndex.clear();
+        mKeyGrid.clear();
         return mData.end();
     }
     const_iterator findBegin(double sortKey, bool expandedRange = true) const;
@@ -3440,10 +3893,28 @@ protected:
     QVector<DataType> mData;
     int mPreallocSize;
     int mPreallocIteration;
+    QVector<QCPDataColumn> mViewColumns; // the columns of a view, empty while the container holds its data
+    int mViewSize;
+    int mCapacity;  // the most points held, 0 for no bound
+    bool mRing;     // the points are laid out in the ring buffer of a bounded container
+    int mRingSize;
+    QCPRangeIndex mRangeIndex;
+    QCPKeyGrid mKeyGrid;
 
     // non-virtual methods:
     void preallocateGrow(int minimumPreallocSize);
     void performAutoSqueeze();
+    void detach();
+    const_iterator iteratorAt(int index) const;
+    int bound(double sortKey, bool upper) const;
+    double sortKeyAt(int index) const;
+    void updateKeyGrid();
+    void widenValueBounds(int begin, int end, double& lower, double& upper) const;
+    void ring();
+    void appendBounded(const DataType& data);
+    template <class Iterator>
+    static QCPRange scanValueRange(
+        Iterator itBegin, Iterator itEnd, bool& foundRange, QCP::SignDomain signDomain, const QCPRange& inKeyRange);
 };
 
 // include implementation in header since it is a class template:
@@ -3459,8 +3930,9 @@ protected:
   some methods as described in the \ref qcpdatacontainer-datatype "next section".
 
   The data is stored in a sorted fashion, which allows very quick lookups by the sorted key as well
-  as retrieval of ranges (see \ref findBegin, \ref findEnd, \ref keyRange) using binary search. The
-  container uses a preallocation and a postallocation scheme, such that appending and prepending
+  as retrieval of ranges (see \ref findBegin, \ref findEnd, \ref keyRange) using binary search.
+  Sort keys on a regular grid with few gaps, like the timestamps of bars of a fixed timeframe, are
+  located by arithmetic instead (see \ref QCPKeyGrid). The container uses a preallocation and a postallocation scheme, such that appending and prepending
   data (with respect to the sort key) is very fast and minimizes reallocations. If data is added
   which needs to be inserted between existing keys, the merge usually can be done quickly too,
   using the fact that existing data is always sorted. The user can further improve performance by
@@ -3480,6 +3952,16 @@ protected:
   sort. Failing to do so can not be detected by the container efficiently and will cause both
   rendering artifacts and potential data loss.
 
+  Instead of holding its data points, a container can be a view of external columns of values, one
+  per member of the data type (see \ref setView and \ref QCPDataColumnLayout). Its data points are
+  then assembled from the columns while they are iterated, so data kept in columns elsewhere
+  doesn't need to be copied into the container. Any method modifying a view first copies its data
+  points into the container, which then holds them as usual.
+
+  For live charts that show a fixed span of history, a container can be bounded to a number of data
+  points (see \ref setCapacity). Its memory then stays the same however many points are appended,
+  and appending a point behind the others evicts the oldest one in constant time.
+
   Implementing one-dimensional plottables that make use of a \ref QCPDataContainer<T> is usually
   done by subclassing from \ref QCPAbstractPlottable1D "QCPAbstractPlottable1D<T>", which
   introduces an according \a mDataContainer member and some convenience methods.
@@ -3530,6 +4012,13 @@ protected:
   Returns whether this container holds no data points.
 */
 
+/*! \fn int QCPDataContainer<DataType>::capacity() const
+
+  Returns the most data points this container holds, or 0 if it isn't bounded.
+
+  \see setCapacity
+*/
+
 /*! \fn QCPDataContainer::const_iterator QCPDataContainer<DataType>::constBegin() const
 
   Returns a const iterator to the first data point in this container.
@@ -3585,6 +4074,10 @@ QCPDataContainer<DataType>::QCPDataContainer()
     : mAutoSqueeze(true)
     , mPreallocSize(0)
     , mPreallocIteration(0)
+    , mViewSize(0)
+    , mCapacity(0)
+    , mRing(false)
+    , mRingSize(0)
 {
 }
 
@@ -3607,6 +4100,36 @@ void QCPDataContainer<DataType>::setAutoSqueeze(bool enabled)
     }
 }
 
+/*!
+  Bounds the container to hold at most \a capacity data points, for live charts that show a fixed
+  span of history. The oldest points beyond \a capacity are removed right away, and then each
+  point added behind the others removes the oldest one once the container is full. A \a capacity
+  of 0 removes the bound.
+
+  A bounded container keeps its points in a ring buffer of twice \a capacity points that is
+  allocated once, each point stored at its slot and again \a capacity points behind it. Appending
+  writes both copies, and evicting the oldest point just advances the start of the ring, so both
+  take constant time without reallocations or moving points. The points in order are always a
+  contiguous run of the buffer, so iterators and binary searches work as on an unbounded container.
+
+  \ref removeBefore just advances the start of the ring too. Adding points before the newest one,
+  the other removals and writing through the non-const iterators lay the points out in order first
+  and the next point added puts them back in the ring, which takes linear time. Views (\ref setView) aren't bounded
+  until they are modified.
+
+  \see capacity, add
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::setCapacity(int capacity)
+{
+    detach();
+    mCapacity = qMax(0, capacity);
+    if (mCapacity > 0)
+        ring();
+    else
+        mRangeIndex.setWindow(0);
+}
+
 /*! \overload
 
   Replaces the current data in this container with the provided \a data.
@@ -3632,11 +4155,55 @@ void QCPDataContainer<DataType>::set(const QCPDataContainer<DataType>& data)
 template <class DataType>
 void QCPDataContainer<DataType>::set(const QVector<DataType>& data, bool alreadySorted)
 {
+    mViewColumns.clear();
+    mViewSize = 0;
+    mRangeIndex.clear();
+    mKeyGrid.clear();
     mData = data;
     mPreallocSize = 0;
     mPreallocIteration = 0;
+    mRing = false;
+    mRingSize = 0;
     if (!alreadySorted)
         sort();
+    if (mCapacity > 0)
+        ring();
+    updateKeyGrid();
+}
+
+/*!
+  Makes this container a view of \a columns, whose first \a size values are its data points. The
+  columns are laid out as described by the \ref QCPDataColumnLayout of the data type, and the sort
+  keys in the first column must ascend. The data previously held is released.
+
+  The columns share ownership of their values, which must not change while they are viewed. Values
+  appended behind the first \a size are picked up by calling this method again with the larger \a
+  size. If \a extendsPrevious is true, the columns passed then are taken to begin with the values
+  viewed so far, which keeps the \ref valueRange index and the key grid of those. Pass false if any
+  of those values changed, e.g. because points were merged in between them, to drop both.
+
+  \see isView, set
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::setView(const QVector<QCPDataColumn>& columns, int size, bool extendsPrevious)
+{
+    Q_ASSERT(QCPDataColumnLayout<DataType>::columnCount != 0 &&
+             columns.size() == int(QCPDataColumnLayout<DataType>::columnCount));
+    const bool extends = extendsPrevious && isView() && size >= mViewSize;
+    if (mCapacity > 0)
+        mRangeIndex.setWindow(0); // the view may hold more points than the window of a bounded container
+    else if (!extends)
+        mRangeIndex.clear();
+    if (!extends)
+        mKeyGrid.clear();
+    mData.clear();
+    mPreallocSize = 0;
+    mPreallocIteration = 0;
+    mRing = false;
+    mRingSize = 0;
+    mViewColumns = columns;
+    mViewSize = size;
+    updateKeyGrid();
 }
 
 /*! \overload
@@ -3650,6 +4217,15 @@ void QCPDataContainer<DataType>::add(const QCPDataContainer<DataType>& data)
 {
     if (data.isEmpty())
         return;
+    if (mCapacity > 0 && !isView() && (isEmpty() || !qcpLessThanSortKey<DataType>(*data.constBegin(), *(constEnd() - 1))))
+    {
+        // only the newest points of a bounded container stay
+        for (const_iterator it = data.constEnd() - qMin(data.size(), mCapacity); it != data.constEnd(); ++it)
+            appendBounded(*it);
+        updateKeyGrid();
+        return;
+    }
+    detach();
 
     const int n = data.size();
     const int oldSize = size();
@@ -3666,13 +4242,16 @@ void QCPDataContainer<DataType>::add(const QCPDataContainer<DataType>& data)
     else // don't need to prepend, so append and merge if necessary
     {
         mData.resize(mData.size() + n);
-        std::copy(data.constBegin(), data.constEnd(), end() - n);
+        std::copy(data.constBegin(), data.constEnd(), mData.end() - n); // keeps the index of the points before
         if (oldSize > 0 &&
             !qcpLessThanSortKey<DataType>(*(constEnd() - n - 1),
                 *(constEnd() -
                     n))) // if appended range keys aren't all greater than existing ones, merge the two partitions
             std::inplace_merge(begin(), end() - n, end(), qcpLessThanSortKey<DataType>);
     }
+    if (mCapacity > 0)
+        ring();
+    updateKeyGrid();
 }
 
 /*!
@@ -3688,6 +4267,16 @@ void QCPDataContainer<DataType>::add(const QVector<DataType>& data, bool already
 {
     if (data.isEmpty())
         return;
+    if (mCapacity > 0 && !isView() && alreadySorted &&
+        (isEmpty() || !qcpLessThanSortKey<DataType>(data.first(), *(constEnd() - 1))))
+    {
+        // only the newest points of a bounded container stay
+        for (int i = qMax(0, int(data.size()) - mCapacity); i < data.size(); ++i)
+            appendBounded(data.at(i));
+        updateKeyGrid();
+        return;
+    }
+    detach();
     if (isEmpty())
     {
         set(data, alreadySorted);
@@ -3710,15 +4299,18 @@ void QCPDataContainer<DataType>::add(const QVector<DataType>& data, bool already
     else // don't need to prepend, so append and then sort and merge if necessary
     {
         mData.resize(mData.size() + n);
-        std::copy(data.constBegin(), data.constEnd(), end() - n);
+        std::copy(data.constBegin(), data.constEnd(), mData.end() - n); // keeps the index of the points before
         if (!alreadySorted) // sort appended subrange if it wasn't already sorted
-            std::sort(end() - n, end(), qcpLessThanSortKey<DataType>);
+            std::sort(mData.end() - n, mData.end(), qcpLessThanSortKey<DataType>);
         if (oldSize > 0 &&
             !qcpLessThanSortKey<DataType>(*(constEnd() - n - 1),
                 *(constEnd() -
                     n))) // if appended range keys aren't all greater than existing ones, merge the two partitions
             std::inplace_merge(begin(), end() - n, end(), qcpLessThanSortKey<DataType>);
     }
+    if (mCapacity > 0)
+        ring();
+    updateKeyGrid();
 }
 
 /*! \overload
@@ -3730,6 +4322,13 @@ void QCPDataContainer<DataType>::add(const QVector<DataType>& data, bool already
 template <class DataType>
 void QCPDataContainer<DataType>::add(const DataType& data)
 {
+    if (mCapacity > 0 && !isView() && (isEmpty() || !qcpLessThanSortKey<DataType>(data, *(constEnd() - 1))))
+    {
+        appendBounded(data);
+        updateKeyGrid();
+        return;
+    }
+    detach();
     if (isEmpty() ||
         !qcpLessThanSortKey<DataType>(
             data, *(constEnd() - 1))) // quickly handle appends if new data key is greater or equal to existing ones
@@ -3749,6 +4348,9 @@ void QCPDataContainer<DataType>::add(const DataType& data)
             std::lower_bound(begin(), end(), data, qcpLessThanSortKey<DataType>);
         mData.insert(insertionPoint, data);
     }
+    if (mCapacity > 0)
+        ring();
+    updateKeyGrid();
 }
 
 /*!
@@ -3759,11 +4361,21 @@ void QCPDataContainer<DataType>::add(const DataType& data)
 template <class DataType>
 void QCPDataContainer<DataType>::removeBefore(double sortKey)
 {
-    QCPDataContainer<DataType>::iterator it = begin();
-    QCPDataContainer<DataType>::iterator itEnd =
-        std::lower_bound(begin(), end(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
-    mPreallocSize += int(itEnd - it); // don't actually delete, just add it to the preallocated block (if it gets too
-                                      // large, squeeze will take care of it)
+    if (mRing) // the ring of a bounded container just starts later
+    {
+        const int count = bound(sortKey, false);
+        mPreallocSize = (mPreallocSize + count) % mCapacity;
+        mRingSize -= count;
+        mRangeIndex.evict(count);
+        mKeyGrid.evict(count);
+        return;
+    }
+    detach();
+    const int count = bound(sortKey, false);
+    mRangeIndex.clear();
+    mKeyGrid.evict(count);
+    mPreallocSize += count; // don't actually delete, just add it to the preallocated block (if it gets too
+                            // large, squeeze will take care of it)
     if (mAutoSqueeze)
         performAutoSqueeze();
 }
@@ -3776,10 +4388,11 @@ void QCPDataContainer<DataType>::removeBefore(double sortKey)
 template <class DataType>
 void QCPDataContainer<DataType>::removeAfter(double sortKey)
 {
-    QCPDataContainer<DataType>::iterator it =
-        std::upper_bound(begin(), end(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
-    QCPDataContainer<DataType>::iterator itEnd = end();
-    mData.erase(it, itEnd); // typically adds it to the postallocated block
+    detach();
+    const int keep = bound(sortKey, true);
+    mRangeIndex.truncate(keep); // the index of the points before stays
+    mKeyGrid.truncate(keep);
+    mData.erase(mData.begin() + mPreallocSize + keep, mData.end()); // typically adds it to the postallocated block
     if (mAutoSqueeze)
         performAutoSqueeze();
 }
@@ -3796,6 +4409,7 @@ void QCPDataContainer<DataType>::remove(double sortKeyFrom, double sortKeyTo)
 {
     if (sortKeyFrom >= sortKeyTo || isEmpty())
         return;
+    detach();
 
     QCPDataContainer<DataType>::iterator it =
         std::lower_bound(begin(), end(), DataType::fromSortKey(sortKeyFrom), qcpLessThanSortKey<DataType>);
@@ -3804,6 +4418,7 @@ void QCPDataContainer<DataType>::remove(double sortKeyFrom, double sortKeyTo)
     mData.erase(it, itEnd);
     if (mAutoSqueeze)
         performAutoSqueeze();
+    updateKeyGrid();
 }
 
 /*! \overload
@@ -3818,6 +4433,7 @@ void QCPDataContainer<DataType>::remove(double sortKeyFrom, double sortKeyTo)
 template <class DataType>
 void QCPDataContainer<DataType>::remove(double sortKey)
 {
+    detach();
     QCPDataContainer::iterator it =
         std::lower_bound(begin(), end(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
     if (it != end() && it->sortKey() == sortKey)
@@ -3830,6 +4446,7 @@ void QCPDataContainer<DataType>::remove(double sortKey)
     }
     if (mAutoSqueeze)
         performAutoSqueeze();
+    updateKeyGrid();
 }
 
 /*!
@@ -3840,9 +4457,15 @@ void QCPDataContainer<DataType>::remove(double sortKey)
 template <class DataType>
 void QCPDataContainer<DataType>::clear()
 {
+    mViewColumns.clear();
+    mViewSize = 0;
+    mRangeIndex.clear();
+    mKeyGrid.clear();
     mData.clear();
     mPreallocIteration = 0;
     mPreallocSize = 0;
+    mRing = false;
+    mRingSize = 0;
 }
 
 /*!
@@ -3860,6 +4483,7 @@ template <class DataType>
 void QCPDataContainer<DataType>::sort()
 {
     std::sort(begin(), end(), qcpLessThanSortKey<DataType>);
+    updateKeyGrid();
 }
 
 /*!
@@ -3875,11 +4499,12 @@ void QCPDataContainer<DataType>::sort()
 template <class DataType>
 void QCPDataContainer<DataType>::squeeze(bool preAllocation, bool postAllocation)
 {
+    detach();
     if (preAllocation)
     {
         if (mPreallocSize > 0)
         {
-            std::copy(begin(), end(), mData.begin());
+            std::copy(mData.begin() + mPreallocSize, mData.end(), mData.begin());
             mData.resize(size());
             mPreallocSize = 0;
         }
@@ -3911,8 +4536,7 @@ typename QCPDataContainer<DataType>::const_iterator QCPDataContainer<DataType>::
     if (isEmpty())
         return constEnd();
 
-    QCPDataContainer<DataType>::const_iterator it =
-        std::lower_bound(constBegin(), constEnd(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
+    QCPDataContainer<DataType>::const_iterator it = iteratorAt(bound(sortKey, false));
     if (expandedRange &&
         it !=
             constBegin()) // also covers it == constEnd case, and we know --constEnd is valid because mData isn't empty
@@ -3942,8 +4566,7 @@ typename QCPDataContainer<DataType>::const_iterator QCPDataContainer<DataType>::
     if (isEmpty())
         return constEnd();
 
-    QCPDataContainer<DataType>::const_iterator it =
-        std::upper_bound(constBegin(), constEnd(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
+    QCPDataContainer<DataType>::const_iterator it = iteratorAt(bound(sortKey, true));
     if (expandedRange && it != constEnd())
         ++it;
     return it;
@@ -4091,6 +4714,13 @@ QCPRange QCPDataContainer<DataType>::keyRange(bool& foundRange, QCP::SignDomain
   relevant e.g. for logarithmic plots which can mathematically only display one sign domain at a
   time.
 
+  With \ref QCP::sdBoth, runs of more than a few data points are looked up in an index of the
+  value ranges of blocks of data points (see \ref QCPRangeIndex), so the range of any key range is
+  found in logarithmic time, e.g. to fit the value axis to the visible data on every pan and zoom.
+  The index is built on the first call and follows data points appended behind the others or
+  removed from the end (\ref removeAfter), other modifications drop it. Of a view, the other sign
+  domains scan just the columns bounding the value ranges.
+
   \see keyRange
 */
 template <class DataType>
@@ -4102,21 +4732,109 @@ QCPRange QCPDataContainer<DataType>::valueRange(
         foundRange = false;
         return QCPRange();
     }
+    const bool restrictKeyRange = inKeyRange != QCPRange();
+    int begin = 0;
+    int end = size();
+    if (DataType::sortKeyIsMainKey() && restrictKeyRange)
+    {
+        begin = bound(inKeyRange.lower, false);
+        end = bound(inKeyRange.upper, true);
+    }
+    if (signDomain == QCP::sdBoth && (DataType::sortKeyIsMainKey() || !restrictKeyRange))
+    {
+        QCPRange range;
+        range.lower = std::numeric_limits<double>::infinity();
+        range.upper = -std::numeric_limits<double>::infinity();
+        if (end - begin >= 2 * QCPRangeIndex::blockSize) // whole blocks from the index, the points beside them directly
+        {
+            auto scan = [this](int scanBegin, int scanEnd, double& lower, double& upper)
+            { widenValueBounds(scanBegin, scanEnd, lower, upper); };
+            mRangeIndex.update(size(), scan);
+            mRangeIndex.range(begin, end, range.lower, range.upper, scan);
+        }
+        else
+            widenValueBounds(begin, end, range.lower, range.upper);
+        foundRange = range.lower < std::numeric_limits<double>::infinity() &&
+                     range.upper > -std::numeric_limits<double>::infinity();
+        return range;
+    }
+    if constexpr (QCPDataColumnLayout<DataType>::columnCount != 0)
+    {
+        if (isView()) // the keys of a view are its main keys, begin and end already restrict them
+        {
+            const int lowerColumn = QCPDataColumnLayout<DataType>::lowerColumn;
+            const int upperColumn = QCPDataColumnLayout<DataType>::upperColumn;
+            QCPRange range;
+            double maximum;
+            mViewColumns.at(lowerColumn).extent(begin, end, signDomain, range.lower, maximum);
+            if (upperColumn != lowerColumn)
+                mViewColumns.at(upperColumn).extent(begin, end, signDomain, maximum, range.upper);
+            else
+                range.upper = maximum;
+            foundRange = range.lower < std::numeric_limits<double>::infinity() &&
+                         range.upper > -std::numeric_limits<double>::infinity();
+            return range;
+        }
+    }
+    // held data points are scanned directly rather than through the const iterators
+    const DataType* points = mData.constData() + mPreallocSize;
+    return scanValueRange(points + begin, points + end, foundRange, signDomain, inKeyRange);
+}
+
+/*! \internal
+
+  Widens \a lower and \a upper to the finite bounds of the value ranges of the data points at the
+  indices [\a begin, \a end). Of a view only the columns bounding the value ranges are scanned.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::widenValueBounds(int begin, int end, double& lower, double& upper) const
+{
+    if (begin >= end)
+        return;
+    if constexpr (QCPDataColumnLayout<DataType>::columnCount != 0)
+    {
+        if (isView())
+        {
+            const int lowerColumn = QCPDataColumnLayout<DataType>::lowerColumn;
+            const int upperColumn = QCPDataColumnLayout<DataType>::upperColumn;
+            double minimum, maximum;
+            mViewColumns.at(lowerColumn).extent(begin, end, minimum, maximum);
+            lower = qMin(lower, minimum);
+            if (upperColumn != lowerColumn)
+                mViewColumns.at(upperColumn).extent(begin, end, minimum, maximum);
+            upper = qMax(upper, maximum);
+            return;
+        }
+    }
+    const DataType* points = mData.constData() + mPreallocSize;
+    for (int i = begin; i < end; ++i)
+    {
+        const QCPRange current = points[i].valueRange();
+        if (std::isfinite(current.lower)) // also skips NaN
+            lower = qMin(lower, current.lower);
+        if (std::isfinite(current.upper))
+            upper = qMax(upper, current.upper);
+    }
+}
+
+/*! \internal
+
+  Returns the range encompassed by the value coordinates of the data points [\a itBegin, \a itEnd)
+  for \ref valueRange(bool &foundRange, QCP::SignDomain signDomain, const QCPRange &inKeyRange).
+*/
+template <class DataType>
+template <class Iterator>
+QCPRange QCPDataContainer<DataType>::scanValueRange(
+    Iterator itBegin, Iterator itEnd, bool& foundRange, QCP::SignDomain signDomain, const QCPRange& inKeyRange)
+{
     QCPRange range;
     const bool restrictKeyRange = inKeyRange != QCPRange();
     bool haveLower = false;
     bool haveUpper = false;
     QCPRange current;
-    QCPDataContainer<DataType>::const_iterator itBegin = constBegin();
-    QCPDataContainer<DataType>::const_iterator itEnd = constEnd();
-    if (DataType::sortKeyIsMainKey() && restrictKeyRange)
-    {
-        itBegin = findBegin(inKeyRange.lower, false);
-        itEnd = findEnd(inKeyRange.upper, false);
-    }
     if (signDomain == QCP::sdBoth) // range may be anywhere
     {
-        for (QCPDataContainer<DataType>::const_iterator it = itBegin; it != itEnd; ++it)
+        for (Iterator it = itBegin; it != itEnd; ++it)
         {
             if (restrictKeyRange && (it->mainKey() < inKeyRange.lower || it->mainKey() > inKeyRange.upper))
                 continue;
@@ -4135,7 +4853,7 @@ QCPRange QCPDataContainer<DataType>::valueRange(
     }
     else if (signDomain == QCP::sdNegative) // range may only be in the negative sign domain
     {
-        for (QCPDataContainer<DataType>::const_iterator it = itBegin; it != itEnd; ++it)
+        for (Iterator it = itBegin; it != itEnd; ++it)
         {
             if (restrictKeyRange && (it->mainKey() < inKeyRange.lower || it->mainKey() > inKeyRange.upper))
                 continue;
@@ -4156,7 +4874,7 @@ QCPRange QCPDataContainer<DataType>::valueRange(
     }
     else if (signDomain == QCP::sdPositive) // range may only be in the positive sign domain
     {
-        for (QCPDataContainer<DataType>::const_iterator it = itBegin; it != itEnd; ++it)
+        for (Iterator it = itBegin; it != itEnd; ++it)
         {
             if (restrictKeyRange && (it->mainKey() < inKeyRange.lower || it->mainKey() > inKeyRange.upper))
                 continue;
@@ -4241,6 +4959,8 @@ void QCPDataContainer<DataType>::preallocateGrow(int minimumPreallocSize)
 template <class DataType>
 void QCPDataContainer<DataType>::performAutoSqueeze()
 {
+    if (isView() || mRing)
+        return;
     const int totalAlloc = mData.capacity();
     const int postAllocSize = totalAlloc - mData.size();
     const int usedSize = size();
@@ -4264,6 +4984,168 @@ void QCPDataContainer<DataType>::performAutoSqueeze()
         squeeze(shrinkPreAllocation, shrinkPostAllocation);
 }
 
+/*! \internal
+
+  Copies the data points of a view into this container, which then holds them, and lays out the
+  points of the ring buffer of a bounded container in order. Called by the methods modifying the
+  data, does nothing if the container holds its points in order already.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::detach()
+{
+    if (!isView() && !mRing)
+        return;
+    QVector<DataType> data;
+    data.reserve(size());
+    for (const_iterator it = constBegin(); it != constEnd(); ++it)
+        data.append(*it);
+    mViewColumns.clear();
+    mViewSize = 0;
+    mRing = false;
+    mRingSize = 0;
+    mRangeIndex.clear();
+    mData = data;
+    mPreallocSize = 0;
+    mPreallocIteration = 0;
+}
+
+/*! \internal
+
+  Lays out the newest \ref capacity points of this container, which holds its points in order, in
+  the ring buffer of a bounded container (see \ref setCapacity).
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::ring()
+{
+    const int count = qMin(size(), mCapacity);
+    mKeyGrid.evict(size() - count); // the runs of the points kept stay
+    const DataType* points = mData.constData() + mData.size() - count;
+    QVector<DataType> buffer(2 * mCapacity);
+    std::copy(points, points + count, buffer.begin());
+    std::copy(points, points + count, buffer.begin() + mCapacity);
+    mData.swap(buffer);
+    mPreallocSize = 0; // the ring starts at the first slot
+    mPreallocIteration = 0;
+    mRingSize = count;
+    mRing = true;
+    mRangeIndex.setWindow(mCapacity);
+}
+
+/*! \internal
+
+  Appends \a data, whose sort key isn't less than the ones of the other points, to a bounded
+  container, evicting the oldest point if it is full. The ring starts at slot \a mPreallocSize,
+  and both copies of the slot behind the newest point are written, so the points stay a contiguous
+  run of the buffer across the end of the ring.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::appendBounded(const DataType& data)
+{
+    if (!mRing)
+    {
+        detach();
+        ring();
+    }
+    const int slot = (mPreallocSize + mRingSize) % mCapacity;
+    mData[slot] = data;
+    mData[slot + mCapacity] = data;
+    if (mRingSize < mCapacity)
+        ++mRingSize;
+    else // the slot held the oldest point
+    {
+        mPreallocSize = (mPreallocSize + 1) % mCapacity;
+        mRangeIndex.evict(1);
+        mKeyGrid.evict(1);
+    }
+}
+
+/*! \internal
+
+  Returns a const iterator to the data point at \a index, which may be \ref size for the end.
+*/
+template <class DataType>
+typename QCPDataContainer<DataType>::const_iterator QCPDataContainer<DataType>::iteratorAt(int index) const
+{
+    if constexpr (QCPDataColumnLayout<DataType>::columnCount != 0)
+        return const_iterator(mData.constData() + mPreallocSize, isView() ? mViewColumns.constData() : nullptr, index);
+    else
+        return mData.constBegin() + mPreallocSize + index;
+}
+
+/*! \internal
+
+  Returns the index of the first data point whose sort key isn't less than \a sortKey, or if \a
+  upper is true, the first whose sort key is greater. Keys on a regular grid are located by the key
+  grid, see \ref QCPKeyGrid. Otherwise held data points are searched directly, of a view only the
+  sort key column is read.
+*/
+template <class DataType>
+int QCPDataContainer<DataType>::bound(double sortKey, bool upper) const
+{
+    if (mKeyGrid.size() == size() && !qIsNaN(sortKey))
+    {
+        int index = mKeyGrid.locate(sortKey);
+        if (index >= 0)
+        {
+            // the keys beside the located point settle rounding and points with equal keys
+            const int count = size();
+            while (index > 0 && (upper ? sortKey < sortKeyAt(index - 1) : !(sortKeyAt(index - 1) < sortKey)))
+                --index;
+            while (index < count && (upper ? !(sortKey < sortKeyAt(index)) : sortKeyAt(index) < sortKey))
+                ++index;
+            return index;
+        }
+    }
+    if (!isView())
+    {
+        const DataType* begin = mData.constData() + mPreallocSize;
+        const DataType* end = begin + size();
+        const DataType point = DataType::fromSortKey(sortKey);
+        return int((upper ? std::upper_bound(begin, end, point, qcpLessThanSortKey<DataType>)
+                          : std::lower_bound(begin, end, point, qcpLessThanSortKey<DataType>)) - begin);
+    }
+    const QCPDataColumn& keys = mViewColumns.first();
+    int lower = 0;
+    int count = mViewSize;
+    while (count > 0)
+    {
+        const int step = count / 2;
+        const double key = keys.value(lower + step);
+        if (upper ? !(sortKey < key) : key < sortKey)
+        {
+            lower += step + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+    return lower;
+}
+
+/*! \internal
+
+  Returns the sort key of the data point at \a index, read from the key column of a view.
+*/
+template <class DataType>
+double QCPDataContainer<DataType>::sortKeyAt(int index) const
+{
+    if (isView())
+        return mViewColumns.first().value(index);
+    return mData.constData()[mPreallocSize + index].sortKey();
+}
+
+/*! \internal
+
+  Adds the data points appended since the last call to the key grid that \ref findBegin and \ref
+  findEnd locate sort keys with. Called by the methods modifying the data, after they shifted or
+  cleared the grid as needed.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::updateKeyGrid()
+{
+    mKeyGrid.update(size(), [this](int index) { return sortKeyAt(index); });
+}
+
 /* end of 'src/datacontainer.h' */
 
 /* including file 'src/plottable.h'        */
@@ -4722,6 +5604,207 @@ private:
 
 /* end of 'src/item.h' */
 
+/* including file 'src/framearena.h'        */
+
+/*!
+  Hands out the scratch buffers plottables build while drawing, like the pixel points of a graph's
+  line or the lists of selected and unselected data segments, and takes them all back once the
+  frame is drawn (\ref reset). A buffer is taken again in a later frame with the capacity it grew
+  to, so once the plot was drawn a couple of times, drawing it again needs no heap allocations for
+  them. The parent plot owns the arena (\ref QCustomPlot::frameArena) and resets it after each
+  replot. Code taking buffers outside a replot, like a selection test, opens a \ref Scope, which
+  takes them back when it ends, so the tests run between two replots reuse the same buffers.
+
+  Buffers are Qt containers with the \c clear and \c capacity of QVector, pooled per container
+  type. The arena counts the heap allocations of its buffers, the buffers it had to add and the
+  ones that outgrew their capacity, see \ref allocations and \ref frameAllocations.
+*/
+class QCP_LIB_DECL QCPFrameArena
+{
+public:
+    class Scope;
+
+    QCPFrameArena();
+    ~QCPFrameArena();
+
+    // getters:
+    qint64 allocations() const { return mAllocations; }
+    int frameAllocations() const { return mFrameAllocations; }
+
+    // non-virtual methods:
+    template <class Container>
+    Container& take();
+    void reset();
+
+protected:
+    class AbstractPool
+    {
+    public:
+        virtual ~AbstractPool() {}
+        virtual int reset() = 0;
+        virtual void markScope() = 0;
+        virtual int rewindScope() = 0;
+    };
+    template <class Container>
+    class Pool : public AbstractPool
+    {
+    public:
+        Pool() : mTaken(0), mScopeTaken(0) {}
+        ~Pool() { qDeleteAll(mBuffers); }
+        Container& take(int& allocations);
+        virtual int reset() Q_DECL_OVERRIDE;
+        virtual void markScope() Q_DECL_OVERRIDE { mScopeTaken = mTaken; }
+        virtual int rewindScope() Q_DECL_OVERRIDE;
+
+    protected:
+        struct Mark
+        {
+            const void* data;
+            qsizetype capacity;
+        };
+        QVector<Container*> mBuffers; // pointers, so buffers stay in place while the pool grows
+        QVector<Mark> mMarks;         // where each buffer's data was when last seen
+        int mTaken;                   // the buffers taken since the last reset, the first of mBuffers
+        int mScopeTaken;              // mTaken when the open scope began
+        bool moved(int index);
+    };
+
+    // property members:
+    QVector<AbstractPool*> mPools; // indexed by poolIndex
+    qint64 mAllocations;
+    int mFrameAllocations;
+    int mTakeAllocations; // allocations counted by take in the frame that isn't reset yet
+    bool mScoped;         // a scope is open
+
+    // non-virtual methods:
+    static int nextPoolIndex();
+    template <class Container>
+    static int poolIndex();
+
+private:
+    Q_DISABLE_COPY(QCPFrameArena)
+};
+
+/*!
+  Takes back the buffers taken from an arena while it exists, see \ref QCPFrameArena. Scopes
+  opened within another one leave that to the outer one.
+*/
+class QCP_LIB_DECL QCPFrameArena::Scope
+{
+public:
+    explicit Scope(QCPFrameArena* arena);
+    ~Scope();
+
+private:
+    QCPFrameArena* mArena; // null if an outer scope takes the buffers back
+
+    Q_DISABLE_COPY(Scope)
+};
+
+/*!
+  Returns an empty buffer of type \a Container which stays the caller's until the next \ref
+  reset. It keeps the capacity of an earlier frame, so filling it again to about the size it had
+  then doesn't allocate.
+*/
+template <class Container>
+Container& QCPFrameArena::take()
+{
+    const int index = poolIndex<Container>();
+    if (index >= mPools.size())
+    {
+        mPools.resize(index + 1);
+        ++mTakeAllocations;
+    }
+    if (!mPools.at(index))
+    {
+        mPools[index] = new Pool<Container>;
+        ++mTakeAllocations;
+    }
+    return static_cast<Pool<Container>*>(mPools.at(index))->take(mTakeAllocations);
+}
+
+/*! \internal
+
+  Returns the index of the pool of \a Container in mPools, the same for every arena.
+*/
+template <class Container>
+int QCPFrameArena::poolIndex()
+{
+    static const int index = nextPoolIndex();
+    return index;
+}
+
+/*! \internal
+
+  Returns the next buffer of the pool, cleared, and adds the allocations this took to \a
+  allocations: one when a buffer is added, and one when clearing a buffer something else still
+  shared gave it new data.
+*/
+template <class Container>
+Container& QCPFrameArena::Pool<Container>::take(int& allocations)
+{
+    if (mTaken == mBuffers.size())
+    {
+        mBuffers.append(new Container);
+        mMarks.append(Mark{nullptr, 0});
+        ++allocations;
+    }
+    Container& buffer = *mBuffers.at(mTaken);
+    buffer.clear();
+    allocations += moved(mTaken);
+    ++mTaken;
+    return buffer;
+}
+
+/*! \internal
+
+  Takes back the buffers taken since the last reset and returns the number of them that grew
+  since they were taken.
+*/
+template <class Container>
+int QCPFrameArena::Pool<Container>::reset()
+{
+    int allocations = 0;
+    for (int i = 0; i < mTaken; ++i)
+        allocations += moved(i);
+    mTaken = 0;
+    return allocations;
+}
+
+/*! \internal
+
+  Takes back the buffers taken since \ref markScope and returns the number of them that grew since
+  they were taken.
+*/
+template <class Container>
+int QCPFrameArena::Pool<Container>::rewindScope()
+{
+    int allocations = 0;
+    for (int i = mScopeTaken; i < mTaken; ++i)
+        allocations += moved(i);
+    mTaken = mScopeTaken;
+    return allocations;
+}
+
+/*! \internal
+
+  Returns whether the buffer at \a index got new data since it was last seen, and remembers where
+  its data is now.
+*/
+template <class Container>
+bool QCPFrameArena::Pool<Container>::moved(int index)
+{
+    const Container& buffer = *mBuffers.at(index);
+    Mark& mark = mMarks[index];
+    const bool result =
+        buffer.capacity() != mark.capacity || (buffer.capacity() > 0 && buffer.constData() != mark.data);
+    mark.data = buffer.constData();
+    mark.capacity = buffer.capacity();
+    return result;
+}
+
+/* end of 'src/framearena.h' */
+
 /* including file 'src/core.h'              */
 /* modified 2022-11-06T12:45:56, size 19304 */
 
@@ -4970,6 +6053,7 @@ public:
     void toPainter(QCPPainter* painter, int width = 0, int height = 0);
     Q_SLOT void replot(QCustomPlot::RefreshPriority refreshPriority = QCustomPlot::rpRefreshHint);
     double replotTime(bool average = false) const;
+    QCPFrameArena* frameArena() { return &mFrameArena; }
 
     QCPAxis *xAxis, *yAxis, *xAxis2, *yAxis2;
     QCPLegend* legend;
@@ -5032,6 +6116,7 @@ protected:
     bool mReplotting;
     bool mReplotQueued;
     double mReplotTime, mReplotTimeAverage;
+    QCPFrameArena mFrameArena;
     int mOpenGlMultisamples;
     QCP::AntialiasedElements mOpenGlAntialiasedElementsBackup;
     bool mOpenGlCacheLabelsBackup;
@@ -5722,6 +6807,8 @@ void QCPAbstractPlottable1D<DataType>::getDataSegments(
         else
             unselectedSegments << QCPDataRange(0, dataCount());
     }
+    else if (mSelection.isEmpty()) // the usual case, which doesn't need a copy of the selection
+        unselectedSegments << QCPDataRange(0, dataCount());
     else
     {
         QCPDataSelection sel(selection());
@@ -6806,6 +7893,24 @@ public:
 };
 Q_DECLARE_TYPEINFO(QCPGraphData, Q_PRIMITIVE_TYPE);
 
+/*! \relates QCPGraphData
+  Views of \ref QCPGraphData points read a key and a value column.
+*/
+template <>
+struct QCPDataColumnLayout<QCPGraphData>
+{
+    enum
+    {
+        columnCount = 2,
+        lowerColumn = 1,
+        upperColumn = 1
+    };
+    static inline QCPGraphData point(const QCPDataColumn* columns, int index)
+    {
+        return QCPGraphData(columns[0].value(index), columns[1].value(index));
+    }
+};
+
 /*! \typedef QCPGraphDataContainer
 
   Container for storing \ref QCPGraphData points. The data is stored sorted by \a key.
@@ -6933,11 +8038,11 @@ protected:
         const QCPDataRange& rangeRestriction) const;
     void getLines(QVector<QPointF>* lines, const QCPDataRange& dataRange) const;
     void getScatters(QVector<QPointF>* scatters, const QCPDataRange& dataRange) const;
-    QVector<QPointF> dataToLines(const QVector<QCPGraphData>& data) const;
-    QVector<QPointF> dataToStepLeftLines(const QVector<QCPGraphData>& data) const;
-    QVector<QPointF> dataToStepRightLines(const QVector<QCPGraphData>& data) const;
-    QVector<QPointF> dataToStepCenterLines(const QVector<QCPGraphData>& data) const;
-    QVector<QPointF> dataToImpulseLines(const QVector<QCPGraphData>& data) const;
+    void dataToLines(const QVector<QCPGraphData>& data, QVector<QPointF>* lines) const;
+    void dataToStepLeftLines(const QVector<QCPGraphData>& data, QVector<QPointF>* lines) const;
+    void dataToStepRightLines(const QVector<QCPGraphData>& data, QVector<QPointF>* lines) const;
+    void dataToStepCenterLines(const QVector<QCPGraphData>& data, QVector<QPointF>* lines) const;
+    void dataToImpulseLines(const QVector<QCPGraphData>& data, QVector<QPointF>* lines) const;
     QVector<QCPDataRange> getNonNanSegments(const QVector<QPointF>* lineData, Qt::Orientation keyOrientation) const;
     QVector<QPair<QCPDataRange, QCPDataRange> > getOverlappingSegments(QVector<QCPDataRange> thisSegments,
         const QVector<QPointF>* thisData,
@@ -7279,6 +8384,24 @@ public:
 };
 Q_DECLARE_TYPEINFO(QCPBarsData, Q_PRIMITIVE_TYPE);
 
+/*! \relates QCPBarsData
+  Views of \ref QCPBarsData points read a key and a value column.
+*/
+template <>
+struct QCPDataColumnLayout<QCPBarsData>
+{
+    enum
+    {
+        columnCount = 2,
+        lowerColumn = 1,
+        upperColumn = 1
+    };
+    static inline QCPBarsData point(const QCPDataColumn* columns, int index)
+    {
+        return QCPBarsData(columns[0].value(index), columns[1].value(index));
+    }
+};
+
 /*! \typedef QCPBarsDataContainer
 
   Container for storing \ref QCPBarsData points. The data is stored sorted by \a key.
@@ -7811,6 +8934,26 @@ public:
 };
 Q_DECLARE_TYPEINFO(QCPFinancialData, Q_PRIMITIVE_TYPE);
 
+/*! \relates QCPFinancialData
+  Views of \ref QCPFinancialData points read a key, open, high, low and close column, in this
+  order.
+*/
+template <>
+struct QCPDataColumnLayout<QCPFinancialData>
+{
+    enum
+    {
+        columnCount = 5,
+        lowerColumn = 3,
+        upperColumn = 2
+    };
+    static inline QCPFinancialData point(const QCPDataColumn* columns, int index)
+    {
+        return QCPFinancialData(columns[0].value(index), columns[1].value(index), columns[2].value(index),
+            columns[3].value(index), columns[4].value(index));
+    }
+};
+
 /*! \typedef QCPFinancialDataContainer
 
   Container for storing \ref QCPFinancialData points. The data is stored sorted by \a key.
@@ -7822,6 +8965,41 @@ Q_DECLARE_TYPEINFO(QCPFinancialData, Q_PRIMITIVE_TYPE);
 */
 typedef QCPDataContainer<QCPFinancialData> QCPFinancialDataContainer;
 
+class QCP_LIB_DECL QCPCompactFinancialData
+{
+public:
+    QCPCompactFinancialData();
+    QCPCompactFinancialData(const QCPCompactFinancialData& other);
+    QCPCompactFinancialData& operator=(const QCPCompactFinancialData& other);
+
+    int size() const
+    {
+        return mSize;
+    }
+    bool isEmpty() const
+    {
+        return mSize == 0;
+    }
+    qint64 byteSize() const;
+
+    void set(const QVector<QCPFinancialData>& data, bool alreadySorted = false);
+    void add(const QVector<QCPFinancialData>& data, bool alreadySorted = false);
+    void clear();
+    QCPFinancialData at(int index) const;
+    QVector<QCPDataColumn> columns() const;
+    void view(QCPFinancialDataContainer& container);
+
+protected:
+    std::shared_ptr<double> mKeys;
+    std::shared_ptr<float> mPrices; // open, high, low and close, a block of mCapacity values each
+    int mSize;
+    int mCapacity;     // the points the columns have room for
+    bool mAppendable;  // the room behind the points is this object's to append to, copies move on
+    bool mRewritten;   // points were replaced or merged in since the columns were last viewed
+
+    void reserve(int size);
+};
+
 class QCP_LIB_DECL QCPFinancial : public QCPAbstractPlottable1D<QCPFinancialData>
 {
     Q_OBJECT
@@ -0,0 +1,612 @@
+#include "seriesfile.h"
+
+#include <QSaveFile>
+#include <QtAlgorithms>
+
+#include <cstring>
+#include <thread>
+
+namespace
+{
+const char Magic[8] = {'Q', 'T', 'S', 'E', 'R', 'I', 'E', 'S'};
+const quint32 ByteOrderMark = 0x01020304;
+
+// file layout: Header, column names joined by ',', one quint32 CsvColumn::Type per column,
+// one BlockEntry per block, then the blocks. A block holds a ColumnChunk per column, each
+// followed by the validity words of the block rows if the column has empty cells in the
+// block, then by the bit stream of the values
+struct Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint64 rowCount;
+    quint32 columnCount;
+    quint32 keyColumn;
+    quint32 blockRows;
+    quint32 blockCount;
+    quint32 namesLength;
+    quint32 reserved;
+};
+static_assert(sizeof(Header) == 48, "series header layout changed");
+
+struct BlockEntry
+{
+    quint64 offset;
+    quint32 size;
+    quint32 rowCount;
+    double minKey; // of the valid keys in the block, +inf if it has none
+    double maxKey;
+};
+static_assert(sizeof(BlockEntry) == 32, "series block entry layout changed");
+
+struct ColumnChunk
+{
+    quint32 validityBytes;
+    quint32 streamBytes;
+};
+static_assert(sizeof(ColumnChunk) == 8, "series column chunk layout changed");
+
+// delta-of-delta widths after a '1' bit, picked by the count of further '1' bits before a '0'.
+// Changes that fit none of them take 64 bits
+const int DeltaBits[] = {7, 9, 12, 32};
+const int DeltaBuckets = 4;
+
+std::runtime_error damaged(const QString& path)
+{
+    return std::runtime_error(QString("%1 is not a valid series file").arg(path).toStdString());
+}
+
+// big endian bit stream appended to a byte array
+class BitWriter
+{
+public:
+    explicit BitWriter(QByteArray& out)
+        : out(out)
+    {
+    }
+
+    // writes the low count bits of value, 1 <= count <= 64
+    void write(quint64 value, int count)
+    {
+        if (count < 64)
+            value &= (quint64(1) << count) - 1;
+        if (count < free)
+        {
+            free -= count;
+            word |= value << free;
+            return;
+        }
+        const int rest = count - free;
+        word |= rest == 0 ? value : value >> rest;
+        flush(8);
+        word = rest == 0 ? 0 : value << (64 - rest);
+        free = 64 - rest;
+    }
+
+    // pads the last byte with zero bits
+    void finish()
+    {
+        if (free < 64)
+            flush((64 - free + 7) / 8);
+        word = 0;
+        free = 64;
+    }
+
+private:
+    void flush(int bytes)
+    {
+        char buffer[8];
+        for (int i = 0; i < bytes; ++i)
+            buffer[i] = char(word >> (56 - 8 * i));
+        out.append(buffer, bytes);
+    }
+
+    QByteArray& out;
+    quint64 word = 0;
+    int free = 64;
+};
+
+// reads a BitWriter stream, reading past its end gives zero bits
+class BitReader
+{
+public:
+    BitReader(const uchar* data, qsizetype size)
+        : data(data)
+        , end(data + size)
+    {
+    }
+
+    // 1 <= count <= 64
+    quint64 read(int count)
+    {
+        if (count > 56)
+        {
+            const quint64 high = read(count - 32);
+            return (high << 32) | read(32);
+        }
+        while (available <= 56)
+        {
+            buffer |= quint64(data < end ? *data++ : 0) << (56 - available);
+            available += 8;
+        }
+        const quint64 value = buffer >> (64 - count);
+        buffer <<= count;
+        available -= count;
+        return value;
+    }
+
+private:
+    const uchar* data;
+    const uchar* end;
+    quint64 buffer = 0;
+    int available = 0;
+};
+
+inline bool fitsSigned(qint64 value, int bits)
+{
+    return value >= -(qint64(1) << (bits - 1)) && value < (qint64(1) << (bits - 1));
+}
+
+inline qint64 signExtend(quint64 value, int bits)
+{
+    return qint64(value << (64 - bits)) >> (64 - bits);
+}
+
+// the first value raw, then for every other one the change of the difference to its predecessor:
+// a '0' bit if the difference repeats, else the change in the smallest width of DeltaBits
+void encodeIntegers(const quint64* values, qsizetype count, BitWriter& bits)
+{
+    if (count == 0)
+        return;
+    bits.write(values[0], 64);
+    quint64 previousDelta = 0;
+    for (qsizetype i = 1; i < count; ++i)
+    {
+        const quint64 delta = values[i] - values[i - 1];
+        const qint64 change = qint64(delta - previousDelta);
+        previousDelta = delta;
+        if (change == 0)
+        {
+            bits.write(0, 1);
+            continue;
+        }
+        int bucket = 0;
+        while (bucket < DeltaBuckets && !fitsSigned(change, DeltaBits[bucket]))
+            ++bucket;
+        if (bucket < DeltaBuckets)
+        {
+            bits.write((quint64(1) << (bucket + 2)) - 2, bucket + 2); // bucket + 1 '1' bits and a '0'
+            bits.write(quint64(change), DeltaBits[bucket]);
+        }
+        else
+        {
+            bits.write(0x1f, 5);
+            bits.write(quint64(change), 64);
+        }
+    }
+}
+
+void decodeIntegers(BitReader& bits, quint64* values, qsizetype count)
+{
+    if (count == 0)
+        return;
+    values[0] = bits.read(64);
+    quint64 delta = 0;
+    for (qsizetype i = 1; i < count; ++i)
+    {
+        if (bits.read(1))
+        {
+            int bucket = 0;
+            while (bucket < DeltaBuckets && bits.read(1))
+                ++bucket;
+            delta += bucket < DeltaBuckets ? quint64(signExtend(bits.read(DeltaBits[bucket]), DeltaBits[bucket]))
+                                           : bits.read(64);
+        }
+        values[i] = values[i - 1] + delta;
+    }
+}
+
+// Gorilla XOR compression: the first value raw, then the XOR with its predecessor as a '0' bit if it
+// is zero, else its meaningful bits inside the window of the previous XOR ('10') or a new window ('11')
+void encodeFloats(const double* values, qsizetype count, BitWriter& bits)
+{
+    quint64 previous = 0;
+    int leading = -1;
+    int trailing = 0;
+    for (qsizetype i = 0; i < count; ++i)
+    {
+        quint64 value;
+        std::memcpy(&value, values + i, sizeof(value));
+        const quint64 diff = value ^ previous;
+        previous = value;
+        if (i == 0)
+        {
+            bits.write(value, 64);
+        }
+        else if (diff == 0)
+        {
+            bits.write(0, 1);
+        }
+        else
+        {
+            const int diffLeading = qMin(int(qCountLeadingZeroBits(diff)), 31);
+            const int diffTrailing = int(qCountTrailingZeroBits(diff));
+            if (leading >= 0 && diffLeading >= leading && diffTrailing >= trailing)
+            {
+                bits.write(0b10, 2);
+                bits.write(diff >> trailing, 64 - leading - trailing);
+            }
+            else
+            {
+                leading = diffLeading;
+                trailing = diffTrailing;
+                const int significant = 64 - leading - trailing;
+                bits.write(0b11, 2);
+                bits.write(quint64(leading), 5);
+                bits.write(quint64(significant - 1), 6);
+                bits.write(diff >> trailing, significant);
+            }
+        }
+    }
+}
+
+// returns false if the stream is damaged
+bool decodeFloats(BitReader& bits, double* values, qsizetype count)
+{
+    quint64 value = 0;
+    int leading = 0;
+    int trailing = 0;
+    bool windowSet = false;
+    for (qsizetype i = 0; i < count; ++i)
+    {
+        if (i == 0)
+        {
+            value = bits.read(64);
+        }
+        else if (bits.read(1))
+        {
+            if (bits.read(1))
+            {
+                leading = int(bits.read(5));
+                const int significant = int(bits.read(6)) + 1;
+                if (leading + significant > 64)
+                    return false;
+                trailing = 64 - leading - significant;
+                windowSet = true;
+            }
+            else if (!windowSet)
+            {
+                return false;
+            }
+            value ^= bits.read(64 - leading - trailing) << trailing;
+        }
+        std::memcpy(values + i, &value, sizeof(value));
+    }
+    return true;
+}
+
+// the bit stream of rows [begin, end) of column
+QByteArray encodeValues(const CsvColumn& column, qsizetype begin, qsizetype end)
+{
+    QByteArray stream;
+    BitWriter bits(stream);
+    switch (column.type())
+    {
+    case CsvColumn::Int64:
+        encodeIntegers(reinterpret_cast<const quint64*>(column.constValues<qint64>()) + begin, end - begin, bits);
+        break;
+    case CsvColumn::UInt64:
+        encodeIntegers(column.constValues<quint64>() + begin, end - begin, bits);
+        break;
+    case CsvColumn::Float32:
+    {
+        QVector<double> widened(end - begin);
+        for (qsizetype row = begin; row < end; ++row)
+            widened[row - begin] = column.value(row);
+        encodeFloats(widened.constData(), widened.size(), bits);
+        break;
+    }
+    case CsvColumn::Float64:
+        encodeFloats(column.constValues<double>() + begin, end - begin, bits);
+        break;
+    }
+    bits.finish();
+    return stream;
+}
+
+CsvColumn decodeValues(CsvColumn::Type type, const uchar* stream, qsizetype size, qsizetype rows, bool& valid)
+{
+    CsvColumn column(type);
+    column.resize(rows);
+    BitReader bits(stream, size);
+    valid = true;
+    switch (type)
+    {
+    case CsvColumn::Int64:
+        decodeIntegers(bits, reinterpret_cast<quint64*>(column.values<qint64>().data()), rows);
+        break;
+    case CsvColumn::UInt64:
+        decodeIntegers(bits, column.values<quint64>().data(), rows);
+        break;
+    case CsvColumn::Float32:
+    {
+        QVector<double> widened(rows);
+        valid = decodeFloats(bits, widened.data(), rows);
+        QVector<float>& values = column.values<float>();
+        for (qsizetype row = 0; row < rows; ++row)
+            values[row] = float(widened[row]);
+        break;
+    }
+    case CsvColumn::Float64:
+        valid = decodeFloats(bits, column.values<double>().data(), rows);
+        break;
+    }
+    return column;
+}
+
+// rows [begin, end) of every column of table, begin is a multiple of 64
+QByteArray encodeBlock(const CsvTable& table, qsizetype begin, qsizetype end)
+{
+    QByteArray block;
+    const qsizetype firstWord = begin / 64;
+    const qsizetype words = (end - begin + 63) / 64;
+    for (const CsvColumn& column : table.columns)
+    {
+        //the validity words are only stored for blocks that have empty cells
+        bool complete = true;
+        for (qsizetype word = 0; complete && !column.allValid() && word < words; ++word)
+        {
+            const qsizetype inWord = qMin<qsizetype>(end - begin - word * 64, 64);
+            const quint64 mask = inWord == 64 ? ~quint64(0) : (quint64(1) << inWord) - 1;
+            complete = (column.validityWords().at(firstWord + word) & mask) == mask;
+        }
+        const QByteArray stream = encodeValues(column, begin, end);
+        const ColumnChunk chunk = {complete ? 0 : quint32(words * sizeof(quint64)), quint32(stream.size())};
+        block.append(reinterpret_cast<const char*>(&chunk), sizeof(chunk));
+        if (!complete)
+            block.append(reinterpret_cast<const char*>(column.validityWords().constData() + firstWord),
+                         chunk.validityBytes);
+        block.append(stream);
+    }
+    return block;
+}
+
+// runs work(i) for every i in [0, count) on up to threadCount threads
+template <class Work>
+void parallelFor(qsizetype count, int threadCount, const Work& work)
+{
+    std::atomic<qsizetype> next{0};
+    auto run = [&next, count, &work]()
+    {
+        for (qsizetype i = next++; i < count; i = next++)
+            work(i);
+    };
+    std::vector<std::thread> workers;
+    for (qsizetype i = 1; i < qMin<qsizetype>(threadCount, count); ++i)
+        workers.emplace_back(run);
+    run();
+    for (auto& worker : workers)
+        worker.join();
+}
+} // namespace
+
+QString SeriesFile::fileSuffix()
+{
+    return "series";
+}
+
+bool SeriesFile::isSeriesFile(const QString& path)
+{
+    QFile file(path);
+    char magic[sizeof(Magic)];
+    return file.open(QIODevice::ReadOnly) && file.read(magic, sizeof(magic)) == qint64(sizeof(magic))
+           && std::memcmp(magic, Magic, sizeof(Magic)) == 0;
+}
+
+CsvTable SeriesFile::read(const QString& path, const QStringList& projection, int threadCount)
+{
+    return read(path, projection, threadCount, KeyRange());
+}
+
+CsvTable SeriesFile::read(const QString& path, const QStringList& projection, int threadCount, KeyRange range)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        throw std::runtime_error(QString("Error opening %1").arg(path).toStdString());
+    }
+    const qint64 fileSize = file.size();
+    uchar* mapped = fileSize >= qint64(sizeof(Header)) ? file.map(0, fileSize) : nullptr;
+    if (mapped == nullptr)
+    {
+        throw damaged(path);
+    }
+
+    Header header;
+    std::memcpy(&header, mapped, sizeof(Header));
+    const qint64 typesOffset = sizeof(Header) + qint64(header.namesLength);
+    const qint64 entriesOffset = typesOffset + qint64(header.columnCount) * qint64(sizeof(quint32));
+    bool valid = std::memcmp(header.magic, Magic, sizeof(Magic)) == 0 && header.version == Version
+                 && header.byteOrder == ByteOrderMark && header.blockRows > 0 && header.blockRows % 64 == 0
+                 && entriesOffset + qint64(header.blockCount) * qint64(sizeof(BlockEntry)) <= fileSize;
+
+    CsvTable table;
+    QVector<CsvColumn::Type> types;
+    if (valid)
+    {
+        const char* names = reinterpret_cast<const char*>(mapped + sizeof(Header));
+        table.header = QString::fromUtf8(names, header.namesLength).split(',', Qt::SkipEmptyParts);
+        valid = table.header.size() == qsizetype(header.columnCount);
+    }
+    for (quint32 column = 0; valid && column < header.columnCount; ++column)
+    {
+        quint32 type;
+        std::memcpy(&type, mapped + typesOffset + column * sizeof(quint32), sizeof(type));
+        valid = type <= CsvColumn::Float64;
+        types.append(CsvColumn::Type(type));
+    }
+
+    //blocks that may hold keys in range, all of them if the range is unbounded
+    const bool everyBlock = range.lower == -std::numeric_limits<double>::infinity()
+                            && range.upper == std::numeric_limits<double>::infinity();
+    QVector<BlockEntry> blocks;
+    for (quint32 block = 0; valid && block < header.blockCount; ++block)
+    {
+        BlockEntry entry;
+        std::memcpy(&entry, mapped + entriesOffset + block * sizeof(BlockEntry), sizeof(entry));
+        valid = entry.offset + entry.size <= quint64(fileSize) && entry.rowCount <= header.blockRows;
+        if (everyBlock || (entry.maxKey >= range.lower && entry.minKey < range.upper))
+            blocks.append(entry);
+    }
+    if (!valid)
+    {
+        file.unmap(mapped);
+        throw damaged(path);
+    }
+
+    QVector<qsizetype> selected;
+    for (qsizetype column = 0; column < table.header.size(); ++column)
+    {
+        if (projection.isEmpty() || projection.contains(table.header.at(column)))
+        {
+            selected.append(column);
+            table.keys.append(table.header.at(column));
+            table.columns.append(CsvColumn(types.at(column)));
+        }
+    }
+
+    //blocks are decoded in parallel into their own columns, appended in file order afterwards
+    QVector<QVector<CsvColumn>> decoded(blocks.size());
+    std::atomic<bool> blockDamaged{false};
+    parallelFor(blocks.size(), threadCount,
+                [&](qsizetype block)
+                {
+                    const BlockEntry& entry = blocks.at(block);
+                    const uchar* data = mapped + entry.offset;
+                    const uchar* end = data + entry.size;
+                    const qint64 validityBytes = qint64((entry.rowCount + 63) / 64) * qint64(sizeof(quint64));
+                    QVector<CsvColumn>& columns = decoded[block];
+                    for (qsizetype column = 0, next = 0; column < types.size() && next < selected.size(); ++column)
+                    {
+                        ColumnChunk chunk;
+                        if (end - data < qint64(sizeof(chunk)))
+                            break;
+                        std::memcpy(&chunk, data, sizeof(chunk));
+                        data += sizeof(chunk);
+                        if ((chunk.validityBytes != 0 && chunk.validityBytes != validityBytes)
+                            || end - data < qint64(chunk.validityBytes) + qint64(chunk.streamBytes))
+                            break;
+                        if (selected.at(next) == column)
+                        {
+                            bool streamValid;
+                            CsvColumn values = decodeValues(types.at(column), data + chunk.validityBytes,
+                                                            chunk.streamBytes, entry.rowCount, streamValid);
+                            if (!streamValid)
+                                break;
+                            if (chunk.validityBytes != 0)
+                            {
+                                QVector<quint64> words(validityBytes / qint64(sizeof(quint64)));
+                                std::memcpy(words.data(), data, chunk.validityBytes);
+                                values.setValidityWords(words);
+                            }
+                            columns.append(std::move(values));
+                            ++next;
+                        }
+                        data += chunk.validityBytes + chunk.streamBytes;
+                    }
+                    if (columns.size() != selected.size())
+                        blockDamaged = true;
+                });
+    file.unmap(mapped);
+    if (blockDamaged)
+    {
+        throw damaged(path);
+    }
+
+    for (qsizetype column = 0; column < table.columns.size(); ++column)
+    {
+        qsizetype rows = 0;
+        for (const auto& block : decoded)
+            rows += block.at(column).size();
+        table.columns[column].reserve(rows);
+        for (auto& block : decoded)
+        {
+            table.columns[column].append(block.at(column));
+            block[column] = CsvColumn();
+        }
+    }
+    table.sourceBytes = fileSize;
+    return table;
+}
+
+bool SeriesFile::write(const QString& path, const CsvTable& table, int threadCount)
+{
+    const qsizetype rows = table.rowCount();
+    const QByteArray names = table.keys.join(',').toUtf8();
+    const qsizetype keyColumn = qMax<qsizetype>(table.keys.indexOf("timestamp"), 0);
+    const qsizetype blockCount = (rows + BlockRows - 1) / BlockRows;
+
+    //blocks are encoded in parallel, each with the key range the index needs
+    QVector<QByteArray> blocks(blockCount);
+    QVector<BlockEntry> entries(blockCount);
+    parallelFor(blockCount, threadCount,
+                [&](qsizetype block)
+                {
+                    const qsizetype begin = block * BlockRows;
+                    const qsizetype end = qMin<qsizetype>(begin + BlockRows, rows);
+                    blocks[block] = encodeBlock(table, begin, end);
+                    BlockEntry& entry = entries[block];
+                    entry.rowCount = quint32(end - begin);
+                    entry.size = quint32(blocks.at(block).size());
+                    entry.minKey = std::numeric_limits<double>::infinity();
+                    entry.maxKey = -std::numeric_limits<double>::infinity();
+                    const CsvColumn& key = table.columns.at(keyColumn);
+                    for (qsizetype row = begin; row < end; ++row)
+                    {
+                        if (key.isValid(row))
+                        {
+                            entry.minKey = qMin(entry.minKey, key.value(row));
+                            entry.maxKey = qMax(entry.maxKey, key.value(row));
+                        }
+                    }
+                });
+    quint64 offset = sizeof(Header) + names.size() + table.columns.size() * sizeof(quint32)
+                     + blockCount * sizeof(BlockEntry);
+    for (BlockEntry& entry : entries)
+    {
+        entry.offset = offset;
+        offset += entry.size;
+    }
+
+    Header header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.byteOrder = ByteOrderMark;
+    header.rowCount = quint64(rows);
+    header.columnCount = quint32(table.columns.size());
+    header.keyColumn = quint32(keyColumn);
+    header.blockRows = BlockRows;
+    header.blockCount = quint32(blockCount);
+    header.namesLength = quint32(names.size());
+    header.reserved = 0;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(names);
+    for (const CsvColumn& column : table.columns)
+    {
+        const quint32 type = column.type();
+        file.write(reinterpret_cast<const char*>(&type), sizeof(type));
+    }
+    file.write(reinterpret_cast<const char*>(entries.constData()), entries.size() * qint64(sizeof(BlockEntry)));
+    for (const QByteArray& block : blocks)
+    {
+        file.write(block);
+    }
+    return file.commit();
+}
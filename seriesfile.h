@@ -0,0 +1,40 @@
+#ifndef SERIESFILE_H
+#define SERIESFILE_H
+
+#include "csvparser.h"
+
+#include <limits>
+
+// Compressed on-disk format for parsed columns. Rows are stored in blocks of
+// BlockRows rows that decode independently of each other: integer columns as
+// delta-of-delta bit streams, floating point columns as Gorilla style XOR bit
+// streams, each with its validity bitmap if it has empty cells. A block index
+// with the key range of every block allows decoding just the rows of a key range.
+class SeriesFile
+{
+public:
+    static constexpr quint32 Version = 1;
+    static constexpr quint32 BlockRows = 8192; // a multiple of 64, blocks hold whole validity words
+
+    // a half open range of keys, unbounded by default
+    struct KeyRange
+    {
+        double lower = -std::numeric_limits<double>::infinity();
+        double upper = std::numeric_limits<double>::infinity();
+    };
+
+    static QString fileSuffix();
+    // true if path starts with the series file magic
+    static bool isSeriesFile(const QString& path);
+
+    // the projected columns (all if projection is empty) of every row, decoded on threadCount threads.
+    // Throws std::runtime_error if the file can't be read or is damaged
+    static CsvTable read(const QString& path, const QStringList& projection, int threadCount);
+    // the same for just the blocks whose keys overlap range
+    static CsvTable read(const QString& path, const QStringList& projection, int threadCount, KeyRange range);
+    // writes table to path encoding blocks on threadCount threads, the timestamp column (else the
+    // first) is the key. Returns false if the file couldn't be written
+    static bool write(const QString& path, const CsvTable& table, int threadCount);
+};
+
+#endif // SERIESFILE_H
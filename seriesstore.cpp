@@ -0,0 +1,189 @@
+#include "seriesstore.h"
+
+#include <cstring>
+#include <new>
+
+namespace
+{
+std::shared_ptr<void> allocateAligned(qsizetype bytes)
+{
+    void* memory = ::operator new(size_t(bytes), std::align_val_t(SeriesStore::Alignment));
+    return std::shared_ptr<void>(memory,
+                                 [](void* p) { ::operator delete(p, std::align_val_t(SeriesStore::Alignment)); });
+}
+} // namespace
+
+SeriesStore::ColumnId SeriesStore::intern(const QString& name)
+{
+    auto found = ids.find(name);
+    if (found != ids.end())
+    {
+        return found->second;
+    }
+    const ColumnId id = ColumnId(columns.size());
+    Column column;
+    column.name = name;
+    columns.append(column);
+    ids.emplace(name, id);
+    return id;
+}
+
+SeriesStore::ColumnId SeriesStore::id(const QString& name) const
+{
+    auto found = ids.find(name);
+    return found == ids.end() ? NoColumn : found->second;
+}
+
+const QString& SeriesStore::name(ColumnId id) const
+{
+    return columns.at(id).name;
+}
+
+void SeriesStore::clear()
+{
+    columns.clear();
+    ids.clear();
+}
+
+void SeriesStore::reserve(Column& column, qsizetype rows)
+{
+    if (column.buffer && rows <= column.capacity)
+    {
+        return;
+    }
+    //doubling keeps appending followed rows amortized constant per row
+    const qsizetype elementSize = CsvColumn::elementSize(column.type);
+    const qsizetype capacity = qMax<qsizetype>(qMax(rows, column.capacity * 2), Alignment / elementSize);
+    std::shared_ptr<void> buffer = allocateAligned(capacity * elementSize);
+    if (column.buffer)
+    {
+        std::memcpy(buffer.get(), column.buffer.get(), column.rows * elementSize);
+    }
+    column.buffer = std::move(buffer);
+    column.capacity = capacity;
+}
+
+void SeriesStore::setColumn(ColumnId id, const CsvColumn& source)
+{
+    Column& column = columns[id];
+    column.type = source.type();
+    column.buffer.reset();
+    column.capacity = 0;
+    reserve(column, source.size());
+    std::memcpy(column.buffer.get(), source.constData(), source.byteSize());
+    column.rows = source.size();
+    column.validity = source.validityWords();
+}
+
+void SeriesStore::removeColumn(ColumnId id)
+{
+    Column& column = columns[id];
+    column.buffer.reset();
+    column.rows = 0;
+    column.capacity = 0;
+    column.validity.clear();
+}
+
+void SeriesStore::append(const CsvTable& table)
+{
+    for (qsizetype keyIndex = 0; keyIndex < table.keys.size(); ++keyIndex)
+    {
+        const ColumnId columnId = id(table.keys.at(keyIndex));
+        const CsvColumn& other = table.columns.at(keyIndex);
+        if (!hasValues(columnId) || other.size() == 0)
+        {
+            continue;
+        }
+        Column& column = columns[columnId];
+        if (other.type() != column.type)
+        {
+            CsvColumn widened = view(columnId);
+            widened.append(other);
+            setColumn(columnId, widened);
+            continue;
+        }
+
+        const qsizetype rows = column.rows;
+        reserve(column, rows + other.size());
+        std::memcpy(static_cast<char*>(column.buffer.get()) + rows * CsvColumn::elementSize(column.type),
+                    other.constData(), other.byteSize());
+        column.rows += other.size();
+        if (column.validity.isEmpty() && other.allValid())
+        {
+            continue;
+        }
+
+        //shift the words of other in behind the rows already here, the rows before are all valid
+        // if there was no bitmap yet
+        if (column.validity.isEmpty())
+        {
+            column.validity.fill(~quint64(0), (rows + 63) / 64);
+            if (rows % 64 != 0)
+                column.validity.last() = (quint64(1) << (rows % 64)) - 1;
+        }
+        column.validity.resize((column.rows + 63) / 64);
+        const QVector<quint64>& otherValidity = other.validityWords();
+        const qsizetype otherRows = other.size();
+        const int shift = int(rows & 63);
+        for (qsizetype word = 0; word * 64 < otherRows; ++word)
+        {
+            const qsizetype inWord = otherRows - word * 64;
+            const quint64 bits = !otherValidity.isEmpty() ? otherValidity[word]
+                                 : inWord >= 64           ? ~quint64(0)
+                                                          : (quint64(1) << inWord) - 1;
+            const qsizetype target = (rows >> 6) + word;
+            column.validity[target] |= bits << shift;
+            if (shift != 0 && target + 1 < column.validity.size())
+                column.validity[target + 1] |= bits >> (64 - shift);
+        }
+    }
+}
+
+double SeriesStore::value(ColumnId id, qsizetype row) const
+{
+    switch (columns.at(id).type)
+    {
+    case CsvColumn::Int64:
+        return double(values<qint64>(id)[row]);
+    case CsvColumn::UInt64:
+        return double(values<quint64>(id)[row]);
+    case CsvColumn::Float32:
+        return double(values<float>(id)[row]);
+    case CsvColumn::Float64:
+        break;
+    }
+    return values<double>(id)[row];
+}
+
+CsvColumn SeriesStore::view(ColumnId id) const
+{
+    const Column& column = columns.at(id);
+    CsvColumn view = CsvColumn::borrow(column.type, column.buffer.get(), column.rows, column.buffer);
+    view.setValidityWords(column.validity);
+    return view;
+}
+
+qsizetype SeriesStore::findRow(ColumnId keyId, double key) const
+{
+    qsizetype lower = 0;
+    qsizetype upper = rowCount(keyId);
+    while (lower < upper)
+    {
+        const qsizetype middle = lower + (upper - lower) / 2;
+        if (value(keyId, middle) < key)
+            lower = middle + 1;
+        else
+            upper = middle;
+    }
+    return lower < rowCount(keyId) && value(keyId, lower) == key ? lower : -1;
+}
+
+qint64 SeriesStore::byteSize() const
+{
+    qint64 bytes = 0;
+    for (const Column& column : columns)
+    {
+        bytes += column.rows * CsvColumn::elementSize(column.type) + column.validity.size() * qint64(sizeof(quint64));
+    }
+    return bytes;
+}
@@ -0,0 +1,127 @@
+#ifndef SERIESSTORE_H
+#define SERIESSTORE_H
+
+#include "csvparser.h"
+
+#include <memory>
+#include <unordered_map>
+
+// The columns of the open chart. A column name is interned to a small integer
+// id the first time it is seen, so code that runs per row or per event indexes
+// a vector instead of hashing names. The values of each loaded column live in a
+// 64 byte aligned buffer of its storage type, which grows geometrically as rows
+// are appended, next to its validity bitmap.
+class SeriesStore
+{
+public:
+    using ColumnId = int;
+    static constexpr ColumnId NoColumn = -1;
+    static constexpr qsizetype Alignment = 64;
+
+    // the values of a column, valid until the column next changes
+    template <class T>
+    struct Span
+    {
+        const T* data = nullptr;
+        qsizetype size = 0;
+
+        const T* begin() const
+        {
+            return data;
+        }
+        const T* end() const
+        {
+            return data + size;
+        }
+        const T& operator[](qsizetype row) const
+        {
+            return data[row];
+        }
+    };
+
+    // the id of name, a new one if it wasn't seen since the last clear()
+    ColumnId intern(const QString& name);
+    // the id of name, NoColumn if it was never interned
+    ColumnId id(const QString& name) const;
+    const QString& name(ColumnId id) const;
+    qsizetype columnCount() const
+    {
+        return columns.size();
+    }
+    // drops every column and id
+    void clear();
+
+    // true if the column has values, ids without any are NoColumn or columns not loaded yet
+    bool hasValues(ColumnId id) const
+    {
+        return id >= 0 && id < columns.size() && columns.at(id).buffer != nullptr;
+    }
+    // copies the values of column into the aligned buffer of id
+    void setColumn(ColumnId id, const CsvColumn& column);
+    void removeColumn(ColumnId id);
+    // appends the rows of the loaded columns among the keys of table. A column meeting rows of
+    // another type is widened to Float64
+    void append(const CsvTable& table);
+
+    qsizetype rowCount(ColumnId id) const
+    {
+        return columns.at(id).rows;
+    }
+    CsvColumn::Type type(ColumnId id) const
+    {
+        return columns.at(id).type;
+    }
+    // the values of a column stored as T
+    template <class T>
+    Span<T> values(ColumnId id) const
+    {
+        const Column& column = columns.at(id);
+        Q_ASSERT(CsvColumn::elementSize(column.type) == qsizetype(sizeof(T)));
+        return Span<T>{static_cast<const T*>(column.buffer.get()), column.rows};
+    }
+    bool allValid(ColumnId id) const
+    {
+        return columns.at(id).validity.isEmpty();
+    }
+    bool isValid(ColumnId id, qsizetype row) const
+    {
+        const QVector<quint64>& validity = columns.at(id).validity;
+        return validity.isEmpty() || (validity[row >> 6] >> (row & 63)) & 1;
+    }
+    double value(ColumnId id, qsizetype row) const;
+    // the buffer holding the values of id. Appending may move them to a new one, the old buffer
+    // stays alive as long as it is held
+    std::shared_ptr<const void> buffer(ColumnId id) const
+    {
+        return columns.at(id).buffer;
+    }
+    const QVector<quint64>& validityWords(ColumnId id) const
+    {
+        return columns.at(id).validity;
+    }
+    // a CsvColumn borrowing the values of id, which keeps them alive after the column changes
+    CsvColumn view(ColumnId id) const;
+
+    // the row whose key column holds key, -1 if there is none. The keys must ascend
+    qsizetype findRow(ColumnId keyId, double key) const;
+    // bytes taken by the values and bitmaps of the loaded columns
+    qint64 byteSize() const;
+
+private:
+    struct Column
+    {
+        QString name;
+        CsvColumn::Type type = CsvColumn::Float64;
+        std::shared_ptr<void> buffer; // capacity values, null while the column isn't loaded
+        qsizetype rows = 0;
+        qsizetype capacity = 0;
+        QVector<quint64> validity; // empty while all rows are valid
+    };
+
+    void reserve(Column& column, qsizetype rows);
+
+    QVector<Column> columns;
+    std::unordered_map<QString, ColumnId> ids;
+};
+
+#endif // SERIESSTORE_H
@@ -0,0 +1,174 @@
+#include "sessioncalendar.h"
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+//a step between two bars ends a session once it is this many bars long, and at least MinSessionGap. Shorter
+// steps are bars missing within a session
+constexpr double SessionGapBars = 1.5;
+constexpr double MinSessionGap = 30 * 60;
+//round times over a range this many tick steps longer in real time than in trading time aren't looked for,
+// the ticks stay at round coordinates
+constexpr double MaxTimeTicks = 1000;
+} // namespace
+
+void SessionCalendar::extend(const QVector<double>& keys)
+{
+    if (interval <= 0)
+    {
+        interval = std::numeric_limits<double>::infinity();
+        for (qsizetype i = 1; i < qMin<qsizetype>(keys.size(), 1024); ++i)
+        {
+            const double step = keys.at(i) - keys.at(i - 1);
+            if (step > 0)
+            {
+                interval = qMin(interval, step);
+            }
+        }
+        if (std::isinf(interval))
+        {
+            interval = 0;
+        }
+    }
+    const double gap = qMax(SessionGapBars * interval, MinSessionGap);
+    for (double key : keys)
+    {
+        if (!sessions.isEmpty() && key - (sessions.last().end - interval) <= gap)
+        {
+            sessions.last().end = qMax(sessions.last().end, key + interval);
+            continue;
+        }
+        const double coord =
+            sessions.isEmpty() ? key : sessions.last().coord + sessions.last().end - sessions.last().begin;
+        sessions.append(Session{key, key + interval, coord});
+    }
+    index();
+}
+
+double SessionCalendar::toCoord(double time) const
+{
+    if (sessions.isEmpty())
+    {
+        return time;
+    }
+    const int i = sessionAfter(time);
+    if (i == sessions.size())
+    {
+        return sessions.last().coord + (time - sessions.last().begin);
+    }
+    const Session& session = sessions.at(i);
+    if (i > 0 && time < session.begin)
+    {
+        return session.coord; // between sessions
+    }
+    return session.coord + (time - session.begin);
+}
+
+double SessionCalendar::toTime(double coord) const
+{
+    if (sessions.isEmpty())
+    {
+        return coord;
+    }
+    const Session& session = sessions.at(qMax(sessionAt(coord), 0));
+    return session.begin + (coord - session.coord);
+}
+
+int SessionCalendar::sessionAfter(double time) const
+{
+    const int count = sessions.size();
+    const double bucket = bucketSeconds > 0 ? (time - sessions.first().begin) / bucketSeconds : 0;
+    int i = timeBuckets.at(!(bucket > 0) ? 0 : bucket >= count ? count : int(bucket));
+    //the bucket's first session is at most a rounding error off, the ones ending within the bucket are skipped
+    while (i > 0 && sessions.at(i - 1).end > time)
+    {
+        --i;
+    }
+    while (i < count && sessions.at(i).end <= time)
+    {
+        ++i;
+    }
+    return i;
+}
+
+int SessionCalendar::sessionAt(double coord) const
+{
+    const int count = sessions.size();
+    const double bucket = bucketCoords > 0 ? (coord - sessions.first().coord) / bucketCoords : 0;
+    int i = coordBuckets.at(!(bucket > 0) ? 0 : bucket >= count ? count : int(bucket));
+    while (i >= 0 && sessions.at(i).coord > coord)
+    {
+        --i;
+    }
+    while (i + 1 < count && sessions.at(i + 1).coord <= coord)
+    {
+        ++i;
+    }
+    return i;
+}
+
+void SessionCalendar::index()
+{
+    //a bucket per session on average, of times from the first begin to the last end and of their coordinates
+    const int count = sessions.size();
+    if (count == 0)
+    {
+        return;
+    }
+    const Session& first = sessions.first();
+    const Session& last = sessions.last();
+    bucketSeconds = (last.end - first.begin) / count;
+    bucketCoords = (last.coord + (last.end - last.begin) - first.coord) / count;
+    timeBuckets.resize(count + 1);
+    coordBuckets.resize(count + 1);
+    int after = 0;
+    int at = 0;
+    for (int bucket = 0; bucket <= count; ++bucket)
+    {
+        const double time = first.begin + bucket * bucketSeconds;
+        while (after < count && sessions.at(after).end <= time)
+        {
+            ++after;
+        }
+        timeBuckets[bucket] = after;
+        const double coord = first.coord + bucket * bucketCoords;
+        while (at + 1 < count && sessions.at(at + 1).coord <= coord)
+        {
+            ++at;
+        }
+        coordBuckets[bucket] = at;
+    }
+}
+
+SessionTicker::SessionTicker(QSharedPointer<const SessionCalendar> sessions)
+    : sessions(sessions)
+{
+}
+
+QString SessionTicker::getTickLabel(double tick, const QLocale& locale, QChar formatChar, int precision)
+{
+    return QCPAxisTickerDateTime::getTickLabel(sessions->toTime(tick), locale, formatChar, precision);
+}
+
+QVector<double> SessionTicker::createTickVector(double tickStep, const QCPRange& range)
+{
+    //the step was picked for the trading time of the range, the round times are looked for in the real time it covers
+    const QCPRange times(sessions->toTime(range.lower), sessions->toTime(range.upper));
+    if (times.size() > MaxTimeTicks * tickStep)
+    {
+        return QCPAxisTickerDateTime::createTickVector(tickStep, range);
+    }
+    QVector<double> ticks;
+    for (double time : QCPAxisTickerDateTime::createTickVector(tickStep, times))
+    {
+        //ticks between sessions move to the start of the next one, where they give way to the tick before them
+        const double coord = sessions->toCoord(time);
+        if (ticks.isEmpty() || coord - ticks.last() >= tickStep / 2)
+        {
+            ticks.append(coord);
+        }
+    }
+    return ticks;
+}
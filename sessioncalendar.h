@@ -0,0 +1,69 @@
+#ifndef SESSIONCALENDAR_H
+#define SESSIONCALENDAR_H
+
+#include "qcustomplot.h"
+
+// The trading sessions of a series, the runs of its bars between the gaps of
+// nights, weekends and holidays, and the session coordinate the plottables'
+// keys are given in so a chart pans and zooms over trading time only. The
+// coordinate is the time with the gaps before it taken out: within a session it
+// moves with the time, so bars keep their spacing in seconds and a candle width
+// its meaning, and a session starts a bar after the one before it ends. Over the
+// first session the coordinate is the time. Both conversions look the session up
+// in a table of equal buckets, constant time unless the sessions are spread very
+// unevenly.
+class SessionCalendar
+{
+public:
+    // appends the sessions of keys, which must ascend. Keys before the end of the last session are
+    // part of it, so rows appended behind the loaded ones don't move the sessions
+    void extend(const QVector<double>& keys);
+
+    int size() const
+    {
+        return sessions.size();
+    }
+    // times between two sessions map to the start of the later one, times before or after all
+    // sessions continue the first or last one
+    double toCoord(double time) const;
+    double toTime(double coord) const;
+
+private:
+    struct Session
+    {
+        double begin; // the key of the first bar
+        double end;   // a bar after the key of the last bar
+        double coord; // the coordinate of begin
+    };
+
+    // the first session ending after time, size() if there is none
+    int sessionAfter(double time) const;
+    // the last session starting at or before coord, -1 if there is none
+    int sessionAt(double coord) const;
+    void index();
+
+    QVector<Session> sessions;
+    double interval = 0; // the smallest step between the first keys, the timeframe of the bars
+    double bucketSeconds = 0;
+    double bucketCoords = 0;
+    QVector<int> timeBuckets;  // the first session ending after the start of each bucket of times
+    QVector<int> coordBuckets; // the last session starting at or before the start of each bucket of coordinates
+};
+
+// Labels an axis of session coordinates with the real times of its ticks. The
+// tick step follows the trading time shown, ticks are put at round times and a
+// round time between two sessions moves to the start of the later one.
+class SessionTicker : public QCPAxisTickerDateTime
+{
+public:
+    explicit SessionTicker(QSharedPointer<const SessionCalendar> sessions);
+
+protected:
+    QString getTickLabel(double tick, const QLocale& locale, QChar formatChar, int precision) override;
+    QVector<double> createTickVector(double tickStep, const QCPRange& range) override;
+
+private:
+    QSharedPointer<const SessionCalendar> sessions;
+};
+
+#endif // SESSIONCALENDAR_H
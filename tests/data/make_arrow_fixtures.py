@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+# Writes the arrow files tst_arrowfile reads. Regenerating them needs pyarrow, which is not part of
+# the tree (pip install pyarrow); the files are committed so building and running the tests doesn't.
+# Run from this directory:
+#   python3 make_arrow_fixtures.py
+import datetime
+
+import pyarrow as pa
+import pyarrow.feather as feather
+
+# 2024-01-02 00:00:00 UTC and the rows after it, a minute apart
+START = 1704153600
+ROWS = 5
+seconds = [START + 60 * row for row in range(ROWS)]
+
+
+def scaled(values, units):
+    return [value * units for value in values]
+
+
+# every temporal type in every unit, whole seconds except the columns named fraction
+temporal = pa.table({
+    "timestamp_s": pa.array(seconds, pa.timestamp("s")),
+    "timestamp_ms": pa.array(scaled(seconds, 1000), pa.timestamp("ms")),
+    "timestamp_us": pa.array(scaled(seconds, 1000000), pa.timestamp("us", tz="UTC")),
+    "timestamp_ns": pa.array(scaled(seconds, 1000000000), pa.timestamp("ns")),
+    "timestamp_ms_fraction": pa.array([value * 1000 + 250 for value in seconds], pa.timestamp("ms")),
+    "timestamp_ns_null": pa.array([None if row == 2 else seconds[row] * 1000000000 + 7 for row in range(ROWS)],
+                                  pa.timestamp("ns")),
+    "date32": pa.array([datetime.date(2024, 2, 28 + row) if row < 2 else datetime.date(2024, 3, row - 1)
+                        for row in range(ROWS)], pa.date32()),
+    "date64": pa.array(scaled([START + 86400 * row for row in range(ROWS)], 1000), pa.date64()),
+    "time32_s": pa.array([3600 * row for row in range(ROWS)], pa.time32("s")),
+    "time32_ms": pa.array([1500 * row for row in range(ROWS)], pa.time32("ms")),
+    "time64_us": pa.array([90000000 * row for row in range(ROWS)], pa.time64("us")),
+    "duration_ns": pa.array([2000000000 * row for row in range(ROWS)], pa.duration("ns")),
+    "duration_ms": pa.array([500 * row for row in range(ROWS)], pa.duration("ms")),
+})
+feather.write_feather(temporal, "temporal.arrow", compression="uncompressed")
+
+# a chart's columns in two record batches with empty cells, an int32 and a string column
+rows = 10
+candles = pa.table({
+    "timestamp": pa.array(scaled([START + 60 * row for row in range(rows)], 1000000000), pa.timestamp("ns")),
+    "price_open": pa.array([100.0 + row for row in range(rows)], pa.float64()),
+    "price_close": pa.array([100.5 + row for row in range(rows)], pa.float32()),
+    "volume": pa.array([None if row % 4 == 1 else 10 * row for row in range(rows)], pa.uint64()),
+    "trades": pa.array([row - 3 for row in range(rows)], pa.int32()),
+    "symbol": pa.array(["AAPL"] * rows),
+})
+feather.write_feather(candles, "batches.arrow", compression="uncompressed", chunksize=6)
@@ -0,0 +1,134 @@
+#include "arrowfile.h"
+
+#include <QtTest>
+
+namespace
+{
+//2024-01-02 00:00:00 UTC, the first row of the fixtures, which are a minute apart
+const qint64 Start = 1704153600;
+const qsizetype Rows = 5;
+
+const CsvColumn& column(const CsvTable& table, const QString& key)
+{
+    const qsizetype index = table.keys.indexOf(key);
+    if (index < 0)
+    {
+        throw std::runtime_error(QString("no column %1").arg(key).toStdString());
+    }
+    return table.columns.at(index);
+}
+} // namespace
+
+class TestArrowFile : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void timestampsInEveryUnit();
+    void fractionalSeconds();
+    void datesTimesAndDurations();
+    void recordBatches();
+    void projection();
+
+private:
+    CsvTable temporal;
+};
+
+void TestArrowFile::initTestCase()
+{
+    const QString path = TEST_DATA_DIR "/temporal.arrow";
+    QVERIFY(ArrowFile::isArrowFile(path));
+    temporal = ArrowFile::read(path, {});
+}
+
+void TestArrowFile::timestampsInEveryUnit()
+{
+    for (const QString& key : {"timestamp_s", "timestamp_ms", "timestamp_us", "timestamp_ns"})
+    {
+        const CsvColumn& values = column(temporal, key);
+        QCOMPARE(values.type(), CsvColumn::Int64);
+        QCOMPARE(values.size(), Rows);
+        for (qint64 row = 0; row < Rows; row++)
+        {
+            QCOMPARE(values.constValues<qint64>()[row], Start + 60 * row);
+        }
+    }
+    //seconds are already what the chart keys on, they stay in the mapping
+    QVERIFY(column(temporal, "timestamp_s").isBorrowed());
+    QVERIFY(!column(temporal, "timestamp_ns").isBorrowed());
+}
+
+void TestArrowFile::fractionalSeconds()
+{
+    const CsvColumn& milliseconds = column(temporal, "timestamp_ms_fraction");
+    QCOMPARE(milliseconds.type(), CsvColumn::Float64);
+    QCOMPARE(milliseconds.value(3), double(Start + 180) + 0.25);
+
+    //the empty cell stays empty, the others keep their nanoseconds as far as a double holds them
+    const CsvColumn& nanoseconds = column(temporal, "timestamp_ns_null");
+    QCOMPARE(nanoseconds.type(), CsvColumn::Float64);
+    QVERIFY(!nanoseconds.isValid(2));
+    QVERIFY(nanoseconds.isValid(1) && nanoseconds.isValid(3));
+    QCOMPARE(nanoseconds.value(4), double(Start + 240) + 7e-9);
+}
+
+void TestArrowFile::datesTimesAndDurations()
+{
+    //2024-02-28 to 2024-03-03 across the leap day
+    const CsvColumn& date32 = column(temporal, "date32");
+    QCOMPARE(date32.type(), CsvColumn::Int64);
+    QCOMPARE(date32.constValues<qint64>()[0], qint64(1709078400));
+    QCOMPARE(date32.constValues<qint64>()[1], qint64(1709164800));
+    QCOMPARE(date32.constValues<qint64>()[2], qint64(1709251200));
+    QCOMPARE(date32.constValues<qint64>()[4], qint64(1709251200 + 2 * 86400));
+
+    const CsvColumn& date64 = column(temporal, "date64");
+    QCOMPARE(date64.type(), CsvColumn::Int64);
+    QCOMPARE(date64.constValues<qint64>()[3], Start + 3 * 86400);
+
+    QCOMPARE(column(temporal, "time32_s").constValues<qint64>()[2], qint64(7200));
+    QCOMPARE(column(temporal, "time32_ms").type(), CsvColumn::Float64);
+    QCOMPARE(column(temporal, "time32_ms").value(1), 1.5);
+    QCOMPARE(column(temporal, "time64_us").constValues<qint64>()[2], qint64(180));
+    QCOMPARE(column(temporal, "duration_ns").constValues<qint64>()[4], qint64(8));
+    QCOMPARE(column(temporal, "duration_ms").value(3), 1.5);
+}
+
+void TestArrowFile::recordBatches()
+{
+    const CsvTable table = ArrowFile::read(TEST_DATA_DIR "/batches.arrow", {});
+    QCOMPARE(table.rowCount(), qsizetype(10));
+    QVERIFY(!table.header.contains("symbol")); // strings are skipped
+
+    const CsvColumn& timestamp = column(table, "timestamp");
+    QCOMPARE(timestamp.type(), CsvColumn::Int64);
+    QCOMPARE(timestamp.constValues<qint64>()[7], Start + 7 * 60);
+    QCOMPARE(column(table, "price_open").type(), CsvColumn::Float64);
+    QCOMPARE(column(table, "price_close").type(), CsvColumn::Float32);
+    QCOMPARE(column(table, "price_close").value(9), 109.5);
+    QCOMPARE(column(table, "trades").constValues<qint64>()[0], qint64(-3));
+
+    //the validity of the second batch is shifted in behind the first
+    const CsvColumn& volume = column(table, "volume");
+    QCOMPARE(volume.type(), CsvColumn::UInt64);
+    for (qsizetype row = 0; row < table.rowCount(); row++)
+    {
+        QCOMPARE(volume.isValid(row), row % 4 != 1);
+        if (volume.isValid(row))
+        {
+            QCOMPARE(volume.value(row), 10.0 * row);
+        }
+    }
+}
+
+void TestArrowFile::projection()
+{
+    const CsvTable table = ArrowFile::read(TEST_DATA_DIR "/batches.arrow", {"volume", "timestamp"});
+    QCOMPARE(table.keys, QStringList({"timestamp", "volume"}));
+    QCOMPARE(table.header, QStringList({"timestamp", "price_open", "price_close", "volume", "trades"}));
+    QCOMPARE(table.rowCount(), qsizetype(10));
+}
+
+QTEST_MAIN(TestArrowFile)
+#include "tst_arrowfile.moc"
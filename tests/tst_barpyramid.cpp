@@ -0,0 +1,231 @@
+#include "barpyramid.h"
+#include "sessioncalendar.h"
+
+#include <QtTest>
+
+namespace
+{
+const double Hour = 3600;
+const double Day = 24 * Hour;
+//2024-01-01 00:00:00 UTC, a Monday
+const double Monday = 1704067200;
+
+struct Bars
+{
+    QCPFinancialDataContainer candles;
+    QCPBarsDataContainer volume;
+};
+
+//bars of step seconds from start for days days, each day from its opensAt to closesAt seconds after utc midnight,
+// the two in the same day or around midnight. Every bar has a volume of 1
+Bars bars(double start, int days, double step, double opensAt, double closesAt)
+{
+    QVector<QCPFinancialData> candles;
+    QVector<QCPBarsData> volume;
+    const double open = opensAt < closesAt ? opensAt : opensAt - Day;
+    for (int day = 0; day < days; day++)
+    {
+        for (double key = start + day * Day + open; key < start + day * Day + closesAt; key += step)
+        {
+            const double price = 100 + int(key / step) % 97;
+            candles.append(QCPFinancialData(key, price, price + 1, price - 1, price + 0.5));
+            volume.append(QCPBarsData(key, 1));
+        }
+    }
+    Bars result;
+    result.candles.set(candles, true);
+    result.volume.set(volume, true);
+    return result;
+}
+
+//the bars with their keys in the session coordinates of sessions
+Bars inSessions(const Bars& timed, const SessionCalendar& sessions)
+{
+    QVector<QCPFinancialData> candles(timed.candles.constBegin(), timed.candles.constEnd());
+    QVector<QCPBarsData> volume(timed.volume.constBegin(), timed.volume.constEnd());
+    for (QCPFinancialData& candle : candles)
+    {
+        candle.key = sessions.toCoord(candle.key);
+    }
+    for (QCPBarsData& bar : volume)
+    {
+        bar.key = sessions.toCoord(bar.key);
+    }
+    Bars result;
+    result.candles.set(candles, true);
+    result.volume.set(volume, true);
+    return result;
+}
+
+//the levels have the buckets of expected, keyed by the session coordinates of their keys if there are sessions
+void compareLevels(const QVector<BarPyramid::Level>& levels, const QVector<BarPyramid::Level>& expected,
+                   const SessionCalendar* sessions = nullptr)
+{
+    QCOMPARE(levels.size(), expected.size());
+    for (qsizetype i = 0; i < expected.size(); i++)
+    {
+        QCOMPARE(levels.at(i).seconds, expected.at(i).seconds);
+        QCOMPARE(levels.at(i).dayStart, expected.at(i).dayStart);
+        QCOMPARE(levels.at(i).candles->size(), expected.at(i).candles->size());
+        for (int bar = 0; bar < expected.at(i).candles->size(); bar++)
+        {
+            const QCPFinancialData actual = *(levels.at(i).candles->constBegin() + bar);
+            const QCPFinancialData wanted = *(expected.at(i).candles->constBegin() + bar);
+            const double key = sessions ? sessions->toCoord(wanted.key) : wanted.key;
+            QCOMPARE(actual.key, key);
+            QCOMPARE(actual.open, wanted.open);
+            QCOMPARE(actual.high, wanted.high);
+            QCOMPARE(actual.low, wanted.low);
+            QCOMPARE(actual.close, wanted.close);
+            QCOMPARE((levels.at(i).volume->constBegin() + bar)->key, key);
+            QCOMPARE((levels.at(i).volume->constBegin() + bar)->value,
+                     (expected.at(i).volume->constBegin() + bar)->value);
+        }
+    }
+}
+
+const BarPyramid::Level* level(const QVector<BarPyramid::Level>& levels, double seconds)
+{
+    for (const BarPyramid::Level& level : levels)
+    {
+        if (level.seconds == seconds)
+        {
+            return &level;
+        }
+    }
+    return nullptr;
+}
+} // namespace
+
+class TestBarPyramid : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void barSeconds();
+    void weeksStartOnMonday();
+    void daysStartWithTheTradingDay();
+    void extendKeepsTheBuckets();
+    void sessionsBucketByTime();
+};
+
+void TestBarPyramid::barSeconds()
+{
+    QCOMPARE(BarPyramid::barSeconds(bars(Monday, 1, 300, 0, Hour).candles), 300.0);
+    QCOMPARE(BarPyramid::barSeconds(bars(Monday, 1, 300, 0, 300).candles), 0.0);
+}
+
+void TestBarPyramid::weeksStartOnMonday()
+{
+    //daily bars round the clock, too many for a screen, have a level of weeks only
+    const Bars daily = bars(Monday - 3 * Day, 5000, Day, 0, Day);
+    const QVector<BarPyramid::Level> levels = BarPyramid::build(daily.candles, daily.volume);
+    QCOMPARE(levels.size(), qsizetype(1));
+    const BarPyramid::Level& weeks = levels.first();
+    QCOMPARE(weeks.seconds, 7 * Day);
+    QCOMPARE(weeks.dayStart, 0.0);
+    //the first week has the Friday to Sunday before the first Monday
+    QCOMPARE(weeks.candles->constBegin()->key, Monday - 7 * Day);
+    QCOMPARE(weeks.volume->constBegin()->value, 3.0);
+    for (auto week = weeks.candles->constBegin() + 1; week != weeks.candles->constEnd() - 1; ++week)
+    {
+        QCOMPARE(std::fmod(week->key - Monday, 7 * Day), 0.0);
+        const QCPFinancialData monday = *daily.candles.findBegin(week->key, false);
+        QCOMPARE(monday.key, week->key);
+        QCOMPARE(week->open, monday.open);
+    }
+    for (auto week = weeks.volume->constBegin() + 1; week != weeks.volume->constEnd() - 1; ++week)
+    {
+        QCOMPARE(week->value, 7.0);
+    }
+}
+
+void TestBarPyramid::daysStartWithTheTradingDay()
+{
+    //15 minute bars of a market trading from 23:00 to 22:00 UTC the next day, split by utc midnight, enough
+    // days for a level of weeks
+    const int dayCount = 4200;
+    const Bars bars15 = bars(Monday, dayCount, 15 * 60, 23 * Hour, 22 * Hour);
+    const QVector<BarPyramid::Level> levels = BarPyramid::build(bars15.candles, bars15.volume);
+    const BarPyramid::Level* days = level(levels, Day);
+    QVERIFY(days);
+    QCOMPARE(days->dayStart, -Hour);
+    QCOMPARE(days->candles->size(), dayCount);
+    for (int day = 0; day < days->candles->size(); day++)
+    {
+        //a bucket a session, opening with its first bar and closing with its last
+        const QCPFinancialData bucket = *(days->candles->constBegin() + day);
+        QCOMPARE(bucket.key, Monday + day * Day - Hour);
+        const QCPFinancialData first = *bars15.candles.findBegin(bucket.key, false);
+        const QCPFinancialData last = *(bars15.candles.findBegin(bucket.key + Day, false) - 1);
+        QCOMPARE(first.key, bucket.key);
+        QCOMPARE(bucket.open, first.open);
+        QCOMPARE(bucket.close, last.close);
+        QCOMPARE((days->volume->constBegin() + day)->value, 92.0);
+    }
+    //weeks of the trading days from Monday, which starts Sunday 23:00 UTC
+    const BarPyramid::Level* weeks = level(levels, 7 * Day);
+    QVERIFY(weeks);
+    QCOMPARE(weeks->candles->size(), dayCount / 7);
+    for (int week = 0; week < weeks->candles->size(); week++)
+    {
+        QCOMPARE((weeks->candles->constBegin() + week)->key, Monday - Hour + week * 7 * Day);
+        QCOMPARE((weeks->volume->constBegin() + week)->value, 7 * 92.0);
+    }
+    //the 4 hour buckets are whole hours from the day's start
+    const BarPyramid::Level* hours4 = level(levels, 4 * Hour);
+    QVERIFY(hours4);
+    QCOMPARE(std::fmod(hours4->candles->constBegin()->key - (Monday - Hour), 4 * Hour), 0.0);
+}
+
+void TestBarPyramid::extendKeepsTheBuckets()
+{
+    //the bars split in the middle of a trading day, the rest merged into the pyramid of the first half
+    const Bars all = bars(Monday, 800, 15 * 60, 23 * Hour, 22 * Hour);
+    const double split = Monday + 400 * Day + 12 * Hour;
+    QCPFinancialDataContainer candles;
+    QCPBarsDataContainer volume;
+    candles.set(QVector<QCPFinancialData>(all.candles.constBegin(), all.candles.findBegin(split, false)), true);
+    volume.set(QVector<QCPBarsData>(all.volume.constBegin(), all.volume.findBegin(split, false)), true);
+    QVector<BarPyramid::Level> levels = BarPyramid::build(candles, volume);
+    QVERIFY(!levels.isEmpty());
+    candles.add(QVector<QCPFinancialData>(all.candles.findBegin(split, false), all.candles.constEnd()), true);
+    volume.add(QVector<QCPBarsData>(all.volume.findBegin(split, false), all.volume.constEnd()), true);
+    BarPyramid::extend(levels, candles, volume);
+    compareLevels(levels, BarPyramid::build(all.candles, all.volume));
+}
+
+void TestBarPyramid::sessionsBucketByTime()
+{
+    //the 23:00 to 22:00 UTC trading days in session coordinates, which leave out the hour between two days, are
+    // bucketed like their times, the buckets keyed by the coordinates of their first bars
+    const int dayCount = 4200;
+    const Bars timed = bars(Monday, dayCount, 15 * 60, 23 * Hour, 22 * Hour);
+    QVector<double> times;
+    for (auto bar = timed.candles.constBegin(); bar != timed.candles.constEnd(); ++bar)
+    {
+        times.append(bar->key);
+    }
+    SessionCalendar sessions;
+    sessions.extend(times);
+    QCOMPARE(sessions.size(), dayCount);
+    const Bars coords = inSessions(timed, sessions);
+    const QVector<BarPyramid::Level> expected = BarPyramid::build(timed.candles, timed.volume);
+    QVERIFY(level(expected, 7 * Day));
+    compareLevels(BarPyramid::build(coords.candles, coords.volume, &sessions), expected, &sessions);
+
+    //extended from the middle of a trading day
+    const double split = sessions.toCoord(Monday + 2000 * Day + 12 * Hour);
+    QCPFinancialDataContainer candles;
+    QCPBarsDataContainer volume;
+    candles.set(QVector<QCPFinancialData>(coords.candles.constBegin(), coords.candles.findBegin(split, false)), true);
+    volume.set(QVector<QCPBarsData>(coords.volume.constBegin(), coords.volume.findBegin(split, false)), true);
+    QVector<BarPyramid::Level> levels = BarPyramid::build(candles, volume, &sessions);
+    candles.add(QVector<QCPFinancialData>(coords.candles.findBegin(split, false), coords.candles.constEnd()), true);
+    volume.add(QVector<QCPBarsData>(coords.volume.findBegin(split, false), coords.volume.constEnd()), true);
+    BarPyramid::extend(levels, candles, volume, &sessions);
+    compareLevels(levels, expected, &sessions);
+}
+
+QTEST_GUILESS_MAIN(TestBarPyramid)
+#include "tst_barpyramid.moc"
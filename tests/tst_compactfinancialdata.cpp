@@ -0,0 +1,130 @@
+#include "qcustomplot.h"
+
+#include <QtTest>
+
+namespace
+{
+QVector<QCPFinancialData> minuteBars(int first, int count)
+{
+    QVector<QCPFinancialData> bars;
+    for (int bar = first; bar < first + count; bar++)
+    {
+        const double price = 100 + bar % 50;
+        bars.append(QCPFinancialData(bar * 60.0, price, price + 1, price - 1, price + 0.5));
+    }
+    return bars;
+}
+
+//the value range of the container's bars and whether every bar is found by its key, through the indexes a view
+// keeps, against a container holding copies of the bars
+void compareWithHeld(QCPFinancialDataContainer& viewed)
+{
+    QCPFinancialDataContainer held;
+    held.set(QVector<QCPFinancialData>(viewed.constBegin(), viewed.constEnd()), true);
+    bool found;
+    QCOMPARE(viewed.valueRange(found).lower, held.valueRange(found).lower);
+    QCOMPARE(viewed.valueRange(found).upper, held.valueRange(found).upper);
+    const QCPRange keys(300, 900);
+    QCOMPARE(viewed.valueRange(found, QCP::sdBoth, keys).upper, held.valueRange(found, QCP::sdBoth, keys).upper);
+    for (auto bar = held.constBegin(); bar != held.constEnd(); ++bar)
+    {
+        QCOMPARE(int(viewed.findBegin(bar->key, false) - viewed.constBegin()), int(bar - held.constBegin()));
+    }
+}
+} // namespace
+
+class TestCompactFinancialData : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void viewAppended();
+    void viewMerged();
+    void viewSignDomains();
+};
+
+void TestCompactFinancialData::viewAppended()
+{
+    QCPCompactFinancialData compact;
+    compact.set(minuteBars(0, 1000), true);
+    QCPFinancialDataContainer container;
+    compact.view(container);
+    compareWithHeld(container);
+
+    QVector<QCPFinancialData> appended = minuteBars(1000, 500);
+    appended[100].high = 1000;
+    compact.add(appended, true);
+    compact.view(container);
+    QCOMPARE(container.size(), 1500);
+    compareWithHeld(container);
+}
+
+void TestCompactFinancialData::viewMerged()
+{
+    QCPCompactFinancialData compact;
+    compact.set(minuteBars(0, 1000), true);
+    QCPFinancialDataContainer container;
+    compact.view(container);
+    compareWithHeld(container);
+
+    //bars between the viewed ones rewrite the columns, the indexes of the view before are dropped
+    QVector<QCPFinancialData> merged = minuteBars(0, 3);
+    for (QCPFinancialData& bar : merged)
+    {
+        bar.key += 30 * 60 + 30;
+        bar.high = 1000;
+        bar.low = 1;
+    }
+    compact.add(merged, true);
+    compact.view(container);
+    QCOMPARE(container.size(), 1003);
+    bool found;
+    QCOMPARE(container.valueRange(found).upper, 1000.0);
+    QCOMPARE(container.valueRange(found).lower, 1.0);
+    compareWithHeld(container);
+}
+
+void TestCompactFinancialData::viewSignDomains()
+{
+    //prices crossing zero, with zero, NaN and infinite lows and highs the sign domains must skip like held bars do
+    QVector<QCPFinancialData> bars;
+    for (int bar = 0; bar < 1000; bar++)
+    {
+        const double price = (bar % 41 - 20) * 0.5;
+        QCPFinancialData point(bar * 60.0, price, price + 1, price - 1, price);
+        if (bar % 97 == 5)
+        {
+            point.low = bar % 2 ? -qInf() : qQNaN();
+        }
+        if (bar % 89 == 7)
+        {
+            point.high = bar % 2 ? qInf() : qQNaN();
+        }
+        bars.append(point);
+    }
+    QCPCompactFinancialData compact;
+    compact.set(bars, true);
+    QCPFinancialDataContainer viewed;
+    compact.view(viewed);
+    QCPFinancialDataContainer held;
+    held.set(bars, true);
+    for (QCP::SignDomain signDomain : {QCP::sdNegative, QCP::sdPositive})
+    {
+        for (const QCPRange& keys : {QCPRange(), QCPRange(300, 900), QCPRange(120, 120)})
+        {
+            bool viewedFound = false;
+            bool heldFound = false;
+            const QCPRange viewedRange = viewed.valueRange(viewedFound, signDomain, keys);
+            const QCPRange heldRange = held.valueRange(heldFound, signDomain, keys);
+            QCOMPARE(viewedFound, heldFound);
+            if (viewedFound)
+            {
+                QCOMPARE(viewedRange.lower, heldRange.lower);
+                QCOMPARE(viewedRange.upper, heldRange.upper);
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestCompactFinancialData)
+#include "tst_compactfinancialdata.moc"
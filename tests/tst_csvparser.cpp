@@ -0,0 +1,188 @@
+#include "csvparser.h"
+
+#include <QtTest>
+
+#include <cstdio>
+#include <ctime>
+
+#ifdef _WIN32
+#define timegm _mkgmtime
+#endif
+
+namespace
+{
+bool parse(const QByteArray& field, qint64& seconds, qint32& nanoseconds)
+{
+    return CsvParser::parseTimestamp(field.constData(), field.constData() + field.size(), seconds, nanoseconds);
+}
+
+// the epoch seconds of a utc time by the c library, which normalizes a second of 60 into the next minute
+qint64 utc(int year, int month, int day, int hour = 0, int minute = 0, int second = 0)
+{
+    std::tm time = {};
+    time.tm_year = year - 1900;
+    time.tm_mon = month - 1;
+    time.tm_mday = day;
+    time.tm_hour = hour;
+    time.tm_min = minute;
+    time.tm_sec = second;
+    return qint64(timegm(&time));
+}
+
+bool isLeapYear(int year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+int daysInMonth(int year, int month)
+{
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return month == 2 && isLeapYear(year) ? 29 : days[month - 1];
+}
+} // namespace
+
+class TestCsvParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void everyDay();
+    void timeFormats();
+    void fractions();
+    void offsets();
+    void utcEdges();
+    void leapDays();
+    void invalid();
+};
+
+void TestCsvParser::everyDay()
+{
+    //past both ends of the month table the parser looks dates up in, and the arithmetic it falls back to
+    qint64 seconds;
+    qint32 nanoseconds;
+    char field[32];
+    for (int year = 1800; year <= 2200; year++)
+    {
+        for (int month = 1; month <= 12; month++)
+        {
+            for (int day = 1; day <= daysInMonth(year, month); day++)
+            {
+                const int hour = (year + day) % 24;
+                const int minute = (month * 7 + day) % 60;
+                const int second = (year + month + day) % 60;
+                std::snprintf(field, sizeof(field), "%04d-%02d-%02d", year, month, day);
+                QVERIFY2(parse(field, seconds, nanoseconds), field);
+                QCOMPARE(seconds, utc(year, month, day));
+                std::snprintf(field, sizeof(field), "%04d/%02d/%02d %02d:%02d:%02d", year, month, day, hour, minute,
+                              second);
+                QVERIFY2(parse(field, seconds, nanoseconds), field);
+                QCOMPARE(seconds, utc(year, month, day, hour, minute, second));
+                QCOMPARE(nanoseconds, qint32(0));
+            }
+        }
+    }
+}
+
+void TestCsvParser::timeFormats()
+{
+    qint64 seconds;
+    qint32 nanoseconds;
+    const qint64 expected = utc(2024, 3, 15, 9, 30, 0);
+    for (const char* field : {"2024-03-15T09:30:00", "2024-03-15 09:30:00", "2024-03-15T09:30", "2024/03/15 09:30",
+                              "2024-03-15T09:30:00Z", "2024-03-15T09:30z", "2024-03-15 09:30:00+00:00"})
+    {
+        QVERIFY2(parse(field, seconds, nanoseconds), field);
+        QCOMPARE(seconds, expected);
+    }
+    QVERIFY(parse("2024-03-15T09:30:07", seconds, nanoseconds));
+    QCOMPARE(seconds, expected + 7);
+}
+
+void TestCsvParser::fractions()
+{
+    qint64 seconds;
+    qint32 nanoseconds;
+    const qint64 expected = utc(2024, 3, 15, 9, 30, 1);
+    QVERIFY(parse("2024-03-15T09:30:01.5", seconds, nanoseconds));
+    QCOMPARE(seconds, expected);
+    QCOMPARE(nanoseconds, qint32(500000000));
+    QVERIFY(parse("2024-03-15T09:30:01,000250Z", seconds, nanoseconds));
+    QCOMPARE(nanoseconds, qint32(250000));
+    QVERIFY(parse("2024-03-15T09:30:01.123456789", seconds, nanoseconds));
+    QCOMPARE(nanoseconds, qint32(123456789));
+    //digits past nanoseconds are dropped, not rounded
+    QVERIFY(parse("2024-03-15T09:30:01.9999999999+01:00", seconds, nanoseconds));
+    QCOMPARE(seconds, expected - 3600);
+    QCOMPARE(nanoseconds, qint32(999999999));
+}
+
+void TestCsvParser::offsets()
+{
+    qint64 seconds;
+    qint32 nanoseconds;
+    //the local time minus the offset, across a day and a month boundary
+    QVERIFY(parse("2024-03-01T02:00:00+05:30", seconds, nanoseconds));
+    QCOMPARE(seconds, utc(2024, 2, 29, 20, 30));
+    QVERIFY(parse("2023-12-31T20:15-0800", seconds, nanoseconds));
+    QCOMPARE(seconds, utc(2024, 1, 1, 4, 15));
+    QVERIFY(parse("2024-06-30 23:00:00+02", seconds, nanoseconds));
+    QCOMPARE(seconds, utc(2024, 6, 30, 21));
+    QVERIFY(parse("2024-06-30 23:00:00-00:45", seconds, nanoseconds));
+    QCOMPARE(seconds, utc(2024, 6, 30, 23, 45));
+}
+
+void TestCsvParser::utcEdges()
+{
+    qint64 seconds;
+    qint32 nanoseconds;
+    QVERIFY(parse("1970-01-01T00:00:00Z", seconds, nanoseconds));
+    QCOMPARE(seconds, qint64(0));
+    QVERIFY(parse("1969-12-31T23:59:59", seconds, nanoseconds));
+    QCOMPARE(seconds, qint64(-1));
+    QVERIFY(parse("1970-01-01T00:30:00+01:00", seconds, nanoseconds));
+    QCOMPARE(seconds, qint64(-1800));
+    //past what a signed 32 bit time_t holds
+    QVERIFY(parse("2038-01-19T03:14:08Z", seconds, nanoseconds));
+    QCOMPARE(seconds, qint64(2147483648));
+    QCOMPARE(seconds, utc(2038, 1, 19, 3, 14, 8));
+    //a leap second is the first second of the next minute
+    QVERIFY(parse("2016-12-31T23:59:60Z", seconds, nanoseconds));
+    QCOMPARE(seconds, utc(2017, 1, 1));
+    QVERIFY(parse("2099-12-31T23:59:59", seconds, nanoseconds));
+    QCOMPARE(seconds, utc(2099, 12, 31, 23, 59, 59));
+    QVERIFY(parse("2100-01-01", seconds, nanoseconds));
+    QCOMPARE(seconds, utc(2100, 1, 1));
+}
+
+void TestCsvParser::leapDays()
+{
+    qint64 seconds;
+    qint32 nanoseconds;
+    for (const char* field : {"2024-02-29", "2000-02-29", "1600-02-29", "2400-02-29"})
+    {
+        QVERIFY2(parse(field, seconds, nanoseconds), field);
+    }
+    QVERIFY(parse("2000-02-29T12:00", seconds, nanoseconds));
+    QCOMPARE(seconds, utc(2000, 2, 29, 12));
+    for (const char* field : {"2023-02-29", "1900-02-29", "2100-02-29", "2024-02-30"})
+    {
+        QVERIFY2(!parse(field, seconds, nanoseconds), field);
+    }
+}
+
+void TestCsvParser::invalid()
+{
+    qint64 seconds;
+    qint32 nanoseconds;
+    for (const char* field :
+         {"20240315", "2024-3-15", "2024-03/15", "2024-13-01", "2024-00-10", "2024-01-00", "2024-04-31",
+          "2024-01-01X", "2024-01-01T", "2024-01-01T24:00", "2024-01-01T12:60", "2024-01-01T12:3",
+          "2024-01-01T12:30:61", "2024-01-01T12:30:00.", "2024-01-01T12:30+5", "2024-01-01T12:30+05:3",
+          "2024-01-01T12:30+24:00", "2024-01-01T12:30ZZ", "2024-01-01 12:30:00 UTC", "abcd-01-01"})
+    {
+        QVERIFY2(!parse(field, seconds, nanoseconds), field);
+    }
+}
+
+QTEST_MAIN(TestCsvParser)
+#include "tst_csvparser.moc"
@@ -0,0 +1,580 @@
+#include "qcustomplot.h"
+
+#include <QtTest>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+
+namespace
+{
+const double Stride = 60;
+
+bool lessKey(const QCPGraphData& a, const QCPGraphData& b)
+{
+    return a.key < b.key;
+}
+
+//the keys to search for around ascending keys: on them, halfway to the next, just beside them and beyond both ends
+QVector<double> probeKeys(const QVector<double>& keys)
+{
+    QVector<double> probes;
+    for (int i = 0; i < keys.size(); i++)
+    {
+        probes << keys.at(i) << keys.at(i) - 1e-7 << keys.at(i) + 1e-7;
+        if (i + 1 < keys.size())
+        {
+            probes << (keys.at(i) + keys.at(i + 1)) / 2;
+        }
+    }
+    if (!keys.isEmpty())
+    {
+        probes << keys.first() - 1000 * Stride << keys.last() + 1000 * Stride;
+    }
+    return probes;
+}
+
+QVector<double> keysOf(const QVector<QCPGraphData>& points)
+{
+    QVector<double> keys;
+    for (const QCPGraphData& point : points)
+    {
+        keys.append(point.key);
+    }
+    return keys;
+}
+
+//points at keys, with values that only repeat every few points
+QVector<QCPGraphData> pointsAt(const QVector<double>& keys)
+{
+    QVector<QCPGraphData> points;
+    for (int i = 0; i < keys.size(); i++)
+    {
+        points.append(QCPGraphData(keys.at(i), i % 97));
+    }
+    return points;
+}
+
+//count ascending keys a stride apart, computed from their step like timestamps of bars, with a gap of 17 strides
+// after every gapEvery keys and every repeatEvery-th key twice
+QVector<double> gridKeys(int count, double stride, int gapEvery, int repeatEvery = 0)
+{
+    QVector<double> keys;
+    qint64 step = 0;
+    while (keys.size() < count)
+    {
+        keys.append(step * stride);
+        if (repeatEvery > 0 && keys.size() % repeatEvery == 0 && keys.size() < count)
+        {
+            keys.append(keys.last());
+        }
+        step += gapEvery > 0 && keys.size() % gapEvery == 0 ? 17 : 1;
+    }
+    return keys;
+}
+
+//checks the grid located the probed keys where lower_bound finds them among keys, or at most tolerance points off
+void compareLocate(const QCPKeyGrid& grid, const QVector<double>& keys, int tolerance = 0)
+{
+    QCOMPARE(grid.size(), int(keys.size()));
+    for (double key : probeKeys(keys))
+    {
+        const int expected = int(std::lower_bound(keys.begin(), keys.end(), key) - keys.begin());
+        const int located = grid.locate(key);
+        QVERIFY2(located >= 0 && qAbs(located - expected) <= tolerance,
+                 qPrintable(QString("key %1 located at %2, not %3").arg(key).arg(located).arg(expected)));
+    }
+}
+
+//a column sharing a copy of values
+template <class T>
+QCPDataColumn column(QCPDataColumn::Type type, const QVector<T>& values)
+{
+    const auto shared = std::make_shared<QVector<T>>(values);
+    return QCPDataColumn(type, std::shared_ptr<const void>(shared, shared->constData()));
+}
+
+//the finite value range of the reference points with keys in keys, the whole reference for an empty range
+QCPRange referenceRange(const QVector<QCPGraphData>& reference, const QCPRange& keys, bool& found)
+{
+    QCPRange range; // not constructed from the bounds, which the constructor would swap
+    range.lower = std::numeric_limits<double>::infinity();
+    range.upper = -std::numeric_limits<double>::infinity();
+    for (const QCPGraphData& point : reference)
+    {
+        if ((keys == QCPRange() || (point.key >= keys.lower && point.key <= keys.upper)) && std::isfinite(point.value))
+        {
+            range.lower = qMin(range.lower, point.value);
+            range.upper = qMax(range.upper, point.value);
+        }
+    }
+    found = range.lower <= range.upper;
+    return range;
+}
+
+//the points of container, the bounds of the probed keys against lower_bound and upper_bound, and the value ranges
+// of all points and of runs of them against the reference points they must equal
+void compareWithReference(QCPGraphDataContainer& container, const QVector<QCPGraphData>& reference)
+{
+    QCOMPARE(container.size(), int(reference.size()));
+    for (int i = 0; i < reference.size(); i++)
+    {
+        const QCPGraphData point = *(container.constBegin() + i);
+        QCOMPARE(point.key, reference.at(i).key);
+        QVERIFY(point.value == reference.at(i).value || (qIsNaN(point.value) && qIsNaN(reference.at(i).value)));
+    }
+    for (double key : probeKeys(keysOf(reference)))
+    {
+        const QCPGraphData probe(key, 0);
+        const int lower = int(std::lower_bound(reference.begin(), reference.end(), probe, lessKey) - reference.begin());
+        const int upper = int(std::upper_bound(reference.begin(), reference.end(), probe, lessKey) - reference.begin());
+        QCOMPARE(int(container.findBegin(key, false) - container.constBegin()), lower);
+        QCOMPARE(int(container.findEnd(key, false) - container.constBegin()), upper);
+    }
+    QVector<QCPRange> keyRanges{QCPRange()};
+    for (int length : {1, 7, 130, 500})
+    {
+        for (int first = 0; first + length <= reference.size(); first += qMax(1, int(reference.size()) / 5))
+        {
+            keyRanges << QCPRange(reference.at(first).key, reference.at(first + length - 1).key);
+        }
+    }
+    for (const QCPRange& keys : keyRanges)
+    {
+        bool found = false;
+        bool expectedFound = false;
+        const QCPRange range = container.valueRange(found, QCP::sdBoth, keys);
+        const QCPRange expected = referenceRange(reference, keys, expectedFound);
+        QCOMPARE(found, expectedFound);
+        if (found)
+        {
+            QCOMPARE(range.lower, expected.lower);
+            QCOMPARE(range.upper, expected.upper);
+        }
+    }
+}
+
+//a point a stride after the last one, with a value of a random walk and now and then a spike or a NaN
+class Points
+{
+public:
+    QCPGraphData next()
+    {
+        mValue += int(mRandom() % 21) - 10;
+        const int kind = int(mRandom() % 50);
+        const double value = kind == 0 ? mValue + 1000 : kind == 1 ? mValue - 1000 : kind == 2 ? qQNaN() : mValue;
+        return QCPGraphData(mKey++ * Stride, value);
+    }
+    QVector<QCPGraphData> next(int count)
+    {
+        QVector<QCPGraphData> points;
+        for (int i = 0; i < count; i++)
+        {
+            points.append(next());
+        }
+        return points;
+    }
+
+private:
+    std::mt19937 mRandom{7};
+    qint64 mKey = 0;
+    double mValue = 0;
+};
+
+//a container telling whether it holds its points in the ring buffer of a bounded container, and the key grid its
+// bounds are located with
+class Container : public QCPGraphDataContainer
+{
+public:
+    bool isRing() const { return mRing; }
+    const QCPKeyGrid& keyGrid() const { return mKeyGrid; }
+};
+
+//appends points to the reference and keeps its newest capacity ones
+void appendBounded(QVector<QCPGraphData>& reference, const QVector<QCPGraphData>& points, int capacity)
+{
+    reference += points;
+    if (reference.size() > capacity)
+    {
+        reference.remove(0, reference.size() - capacity);
+    }
+}
+} // namespace
+
+class TestDataContainer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void ringAppendsPastTheWrap();
+    void ringAddsBatchesPastTheWrap();
+    void ringValueRangeAfterEvictions();
+    void ringRemoveBefore();
+    void ringOutOfOrderAdd();
+    void capacityOfHeldPoints();
+    void keyGridLocates();
+    void keyGridEvictsAndTruncates();
+    void keyGridFractionalStride();
+    void keyGridIrregular();
+    void boundWithDuplicates();
+    void boundOfViews();
+    void boundOfBoundedContainers();
+};
+
+void TestDataContainer::ringAppendsPastTheWrap()
+{
+    //three and a half times around the ring, compared after every point so each start of the ring is searched
+    const int capacity = 100;
+    Container container;
+    container.setCapacity(capacity);
+    QVector<QCPGraphData> reference;
+    Points points;
+    for (int i = 0; i < 350; i++)
+    {
+        const QCPGraphData point = points.next();
+        container.add(point);
+        appendBounded(reference, {point}, capacity);
+        compareWithReference(container, reference);
+    }
+    QVERIFY(container.isRing());
+    QCOMPARE(container.capacity(), capacity);
+}
+
+void TestDataContainer::ringAddsBatchesPastTheWrap()
+{
+    //batches that don't divide the capacity, and one larger than it of which only the newest points stay
+    const int capacity = 256;
+    Container container;
+    container.setCapacity(capacity);
+    QVector<QCPGraphData> reference;
+    Points points;
+    for (int batch : {37, 37, 200, 1, 63, 600, 99, 37, 256, 13})
+    {
+        const QVector<QCPGraphData> added = points.next(batch);
+        container.add(added, true);
+        appendBounded(reference, added, capacity);
+        compareWithReference(container, reference);
+    }
+}
+
+void TestDataContainer::ringValueRangeAfterEvictions()
+{
+    //the spikes of evicted points must leave the range index, over whole blocks and the points beside them
+    const int capacity = 1000;
+    Container container;
+    container.setCapacity(capacity);
+    QVector<QCPGraphData> reference;
+    Points points;
+    for (int i = 0; i < 5000; i++)
+    {
+        const QCPGraphData point = points.next();
+        container.add(point);
+        appendBounded(reference, {point}, capacity);
+        if (i % 97 == 0)
+        {
+            bool found = false;
+            bool expectedFound = false;
+            QCOMPARE(container.valueRange(found).upper, referenceRange(reference, QCPRange(), expectedFound).upper);
+            QCOMPARE(container.valueRange(found).lower, referenceRange(reference, QCPRange(), expectedFound).lower);
+        }
+    }
+    compareWithReference(container, reference);
+}
+
+void TestDataContainer::ringRemoveBefore()
+{
+    //removeBefore advances the start of the ring, the points added after it fill the ring up again
+    const int capacity = 300;
+    Container container;
+    container.setCapacity(capacity);
+    QVector<QCPGraphData> reference;
+    Points points;
+    const QVector<QCPGraphData> added = points.next(450);
+    container.add(added, true);
+    appendBounded(reference, added, capacity);
+    bool found = false;
+    container.valueRange(found); // builds the range index the removals then evict from
+    for (int removed : {1, 64, 100, 0})
+    {
+        const double key = reference.at(removed).key;
+        container.removeBefore(key);
+        reference.remove(0, removed);
+        compareWithReference(container, reference);
+        const QVector<QCPGraphData> more = points.next(removed + 30);
+        container.add(more, true);
+        appendBounded(reference, more, capacity);
+        compareWithReference(container, reference);
+    }
+    container.removeBefore(reference.last().key + 1);
+    QVERIFY(container.isEmpty());
+    const QVector<QCPGraphData> refill = points.next(400);
+    container.add(refill, true);
+    reference = refill.mid(100);
+    compareWithReference(container, reference);
+}
+
+void TestDataContainer::ringOutOfOrderAdd()
+{
+    //a point before the newest lays the points out in order, the oldest beyond the capacity are dropped, and the
+    // points appended after it go into the ring again
+    const int capacity = 200;
+    Container container;
+    container.setCapacity(capacity);
+    QVector<QCPGraphData> reference;
+    Points points;
+    QVector<QCPGraphData> added = points.next(333);
+    container.add(added, true);
+    appendBounded(reference, added, capacity);
+
+    const QCPGraphData inserted(reference.at(150).key + Stride / 3, 5000);
+    container.add(inserted);
+    QVERIFY(container.isRing());
+    reference.insert(std::upper_bound(reference.begin(), reference.end(), inserted, lessKey), inserted);
+    reference.remove(0, 1);
+    compareWithReference(container, reference);
+
+    for (int i = 0; i < 450; i++)
+    {
+        const QCPGraphData point = points.next();
+        container.add(point);
+        appendBounded(reference, {point}, capacity);
+        if (i % 50 == 0)
+        {
+            compareWithReference(container, reference);
+        }
+    }
+    compareWithReference(container, reference);
+    QCOMPARE(container.size(), capacity);
+
+    //an unsorted batch reaching into the ring, then sorted appends again
+    QVector<QCPGraphData> unsorted = points.next(20);
+    unsorted[3].key = reference.at(10).key + 1;
+    unsorted[11].key = reference.at(120).key + 1;
+    std::reverse(unsorted.begin(), unsorted.end());
+    container.add(unsorted, false);
+    QVERIFY(container.isRing());
+    reference += unsorted;
+    std::stable_sort(reference.begin(), reference.end(), lessKey);
+    reference.remove(0, reference.size() - capacity);
+    compareWithReference(container, reference);
+    added = points.next(150);
+    container.add(added, true);
+    appendBounded(reference, added, capacity);
+    compareWithReference(container, reference);
+
+    //removing the newest points lays them out in order until the next point is added
+    container.removeAfter(reference.at(150).key);
+    QVERIFY(!container.isRing());
+    reference.remove(151, reference.size() - 151);
+    compareWithReference(container, reference);
+    added = points.next(120);
+    container.add(added, true);
+    QVERIFY(container.isRing());
+    appendBounded(reference, added, capacity);
+    compareWithReference(container, reference);
+}
+
+void TestDataContainer::capacityOfHeldPoints()
+{
+    //setting a capacity keeps the newest points held before, removing it keeps the ring's points
+    Container container;
+    Points points;
+    QVector<QCPGraphData> reference = points.next(500);
+    container.set(reference, true);
+    container.setCapacity(128);
+    reference.remove(0, 500 - 128);
+    compareWithReference(container, reference);
+    const QVector<QCPGraphData> added = points.next(77);
+    container.add(added, true);
+    appendBounded(reference, added, 128);
+    compareWithReference(container, reference);
+
+    container.setCapacity(0);
+    const QVector<QCPGraphData> unbounded = points.next(300);
+    container.add(unbounded, true);
+    reference += unbounded;
+    compareWithReference(container, reference);
+}
+
+void TestDataContainer::keyGridLocates()
+{
+    //runs of keys with gaps, located exactly whether the grid is updated at once or as the keys are appended
+    const QVector<double> keys = gridKeys(3000, Stride, 100);
+    auto key = [&keys](int index) { return keys.at(index); };
+    QCPKeyGrid grid;
+    grid.update(int(keys.size()), key);
+    QVERIFY(grid.isRegular());
+    QCOMPARE(grid.stride(), Stride);
+    compareLocate(grid, keys);
+
+    //the stride is taken once there are two keys
+    QCPKeyGrid appended;
+    appended.update(1, key);
+    QCOMPARE(appended.size(), 0);
+    for (int size : {2, 150, 151, 1999, 3000})
+    {
+        appended.update(size, key);
+        compareLocate(appended, keys.mid(0, size));
+    }
+}
+
+void TestDataContainer::keyGridEvictsAndTruncates()
+{
+    QVector<double> keys = gridKeys(3000, Stride, 100);
+    int offset = 0;
+    auto key = [&keys, &offset](int index) { return keys.at(offset + index); };
+    QCPKeyGrid grid;
+    grid.update(int(keys.size()), key);
+
+    //evicted in steps landing inside runs, on their first keys and past several of them
+    for (int count : {1, 99, 150, 1000})
+    {
+        grid.evict(count);
+        offset += count;
+        compareLocate(grid, keys.mid(offset));
+    }
+
+    //the newest points removed and others appended in their place, starting a run of their own
+    grid.truncate(grid.size() - 500);
+    keys.resize(keys.size() - 500);
+    compareLocate(grid, keys.mid(offset));
+    const double last = keys.last();
+    for (int i = 1; i <= 700; i++)
+    {
+        keys.append(last + 5 * Stride + i * Stride);
+    }
+    grid.update(int(keys.size()) - offset, key);
+    compareLocate(grid, keys.mid(offset));
+
+    //all points evicted, the next ones start over
+    grid.evict(grid.size());
+    offset = int(keys.size());
+    QCOMPARE(grid.size(), 0);
+    QCOMPARE(grid.locate(keys.last()), -1);
+    keys += gridKeys(400, Stride, 0);
+    grid.update(400, key);
+    compareLocate(grid, keys.mid(offset));
+}
+
+void TestDataContainer::keyGridFractionalStride()
+{
+    //keys a tenth apart are off the grid by their rounding, the grid may miss by a point and bound settles it
+    const QVector<double> keys = gridKeys(5000, 0.1, 300);
+    QCPKeyGrid grid;
+    grid.update(int(keys.size()), [&keys](int index) { return keys.at(index); });
+    QVERIFY(grid.isRegular());
+    QVERIFY(qAbs(grid.stride() - 0.1) < 1e-9);
+    compareLocate(grid, keys, 1);
+
+    Container container;
+    container.set(pointsAt(keys), true);
+    QCOMPARE(container.keyGrid().size(), container.size());
+    compareWithReference(container, pointsAt(keys));
+}
+
+void TestDataContainer::keyGridIrregular()
+{
+    //keys without a grid aren't located, bound searches them
+    std::mt19937 random(3);
+    QVector<double> keys;
+    double key = 0;
+    for (int i = 0; i < 2000; i++)
+    {
+        key += 1 + random() % 1000;
+        keys.append(key);
+    }
+    QCPKeyGrid grid;
+    grid.update(int(keys.size()), [&keys](int index) { return keys.at(index); });
+    QVERIFY(!grid.isRegular());
+    QCOMPARE(grid.locate(keys.at(10)), -1);
+
+    Container container;
+    container.set(pointsAt(keys), true);
+    QVERIFY(!container.keyGrid().isRegular());
+    compareWithReference(container, pointsAt(keys));
+}
+
+void TestDataContainer::boundWithDuplicates()
+{
+    //a repeated key starts a run, lower_bound and upper_bound differ there and bound settles both
+    const QVector<double> keys = gridKeys(3000, Stride, 250, 100);
+    QCPKeyGrid grid;
+    grid.update(int(keys.size()), [&keys](int index) { return keys.at(index); });
+    compareLocate(grid, keys, 1);
+
+    Container container;
+    container.set(pointsAt(keys), true);
+    QVERIFY(container.keyGrid().isRegular());
+    QCOMPARE(container.keyGrid().size(), container.size());
+    compareWithReference(container, pointsAt(keys));
+
+    //a single key has no stride, nothing is located on a grid
+    Container same;
+    same.set(pointsAt(QVector<double>(500, 42.0)), true);
+    QCOMPARE(same.keyGrid().size(), 0);
+    compareWithReference(same, pointsAt(QVector<double>(500, 42.0)));
+}
+
+void TestDataContainer::boundOfViews()
+{
+    //float keys with gaps and repeats, and integer timestamps, of which a view reads just the key column
+    const QVector<double> keys = gridKeys(4000, Stride, 150, 90);
+    QVector<double> values;
+    for (int i = 0; i < keys.size(); i++)
+    {
+        values.append(i % 97);
+    }
+    Container container;
+    const QVector<QCPDataColumn> columns{
+        column(QCPDataColumn::ctFloat64, keys), column(QCPDataColumn::ctFloat64, values)};
+    container.setView(columns, 2500);
+    QVERIFY(container.isView());
+    compareWithReference(container, pointsAt(keys.mid(0, 2500)));
+    container.setView(columns, int(keys.size()));
+    QCOMPARE(container.keyGrid().size(), container.size());
+    compareWithReference(container, pointsAt(keys));
+
+    QVector<qint64> timestamps;
+    for (double key : keys)
+    {
+        timestamps.append(1700000000 + qint64(key));
+    }
+    const QVector<QCPDataColumn> timestampColumns{
+        column(QCPDataColumn::ctInt64, timestamps), column(QCPDataColumn::ctFloat64, values)};
+    container.setView(timestampColumns, int(keys.size()), false);
+    QVector<QCPGraphData> reference = pointsAt(keys);
+    for (QCPGraphData& point : reference)
+    {
+        point.key += 1700000000;
+    }
+    QCOMPARE(container.keyGrid().size(), container.size());
+    compareWithReference(container, reference);
+}
+
+void TestDataContainer::boundOfBoundedContainers()
+{
+    //the key grid follows the evictions of the ring, across gaps and repeated keys
+    const int capacity = 500;
+    const QVector<double> keys = gridKeys(4000, Stride, 130, 70);
+    Container container;
+    container.setCapacity(capacity);
+    QVector<QCPGraphData> reference;
+    const QVector<QCPGraphData> points = pointsAt(keys);
+    for (int first = 0; first < points.size(); first += 173)
+    {
+        const QVector<QCPGraphData> added = points.mid(first, 173);
+        container.add(added, true);
+        appendBounded(reference, added, capacity);
+        QVERIFY(container.isRing());
+        QCOMPARE(container.keyGrid().size(), container.size());
+        compareWithReference(container, reference);
+    }
+    const QCPGraphData removed = reference.at(200);
+    container.removeBefore(removed.key);
+    reference.erase(reference.begin(), std::lower_bound(reference.begin(), reference.end(), removed, lessKey));
+    QCOMPARE(container.keyGrid().size(), container.size());
+    compareWithReference(container, reference);
+}
+
+QTEST_GUILESS_MAIN(TestDataContainer)
+#include "tst_datacontainer.moc"
@@ -0,0 +1,142 @@
+#include "dataset.h"
+
+#include <QtTest>
+
+namespace
+{
+//a file of a dataset: its timestamps and a column of values
+CsvTable table(const QVector<qint64>& timestamps, const QString& valueKey, const QVector<double>& values)
+{
+    CsvTable table;
+    table.header = QStringList{"timestamp", valueKey};
+    table.keys = table.header;
+    CsvColumn timestamp(CsvColumn::Int64);
+    CsvColumn column(CsvColumn::Float64);
+    for (qsizetype row = 0; row < timestamps.size(); row++)
+    {
+        timestamp.appendValue<qint64>(timestamps.at(row));
+        column.appendValue<double>(values.at(row));
+    }
+    table.columns = {timestamp, column};
+    table.sourceBytes = timestamps.size() * 10;
+    return table;
+}
+
+CsvTable table(const QVector<qint64>& timestamps, const QVector<double>& values)
+{
+    return table(timestamps, "close", values);
+}
+
+QVector<qint64> timestamps(const CsvTable& table)
+{
+    const CsvColumn& column = table.columns.at(table.keys.indexOf("timestamp"));
+    QVector<qint64> values;
+    for (qsizetype row = 0; row < column.size(); row++)
+    {
+        values.append(column.isValid(row) ? qint64(column.value(row)) : -1);
+    }
+    return values;
+}
+
+QVector<double> values(const CsvTable& table, const QString& key = "close")
+{
+    const CsvColumn& column = table.columns.at(table.keys.indexOf(key));
+    QVector<double> values;
+    for (qsizetype row = 0; row < column.size(); row++)
+    {
+        values.append(column.isValid(row) ? column.value(row) : -1);
+    }
+    return values;
+}
+} // namespace
+
+class TestDataset : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void concatenatesInKeyOrder();
+    void interleaved();
+    void duplicateKeys();
+    void outOfOrderRows();
+    void outOfOrderFile();
+    void missingColumns();
+    void rowsWithoutKey();
+};
+
+void TestDataset::concatenatesInKeyOrder()
+{
+    //files named out of their key order, without overlap they are only put in order
+    const CsvTable merged = Dataset::merge({table({30, 40}, {3, 4}), table({10, 20}, {1, 2}), table({50}, {5})});
+    QCOMPARE(merged.keys, QStringList({"timestamp", "close"}));
+    QCOMPARE(timestamps(merged), QVector<qint64>({10, 20, 30, 40, 50}));
+    QCOMPARE(values(merged), QVector<double>({1, 2, 3, 4, 5}));
+    QCOMPARE(merged.sourceBytes, qint64(50));
+    QCOMPARE(merged.columns.at(0).type(), CsvColumn::Int64);
+}
+
+void TestDataset::interleaved()
+{
+    const CsvTable merged =
+        Dataset::merge({table({0, 20, 40, 60}, {0, 2, 4, 6}), table({10, 30, 50, 70}, {1, 3, 5, 7})});
+    QCOMPARE(timestamps(merged), QVector<qint64>({0, 10, 20, 30, 40, 50, 60, 70}));
+    QCOMPARE(values(merged), QVector<double>({0, 1, 2, 3, 4, 5, 6, 7}));
+}
+
+void TestDataset::duplicateKeys()
+{
+    //the rows of the file starting first win, later files only add the keys it lacks
+    const CsvTable merged = Dataset::merge({table({20, 30, 40}, {-2, -3, 4}), table({0, 10, 20, 30}, {0, 1, 2, 3})});
+    QCOMPARE(timestamps(merged), QVector<qint64>({0, 10, 20, 30, 40}));
+    QCOMPARE(values(merged), QVector<double>({0, 1, 2, 3, 4}));
+
+    //of files starting on the same key the one listed first wins
+    const CsvTable sameStart = Dataset::merge({table({0, 10}, {0, 1}), table({0, 5}, {-1, 0.5})});
+    QCOMPARE(timestamps(sameStart), QVector<qint64>({0, 5, 10}));
+    QCOMPARE(values(sameStart), QVector<double>({0, 0.5, 1}));
+}
+
+void TestDataset::outOfOrderRows()
+{
+    //an unsorted file overlapping another is sorted with it
+    const CsvTable merged = Dataset::merge({table({50, 10, 30}, {5, 1, 3}), table({20, 40}, {2, 4})});
+    QCOMPARE(timestamps(merged), QVector<qint64>({10, 20, 30, 40, 50}));
+    QCOMPARE(values(merged), QVector<double>({1, 2, 3, 4, 5}));
+}
+
+void TestDataset::outOfOrderFile()
+{
+    //an unsorted file is sorted even when it overlaps no other, keeping the first of equal keys
+    const CsvTable merged = Dataset::merge({table({30, 10, 20, 10}, {3, 1, 2, -1}), table({100, 110}, {10, 11})});
+    QCOMPARE(timestamps(merged), QVector<qint64>({10, 20, 30, 100, 110}));
+    QCOMPARE(values(merged), QVector<double>({1, 2, 3, 10, 11}));
+}
+
+void TestDataset::missingColumns()
+{
+    const CsvTable merged = Dataset::merge({table({10, 20}, "close", {1, 2}), table({30}, "sma9", {3})});
+    QCOMPARE(merged.keys, QStringList({"timestamp", "close", "sma9"}));
+    QCOMPARE(merged.header, QStringList({"timestamp", "close", "sma9"}));
+    QCOMPARE(values(merged, "close"), QVector<double>({1, 2, -1}));
+    QCOMPARE(values(merged, "sma9"), QVector<double>({-1, -1, 3}));
+}
+
+void TestDataset::rowsWithoutKey()
+{
+    CsvTable first = table({10, 0, 30}, {1, 9, 3});
+    CsvTable second = table({20}, {2});
+    //an empty timestamp cell
+    QVector<quint64> words(1, 0b101);
+    first.columns[0].setValidityWords(words);
+    const CsvTable merged = Dataset::merge({first, second});
+    QCOMPARE(timestamps(merged), QVector<qint64>({10, 20, 30}));
+    QCOMPARE(values(merged), QVector<double>({1, 2, 3}));
+
+    //a table without any key has no place in the order
+    CsvTable keyless = table({0}, {9});
+    keyless.columns[0].setValidityWords(QVector<quint64>(1, 0));
+    QCOMPARE(timestamps(Dataset::merge({table({10}, {1}), keyless})), QVector<qint64>({10}));
+}
+
+QTEST_MAIN(TestDataset)
+#include "tst_dataset.moc"
@@ -0,0 +1,447 @@
+#include "qcustomplot.h"
+
+#include <QtTest>
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+//every heap allocation of the thread while counting is set: operator new in all its forms, and under glibc malloc
+// too, which Qt's containers allocate with. Elsewhere malloc isn't replaced and drawingAllocatesNothing is skipped
+namespace
+{
+thread_local bool counting = false;
+thread_local int allocations = 0;
+
+void count()
+{
+    if (counting)
+    {
+        ++allocations;
+    }
+}
+} // namespace
+
+#ifdef __GLIBC__
+extern "C"
+{
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) noexcept
+{
+    count();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t number, size_t size) noexcept
+{
+    count();
+    return __libc_calloc(number, size);
+}
+
+void* realloc(void* pointer, size_t size) noexcept
+{
+    count();
+    return __libc_realloc(pointer, size);
+}
+}
+#endif
+
+namespace
+{
+//the allocation of operator new, counted once and not again by malloc
+void* allocate(size_t size)
+{
+    count();
+#ifdef __GLIBC__
+    return __libc_malloc(size ? size : 1);
+#else
+    return std::malloc(size ? size : 1);
+#endif
+}
+
+void* allocateOrThrow(size_t size)
+{
+    if (void* pointer = allocate(size))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+//the allocation of aligned operator new, freed by the aligned operator delete below
+void* allocateAligned(size_t size, std::align_val_t alignment)
+{
+    count();
+    const size_t bytes = size ? size : 1;
+    const size_t align = qMax(size_t(alignment), sizeof(void*));
+#if defined(__GLIBC__)
+    return __libc_memalign(align, bytes);
+#elif defined(_MSC_VER)
+    return _aligned_malloc(bytes, align);
+#else
+    void* pointer = nullptr;
+    return posix_memalign(&pointer, align, bytes) == 0 ? pointer : nullptr;
+#endif
+}
+
+void* allocateAlignedOrThrow(size_t size, std::align_val_t alignment)
+{
+    if (void* pointer = allocateAligned(size, alignment))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void freeAligned(void* pointer)
+{
+#ifdef _MSC_VER
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+} // namespace
+
+void* operator new(size_t size)
+{
+    return allocateOrThrow(size);
+}
+
+void* operator new[](size_t size)
+{
+    return allocateOrThrow(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return allocateAlignedOrThrow(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return allocateAlignedOrThrow(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    freeAligned(pointer);
+}
+
+namespace
+{
+//a paint engine drawing nothing, so the allocations counted are the plottables' and not the raster engine's
+class NullPaintEngine : public QPaintEngine
+{
+public:
+    NullPaintEngine() : QPaintEngine(QPaintEngine::AllFeatures) {}
+
+    bool begin(QPaintDevice*) override { return true; }
+    bool end() override { return true; }
+    void updateState(const QPaintEngineState&) override {}
+    void drawRects(const QRect*, int) override {}
+    void drawRects(const QRectF*, int) override {}
+    void drawLines(const QLine*, int) override {}
+    void drawLines(const QLineF*, int) override {}
+    void drawEllipse(const QRectF&) override {}
+    void drawEllipse(const QRect&) override {}
+    void drawPath(const QPainterPath&) override {}
+    void drawPoints(const QPointF*, int) override {}
+    void drawPoints(const QPoint*, int) override {}
+    void drawPolygon(const QPointF*, int, PolygonDrawMode) override {}
+    void drawPolygon(const QPoint*, int, PolygonDrawMode) override {}
+    void drawPixmap(const QRectF&, const QPixmap&, const QRectF&) override {}
+    void drawTextItem(const QPointF&, const QTextItem&) override {}
+    void drawTiledPixmap(const QRectF&, const QPixmap&, const QPointF&) override {}
+    void drawImage(const QRectF&, const QImage&, const QRectF&, Qt::ImageConversionFlags) override {}
+    Type type() const override { return QPaintEngine::User; }
+};
+
+class NullPaintDevice : public QPaintDevice
+{
+public:
+    QPaintEngine* paintEngine() const override { return &mEngine; }
+
+protected:
+    int metric(PaintDeviceMetric metric) const override
+    {
+        switch (metric)
+        {
+            case PdmWidth:
+                return 800;
+            case PdmHeight:
+                return 600;
+            case PdmDpiX:
+            case PdmDpiY:
+            case PdmPhysicalDpiX:
+            case PdmPhysicalDpiY:
+                return 96;
+            case PdmDevicePixelRatioScaled:
+                return int(devicePixelRatioFScale());
+            default:
+                return 1;
+        }
+    }
+
+private:
+    mutable NullPaintEngine mEngine;
+};
+
+//the plottables, with their draw to call outside a replot
+class Graph : public QCPGraph
+{
+public:
+    using QCPGraph::QCPGraph;
+    using QCPGraph::draw;
+};
+
+class Financial : public QCPFinancial
+{
+public:
+    using QCPFinancial::QCPFinancial;
+    using QCPFinancial::draw;
+};
+
+class Bars : public QCPBars
+{
+public:
+    using QCPBars::QCPBars;
+    using QCPBars::draw;
+};
+
+const int BarCount = 20000;
+
+//the allocations countsEveryAllocation makes pass through here, so the compiler can't leave them out
+void* volatile sink = nullptr;
+
+template <class T>
+T* keep(T* pointer)
+{
+    sink = pointer;
+    return static_cast<T*>(sink);
+}
+} // namespace
+
+class TestFrameArena : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void countsEveryAllocation();
+    void drawingAllocatesNothing();
+    void replotsReuseTheBuffers();
+    void selectTestsGiveTheBuffersBack();
+
+private:
+    void setRange(int frame);
+    int drawFrame(int frame);
+
+    QCustomPlot* mPlot = nullptr;
+    Graph* mGraph = nullptr;
+    Financial* mFinancial = nullptr;
+    Bars* mBars = nullptr;
+};
+
+void TestFrameArena::init()
+{
+    mPlot = new QCustomPlot;
+    mPlot->resize(800, 600);
+    mGraph = new Graph(mPlot->xAxis, mPlot->yAxis);
+    mFinancial = new Financial(mPlot->xAxis, mPlot->yAxis);
+    mBars = new Bars(mPlot->xAxis, mPlot->yAxis2);
+    QVector<double> keys, values;
+    QVector<QCPFinancialData> candles;
+    QVector<QCPBarsData> volume;
+    for (int bar = 0; bar < BarCount; bar++)
+    {
+        const double price = 100 + bar % 97 * 0.5;
+        //ten graph points a bar, several per pixel when zoomed out
+        for (int point = 0; point < 10; point++)
+        {
+            keys.append(bar + point * 0.1);
+            values.append(price + point % 3 * 0.25);
+        }
+        candles.append(QCPFinancialData(bar, price, price + 1, price - 1, price + 0.5));
+        volume.append(QCPBarsData(bar, bar % 13 + 1));
+    }
+    mGraph->setData(keys, values, true);
+    mFinancial->data()->set(candles, true);
+    mBars->data()->set(volume, true);
+    mPlot->yAxis->setRange(90, 160);
+    mPlot->yAxis2->setRange(0, 20);
+    setRange(0);
+    mPlot->replot();
+}
+
+void TestFrameArena::cleanup()
+{
+    delete mPlot;
+    mPlot = nullptr;
+}
+
+//zoomed out and in and scrolled, the frames cycle through four ranges
+void TestFrameArena::setRange(int frame)
+{
+    static const QCPRange ranges[] = {
+        QCPRange(0, BarCount), QCPRange(1000, 1200), QCPRange(5000, 9000), QCPRange(15000, 15050)};
+    mPlot->xAxis->setRange(ranges[frame % 4]);
+}
+
+//draws the plottables the way a replot does and returns their allocations
+int TestFrameArena::drawFrame(int frame)
+{
+    setRange(frame);
+    NullPaintDevice device;
+    QCPPainter painter(&device);
+    allocations = 0;
+    counting = true;
+    mGraph->draw(&painter);
+    mFinancial->draw(&painter);
+    mBars->draw(&painter);
+    counting = false;
+    mPlot->frameArena()->reset();
+    return allocations;
+}
+
+void TestFrameArena::countsEveryAllocation()
+{
+    //over-aligned types take the aligned forms of operator new
+    struct alignas(64) Aligned
+    {
+        char bytes[64];
+    };
+    allocations = 0;
+    counting = true;
+    delete keep(new int);
+    delete[] keep(new int[3]);
+    delete keep(new (std::nothrow) int);
+    delete keep(new Aligned);
+    delete[] keep(new Aligned[2]);
+    delete keep(new (std::nothrow) Aligned);
+    counting = false;
+    QCOMPARE(allocations, 6);
+#ifdef __GLIBC__
+    allocations = 0;
+    counting = true;
+    void* pointer = keep(std::malloc(16));
+    pointer = keep(std::realloc(pointer, 32));
+    std::free(pointer);
+    std::free(keep(std::calloc(4, 4)));
+    counting = false;
+    QCOMPARE(allocations, 3);
+#endif
+}
+
+void TestFrameArena::drawingAllocatesNothing()
+{
+#ifndef __GLIBC__
+    QSKIP("malloc, which Qt's containers allocate with, is only counted under glibc");
+#endif
+    for (int frame = 0; frame < 12; frame++)
+    {
+        drawFrame(frame);
+    }
+    for (int frame = 0; frame < 8; frame++)
+    {
+        QCOMPARE(drawFrame(frame), 0);
+        QCOMPARE(mPlot->frameArena()->frameAllocations(), 0);
+    }
+}
+
+void TestFrameArena::replotsReuseTheBuffers()
+{
+    for (int frame = 0; frame < 12; frame++)
+    {
+        setRange(frame);
+        mPlot->replot();
+    }
+    const qint64 allocated = mPlot->frameArena()->allocations();
+    for (int frame = 0; frame < 8; frame++)
+    {
+        setRange(frame);
+        mPlot->replot();
+        QCOMPARE(mPlot->frameArena()->frameAllocations(), 0);
+    }
+    QCOMPARE(mPlot->frameArena()->allocations(), allocated);
+}
+
+void TestFrameArena::selectTestsGiveTheBuffersBack()
+{
+    const QPointF center = mPlot->axisRect()->rect().center();
+    for (int frame = 0; frame < 12; frame++)
+    {
+        setRange(frame);
+        mPlot->replot();
+        mGraph->selectTest(center, false);
+    }
+    //without the buffers taken back, each test between two replots would take new ones
+    const qint64 allocated = mPlot->frameArena()->allocations();
+    for (int frame = 0; frame < 8; frame++)
+    {
+        setRange(frame);
+        for (int test = 0; test < 100; test++)
+        {
+            QVERIFY(mGraph->selectTest(center, false) >= 0);
+        }
+        mPlot->replot();
+        QCOMPARE(mPlot->frameArena()->frameAllocations(), 0);
+    }
+    QCOMPARE(mPlot->frameArena()->allocations(), allocated);
+}
+
+QTEST_MAIN(TestFrameArena)
+#include "tst_framearena.moc"
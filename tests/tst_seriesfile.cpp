@@ -0,0 +1,249 @@
+#include "seriesfile.h"
+
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace
+{
+const double Inf = std::numeric_limits<double>::infinity();
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+//a table of rows of every column type: ascending minute keys with gaps, signed integers with changes of every
+// delta-of-delta width, unsigned integers whose deltas wrap around, and floats with NaN, infinities, denormals and
+// empty cells
+CsvTable everyType(qsizetype rows)
+{
+    std::mt19937_64 random(rows);
+    CsvTable table;
+    table.header = QStringList{"timestamp", "count", "id", "price", "close"};
+    table.keys = table.header;
+    CsvColumn timestamp(CsvColumn::Int64);
+    CsvColumn count(CsvColumn::Int64);
+    CsvColumn id(CsvColumn::UInt64);
+    CsvColumn price(CsvColumn::Float32);
+    CsvColumn close(CsvColumn::Float64);
+    qint64 key = 1700000000;
+    qint64 value = 0;
+    const qint64 changes[] = {0, 1, -64, 63, 255, -256, 2047, -2048, qint64(1) << 31, -(qint64(1) << 40)};
+    for (qsizetype row = 0; row < rows; row++)
+    {
+        key += row % 500 == 499 ? 3600 * 17 : 60;
+        timestamp.appendValue<qint64>(key);
+        value += changes[random() % 10];
+        count.appendValue<qint64>(row % 1000 == 7 ? std::numeric_limits<qint64>::min() : value);
+        if (row % 97 == 5)
+        {
+            id.appendMissing();
+        }
+        else
+        {
+            //around zero and the top of the range, so deltas wrap both ways
+            id.appendValue<quint64>(row % 3 == 0 ? std::numeric_limits<quint64>::max() - row : quint64(row));
+        }
+        const float prices[] = {100.25f, float(NaN), float(Inf), -float(Inf), 1e-40f, -0.0f};
+        price.appendValue<float>(row % 11 < 6 ? prices[row % 11] : 100 + float(random() % 4000) * 0.25f);
+        if (row % 13 == 3)
+        {
+            close.appendMissing();
+        }
+        else
+        {
+            const double closes[] = {NaN, Inf, -Inf, 4.9e-324, -0.0};
+            close.appendValue<double>(row % 17 < 5 ? closes[row % 17] : double(random()) / 3);
+        }
+    }
+    table.columns = {timestamp, count, id, price, close};
+    return table;
+}
+
+//the bytes of a row's value, so NaN and -0.0 compare by their bits
+template <class T>
+QByteArray bits(const CsvColumn& column, qsizetype row)
+{
+    return QByteArray(reinterpret_cast<const char*>(column.constValues<T>() + row), sizeof(T));
+}
+
+void compareColumns(const CsvColumn& read, const CsvColumn& written, qsizetype firstRow = 0)
+{
+    QCOMPARE(read.type(), written.type());
+    for (qsizetype row = 0; row < read.size(); row++)
+    {
+        const qsizetype source = firstRow + row;
+        QCOMPARE(read.isValid(row), written.isValid(source));
+        if (!written.isValid(source))
+        {
+            continue;
+        }
+        switch (written.type())
+        {
+            case CsvColumn::Int64:
+                QCOMPARE(bits<qint64>(read, row), bits<qint64>(written, source));
+                break;
+            case CsvColumn::UInt64:
+                QCOMPARE(bits<quint64>(read, row), bits<quint64>(written, source));
+                break;
+            case CsvColumn::Float32:
+                QCOMPARE(bits<float>(read, row), bits<float>(written, source));
+                break;
+            case CsvColumn::Float64:
+                QCOMPARE(bits<double>(read, row), bits<double>(written, source));
+                break;
+        }
+    }
+}
+
+void compareTables(const CsvTable& read, const CsvTable& written)
+{
+    QCOMPARE(read.keys, written.keys);
+    QCOMPARE(read.rowCount(), written.rowCount());
+    for (qsizetype column = 0; column < written.columns.size(); column++)
+    {
+        compareColumns(read.columns.at(column), written.columns.at(column));
+    }
+}
+} // namespace
+
+class TestSeriesFile : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTripsEveryType();
+    void wordBoundaries();
+    void emptyTable();
+    void keyRange();
+    void projection();
+};
+
+void TestSeriesFile::roundTripsEveryType()
+{
+    //a single row, a block less than full, a full one, one row in a second block and a partial fourth block
+    QTemporaryDir dir;
+    for (qsizetype rows : {qsizetype(1), qsizetype(8191), qsizetype(8192), qsizetype(8193), qsizetype(3 * 8192 + 100)})
+    {
+        const QString path = dir.filePath(QString("rows%1.series").arg(rows));
+        const CsvTable written = everyType(rows);
+        QVERIFY(SeriesFile::write(path, written, 3));
+        QVERIFY(SeriesFile::isSeriesFile(path));
+        for (int threads : {1, 4})
+        {
+            compareTables(SeriesFile::read(path, {}, threads), written);
+        }
+    }
+}
+
+void TestSeriesFile::wordBoundaries()
+{
+    //the streams are written a 64 bit word at a time. The first value of a column fills a word, 64 repeats of
+    // one bit each fill the next, so the widest change after them starts a word, and its 64 bits after the 5 bit
+    // prefix cross into the word after it
+    CsvTable table;
+    table.header = QStringList{"timestamp", "close"};
+    table.keys = table.header;
+    CsvColumn timestamp(CsvColumn::Int64);
+    CsvColumn close(CsvColumn::Float64);
+    for (int row = 0; row < 65; row++)
+    {
+        timestamp.appendValue<qint64>(1700000000);
+        close.appendValue<double>(100.5);
+    }
+    timestamp.appendValue<qint64>(std::numeric_limits<qint64>::max());
+    close.appendValue<double>(-1e300);
+    //a change of exactly 32 bits and one just past it, then the window of the last XOR used again
+    timestamp.appendValue<qint64>(std::numeric_limits<qint64>::max() - (qint64(1) << 31));
+    timestamp.appendValue<qint64>(0);
+    close.appendValue<double>(1e300);
+    close.appendValue<double>(-1e300);
+    for (int row = 0; row < 61; row++)
+    {
+        timestamp.appendValue<qint64>(row);
+        close.appendValue<double>(row % 2 ? 1e300 : -1e300);
+    }
+    table.columns = {timestamp, close};
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("words.series");
+    QVERIFY(SeriesFile::write(path, table, 1));
+    compareTables(SeriesFile::read(path, {}, 1), table);
+
+    //a single value fills exactly one word, which the end of the stream doesn't pad
+    table.columns = {CsvColumn(CsvColumn::Int64), CsvColumn(CsvColumn::Float64)};
+    table.columns[0].appendValue<qint64>(-1);
+    table.columns[1].appendValue<double>(NaN);
+    QVERIFY(SeriesFile::write(path, table, 1));
+    compareTables(SeriesFile::read(path, {}, 1), table);
+}
+
+void TestSeriesFile::emptyTable()
+{
+    CsvTable table;
+    table.header = QStringList{"timestamp", "close"};
+    table.keys = table.header;
+    table.columns = {CsvColumn(CsvColumn::Int64), CsvColumn(CsvColumn::Float64)};
+    QTemporaryDir dir;
+    const QString path = dir.filePath("empty.series");
+    QVERIFY(SeriesFile::write(path, table, 2));
+    const CsvTable read = SeriesFile::read(path, {}, 2);
+    QCOMPARE(read.keys, table.keys);
+    QCOMPARE(read.rowCount(), qsizetype(0));
+}
+
+void TestSeriesFile::keyRange()
+{
+    //four blocks, of which a range returns the whole blocks its keys overlap
+    const CsvTable written = everyType(3 * 8192 + 100);
+    QTemporaryDir dir;
+    const QString path = dir.filePath("range.series");
+    QVERIFY(SeriesFile::write(path, written, 2));
+    const CsvColumn& keys = written.columns.at(0);
+    auto key = [&keys](qsizetype row) { return keys.value(row); };
+
+    SeriesFile::KeyRange inSecond;
+    inSecond.lower = key(8192 + 10);
+    inSecond.upper = key(8192 + 20);
+    CsvTable read = SeriesFile::read(path, {}, 2, inSecond);
+    QCOMPARE(read.rowCount(), qsizetype(8192));
+    for (qsizetype column = 0; column < written.columns.size(); column++)
+    {
+        compareColumns(read.columns.at(column), written.columns.at(column), 8192);
+    }
+
+    //the upper bound is open: a range ending at the first key of the third block leaves it out
+    SeriesFile::KeyRange acrossBlocks;
+    acrossBlocks.lower = key(8191);
+    acrossBlocks.upper = key(2 * 8192);
+    read = SeriesFile::read(path, {}, 2, acrossBlocks);
+    QCOMPARE(read.rowCount(), qsizetype(2 * 8192));
+    compareColumns(read.columns.at(0), keys);
+
+    SeriesFile::KeyRange lastRows;
+    lastRows.lower = key(3 * 8192 + 99);
+    read = SeriesFile::read(path, {}, 2, lastRows);
+    QCOMPARE(read.rowCount(), qsizetype(100));
+    compareColumns(read.columns.at(4), written.columns.at(4), 3 * 8192);
+
+    SeriesFile::KeyRange after;
+    after.lower = key(3 * 8192 + 99) + 1;
+    QCOMPARE(SeriesFile::read(path, {}, 2, after).rowCount(), qsizetype(0));
+}
+
+void TestSeriesFile::projection()
+{
+    const CsvTable written = everyType(8193);
+    QTemporaryDir dir;
+    const QString path = dir.filePath("projection.series");
+    QVERIFY(SeriesFile::write(path, written, 2));
+    const CsvTable read = SeriesFile::read(path, {"close", "id"}, 2);
+    QCOMPARE(read.header, written.header);
+    QCOMPARE(read.keys, QStringList({"id", "close"}));
+    compareColumns(read.columns.at(0), written.columns.at(2));
+    compareColumns(read.columns.at(1), written.columns.at(4));
+}
+
+QTEST_GUILESS_MAIN(TestSeriesFile)
+#include "tst_seriesfile.moc"
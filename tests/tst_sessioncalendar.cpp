@@ -0,0 +1,316 @@
+#include "sessioncalendar.h"
+
+#include <QtTest>
+
+#include <cmath>
+
+namespace
+{
+const double Minute = 60;
+const double Hour = 3600;
+const double Day = 24 * Hour;
+//2024-01-01 00:00:00 UTC, a Monday
+const double Monday = 1704067200;
+//the longest step between two bars of a session, for minute bars MinSessionGap
+const double SessionGap = 30 * Minute;
+
+//minute bars from 14:30 to 21:00 UTC on the weekdays of three weeks, without the Wednesday of the second and with
+// five bars missing in the middle of every Tuesday, a lone bar at noon of the first Saturday, and a week over a year
+// later, so the sessions are spread unevenly
+QVector<double> minuteKeys()
+{
+    QVector<double> keys;
+    for (int week : {0, 1, 2, 58})
+    {
+        for (int weekday = 0; weekday < 6; weekday++)
+        {
+            const int day = week * 7 + weekday;
+            const double midnight = Monday + day * Day;
+            if (day == 5)
+            {
+                keys.append(midnight + 12 * Hour);
+            }
+            if (day == 9 || weekday == 5)
+            {
+                continue;
+            }
+            for (int bar = 0; bar < 390; bar++)
+            {
+                if (weekday == 1 && bar >= 100 && bar < 105)
+                {
+                    continue;
+                }
+                keys.append(midnight + 14.5 * Hour + bar * Minute);
+            }
+        }
+    }
+    return keys;
+}
+
+//the session coordinates of keys worked out bar by bar: a step of at most SessionGap keeps its length, a longer one
+// is a gap and becomes a single bar
+QVector<double> coordsOf(const QVector<double>& keys, double interval)
+{
+    QVector<double> coords;
+    for (qsizetype i = 0; i < keys.size(); i++)
+    {
+        const double step = i == 0 ? 0 : keys.at(i) - keys.at(i - 1);
+        coords.append(i == 0 ? keys.at(0) : coords.last() + (step > SessionGap ? interval : step));
+    }
+    return coords;
+}
+
+//the indexes of the keys starting a session
+QVector<qsizetype> sessionStarts(const QVector<double>& keys)
+{
+    QVector<qsizetype> starts;
+    for (qsizetype i = 0; i < keys.size(); i++)
+    {
+        if (i == 0 || keys.at(i) - keys.at(i - 1) > SessionGap)
+        {
+            starts.append(i);
+        }
+    }
+    return starts;
+}
+
+//the conversions are sums and differences of whole seconds, so they are compared exactly and not to QCOMPARE's
+// relative precision, which at these times is a millisecond
+void compareExactly(double actual, double expected)
+{
+    QVERIFY2(actual == expected,
+             qPrintable(QString::number(actual, 'f', 3) + " instead of " + QString::number(expected, 'f', 3)));
+}
+
+//both conversions of sessions give what they give for all, at every key, halfway through its bar and in the gaps
+void compareCalendars(const SessionCalendar& sessions, const SessionCalendar& all, const QVector<double>& keys)
+{
+    QCOMPARE(sessions.size(), all.size());
+    for (double key : keys)
+    {
+        for (double time : {key, key + 30, key + Hour})
+        {
+            compareExactly(sessions.toCoord(time), all.toCoord(time));
+            compareExactly(sessions.toTime(all.toCoord(time)), all.toTime(all.toCoord(time)));
+        }
+    }
+}
+
+//the ticker with the tick vector an axis asks for
+class Ticker : public SessionTicker
+{
+public:
+    using SessionTicker::SessionTicker;
+    using SessionTicker::createTickVector;
+};
+
+//the minute bars of the two days from opensAt to closesAt seconds after utc midnight, from Monday
+QVector<double> twoDays(double opensAt, double closesAt)
+{
+    QVector<double> keys;
+    for (int day = 0; day < 2; day++)
+    {
+        for (double time = opensAt; time < closesAt; time += Minute)
+        {
+            keys.append(Monday + day * Day + time);
+        }
+    }
+    return keys;
+}
+
+//the times of ticks over the coordinates of sessions from the first key to the last
+QVector<double> tickTimes(const QSharedPointer<SessionCalendar>& sessions, const QVector<double>& keys, double step)
+{
+    Ticker ticker(sessions);
+    QVector<double> times;
+    const QCPRange range(sessions->toCoord(keys.first()), sessions->toCoord(keys.last()));
+    for (double tick : ticker.createTickVector(step, range))
+    {
+        times.append(sessions->toTime(tick));
+    }
+    return times;
+}
+} // namespace
+
+class TestSessionCalendar : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrips();
+    void gapsMapToTheNextSession();
+    void beforeAndAfterTheSessions();
+    void extendWithinAndBehindTheLastSession();
+    void singleKey();
+    void tickerMovesTicksToSessionStarts();
+    void tickerKeepsRoundCoordsOverLongGaps();
+};
+
+void TestSessionCalendar::roundTrips()
+{
+    const QVector<double> keys = minuteKeys();
+    const QVector<double> coords = coordsOf(keys, Minute);
+    SessionCalendar sessions;
+    sessions.extend(keys);
+    QCOMPARE(qsizetype(sessions.size()), sessionStarts(keys).size());
+    for (qsizetype i = 0; i < keys.size(); i++)
+    {
+        compareExactly(sessions.toCoord(keys.at(i)), coords.at(i));
+        compareExactly(sessions.toTime(coords.at(i)), keys.at(i));
+        //within the bar, which the session coordinate follows to its end
+        compareExactly(sessions.toCoord(keys.at(i) + 30.5), coords.at(i) + 30.5);
+        compareExactly(sessions.toTime(coords.at(i) + 59.5), keys.at(i) + 59.5);
+    }
+}
+
+void TestSessionCalendar::gapsMapToTheNextSession()
+{
+    const QVector<double> keys = minuteKeys();
+    const QVector<double> coords = coordsOf(keys, Minute);
+    SessionCalendar sessions;
+    sessions.extend(keys);
+    const QVector<qsizetype> starts = sessionStarts(keys);
+    for (qsizetype start : starts.mid(1))
+    {
+        //the last bar of the session before ends a minute after its key, the gap from there to the next key
+        const double end = keys.at(start - 1) + Minute;
+        compareExactly(sessions.toCoord(end - 1), coords.at(start - 1) + 59);
+        for (double time : {end, (end + keys.at(start)) / 2, keys.at(start) - 1})
+        {
+            compareExactly(sessions.toCoord(time), coords.at(start));
+        }
+        //the end of one session has the coordinate the next one starts at, which is given back as the start
+        compareExactly(coords.at(start - 1) + Minute, coords.at(start));
+        compareExactly(sessions.toTime(coords.at(start)), keys.at(start));
+        compareExactly(sessions.toTime(coords.at(start) - 1), end - 1);
+    }
+}
+
+void TestSessionCalendar::beforeAndAfterTheSessions()
+{
+    const QVector<double> keys = minuteKeys();
+    const QVector<double> coords = coordsOf(keys, Minute);
+    SessionCalendar sessions;
+    sessions.extend(keys);
+    //over the first session the coordinate is the time, and it continues the first and last sessions past them
+    for (double before : {1.0, Hour, 400 * Day})
+    {
+        compareExactly(sessions.toCoord(keys.first() - before), keys.first() - before);
+        compareExactly(sessions.toTime(keys.first() - before), keys.first() - before);
+    }
+    for (double after : {1.0, Minute, Hour, 400 * Day})
+    {
+        compareExactly(sessions.toCoord(keys.last() + after), coords.last() + after);
+        compareExactly(sessions.toTime(coords.last() + after), keys.last() + after);
+    }
+}
+
+void TestSessionCalendar::extendWithinAndBehindTheLastSession()
+{
+    const QVector<double> keys = minuteKeys();
+    const QVector<qsizetype> starts = sessionStarts(keys);
+    SessionCalendar all;
+    all.extend(keys);
+    //split in the middle of the first session, at the start of one, after the lone bar, at the gap of over a year
+    // and in the middle of the last session
+    const qsizetype lone = starts.at(5);
+    for (qsizetype split : {qsizetype(200), starts.at(3), lone + 1, starts.at(15), keys.size() - 100})
+    {
+        const QVector<double> loaded = keys.mid(0, split);
+        SessionCalendar sessions;
+        sessions.extend(loaded);
+        const int size = sessions.size();
+        const SessionCalendar before = sessions;
+
+        //rows appended behind the loaded ones, from within the last session and from sessions before it, are part of
+        // the last session and move nothing
+        sessions.extend(keys.mid(split - 3, 3));
+        sessions.extend(keys.mid(0, 5));
+        QCOMPARE(sessions.size(), size);
+        compareCalendars(sessions, before, loaded);
+
+        sessions.extend(keys.mid(split));
+        compareCalendars(sessions, all, keys);
+    }
+}
+
+void TestSessionCalendar::singleKey()
+{
+    //without keys, and with a single one and so no interval, times are their coordinates
+    SessionCalendar sessions;
+    QCOMPARE(sessions.size(), 0);
+    compareExactly(sessions.toCoord(Monday), Monday);
+    compareExactly(sessions.toTime(Monday), Monday);
+    const double open = Monday + 14.5 * Hour;
+    sessions.extend({open});
+    QCOMPARE(sessions.size(), 1);
+    for (double time : {open - Day, open - 1, open, open + 1, open + Minute, open + Day})
+    {
+        compareExactly(sessions.toCoord(time), time);
+        compareExactly(sessions.toTime(time), time);
+    }
+
+    //the keys after it give the interval, and continue the session of the first one or start a new one
+    const QVector<double> keys = {open, open + Minute, open + 2 * Minute, open + Day, open + Day + Minute};
+    SessionCalendar all;
+    all.extend(keys);
+    QCOMPARE(all.size(), 2);
+    sessions.extend(keys.mid(1));
+    compareCalendars(sessions, all, keys);
+    const QVector<double> coords = coordsOf(keys, Minute);
+    for (qsizetype i = 0; i < keys.size(); i++)
+    {
+        compareExactly(sessions.toCoord(keys.at(i)), coords.at(i));
+    }
+}
+
+void TestSessionCalendar::tickerMovesTicksToSessionStarts()
+{
+    //hourly ticks over two days open from 14:30 to 21:00: the round hours of the night all move to the start of the
+    // second day, which keeps the first of them, and the hours before and after the two continue them
+    QVector<double> keys = twoDays(14.5 * Hour, 21 * Hour);
+    QSharedPointer<SessionCalendar> sessions(new SessionCalendar);
+    sessions->extend(keys);
+    QVector<double> expected;
+    for (double hour = 14; hour <= 20; hour++)
+    {
+        expected.append(Monday + hour * Hour);
+    }
+    expected.append(Monday + Day + 14.5 * Hour);
+    for (double hour = 15; hour <= 21; hour++)
+    {
+        expected.append(Monday + Day + hour * Hour);
+    }
+    QCOMPARE(tickTimes(sessions, keys, Hour), expected);
+
+    //closing at 20:15, the start of the second day is a quarter of an hour after the tick at 20:00 and gives way to it
+    keys = twoDays(14.5 * Hour, 20.25 * Hour);
+    sessions.reset(new SessionCalendar);
+    sessions->extend(keys);
+    expected.removeAt(expected.indexOf(Monday + Day + 14.5 * Hour));
+    QCOMPARE(tickTimes(sessions, keys, Hour), expected);
+}
+
+void TestSessionCalendar::tickerKeepsRoundCoordsOverLongGaps()
+{
+    //hourly ticks over the gap of over a year between the third week and the last one would look for a round time
+    // in every hour of it, so they stay at round coordinates. The nights taken out are half hours longer than whole
+    // ones, so these aren't round times
+    const QVector<double> keys = minuteKeys();
+    const qsizetype last = sessionStarts(keys).at(15);
+    QSharedPointer<SessionCalendar> sessions(new SessionCalendar);
+    sessions->extend(keys);
+    Ticker ticker(sessions);
+    const QCPRange range(sessions->toCoord(keys.at(last - 300)), sessions->toCoord(keys.at(last + 300)));
+    QVERIFY(sessions->toTime(range.upper) - sessions->toTime(range.lower) > 1000 * Hour);
+    QVector<double> expected;
+    for (double tick = std::floor(range.lower / Hour) * Hour; tick < range.upper + Hour; tick += Hour)
+    {
+        expected.append(tick);
+    }
+    QCOMPARE(ticker.createTickVector(Hour, range), expected);
+    QVERIFY(std::fmod(sessions->toTime(expected.at(1)), Hour) != 0);
+}
+
+QTEST_GUILESS_MAIN(TestSessionCalendar)
+#include "tst_sessioncalendar.moc"